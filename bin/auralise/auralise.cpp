@@ -0,0 +1,421 @@
+/// Convolve dry recordings with rendered impulse responses.
+///
+/// Every impulse response is applied to every dry input, and the results are
+/// written to an output folder as <ir name>_<input name>.wav.
+/// Jobs are spread over a pool of worker threads.
+///
+/// Impulse responses may have any number of channels (mono, one channel per
+/// capsule, or binaural).
+/// A mono impulse response is applied to every channel of the input, so the
+/// output has as many channels as the input.
+/// Otherwise, the input is mixed down to mono and convolved with every
+/// channel of the impulse response.
+/// If the sample rates differ, the impulse response is resampled to match
+/// the input.
+///
+/// Inputs are streamed through the convolver a block at a time, so memory
+/// use doesn't grow with the length of the input.
+/// With --normalise, the output is spilled to a temporary file until its
+/// peak is known.
+///
+/// With --wisdom, FFT plans are measured rather than estimated, and the
+/// results are kept in the given file so that later runs can reuse them.
+
+#include "audio_file/audio_file.h"
+#include "audio_file/streaming.h"
+
+#include "frequency_domain/partitioned_convolver.h"
+#include "frequency_domain/wisdom.h"
+
+#include "waveguide/config.h"
+
+#include "utilities/scoped_thread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct options final {
+    std::vector<std::string> impulse_responses;
+    std::vector<std::string> inputs;
+    std::string output_folder = ".";
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t block_size = 4096;
+    bool normalise = false;
+    audio_file::bit_depth bit_depth = audio_file::bit_depth::pcm24;
+    std::string wisdom;
+};
+
+void print_usage(std::ostream& os) {
+    os << "usage: auralise --ir <file> [--ir <file>...] "
+          "--input <file> [--input <file>...]\n"
+          "    [--output <folder>] [--threads <n>] [--block-size <n>]\n"
+          "    [--normalise] [--bit-depth 16|24|32|float] "
+          "[--wisdom <file>]\n";
+}
+
+audio_file::bit_depth parse_bit_depth(const std::string& str) {
+    const std::map<std::string, audio_file::bit_depth> depths{
+            {"16", audio_file::bit_depth::pcm16},
+            {"24", audio_file::bit_depth::pcm24},
+            {"32", audio_file::bit_depth::pcm32},
+            {"float", audio_file::bit_depth::float32}};
+    const auto it = depths.find(str);
+    if (it == depths.end()) {
+        throw std::runtime_error{"Unrecognised bit depth: " + str};
+    }
+    return it->second;
+}
+
+options parse_options(int argc, char** argv) {
+    options ret;
+
+    for (auto i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        const auto next = [&] {
+            if (argc <= i + 1) {
+                throw std::runtime_error{"Expected a value after " + arg};
+            }
+            return std::string{argv[++i]};
+        };
+
+        if (arg == "--ir") {
+            ret.impulse_responses.emplace_back(next());
+        } else if (arg == "--input") {
+            ret.inputs.emplace_back(next());
+        } else if (arg == "--output") {
+            ret.output_folder = next();
+        } else if (arg == "--threads") {
+            ret.threads = std::max(1ul, std::stoul(next()));
+        } else if (arg == "--block-size") {
+            ret.block_size = std::max(1ul, std::stoul(next()));
+        } else if (arg == "--normalise") {
+            ret.normalise = true;
+        } else if (arg == "--bit-depth") {
+            ret.bit_depth = parse_bit_depth(next());
+        } else if (arg == "--wisdom") {
+            ret.wisdom = next();
+        } else {
+            throw std::runtime_error{"Unrecognised argument: " + arg};
+        }
+    }
+
+    if (ret.impulse_responses.empty() || ret.inputs.empty()) {
+        throw std::runtime_error{
+                "Expected at least one impulse response and one input."};
+    }
+
+    return ret;
+}
+
+/// The file name without folders or extension.
+std::string stem(const std::string& path) {
+    const auto slash = path.find_last_of("/\\");
+    const auto name =
+            slash == std::string::npos ? path : path.substr(slash + 1);
+    return name.substr(0, name.find_last_of('.'));
+}
+
+struct signal final {
+    std::vector<std::vector<float>> channels;
+    double sample_rate;
+};
+
+signal read(const std::string& path) {
+    const auto file = audio_file::read(path.c_str());
+    signal ret{{}, file.sample_rate};
+    for (const auto& channel : file.signal) {
+        ret.channels.emplace_back(channel.begin(), channel.end());
+    }
+    if (ret.channels.empty() || ret.channels.front().empty()) {
+        throw std::runtime_error{"File is empty: " + path};
+    }
+    return ret;
+}
+
+/// Impulse responses are loaded once, and resampled once for each input
+/// sample rate.
+class impulse_response_cache final {
+public:
+    explicit impulse_response_cache(std::vector<std::string> paths)
+            : paths_{std::move(paths)} {}
+
+    std::vector<std::vector<float>> get(size_t index, double sample_rate) {
+        const std::lock_guard<std::mutex> lock{mutex_};
+
+        const auto key = std::make_pair(index, sample_rate);
+        const auto resampled = resampled_.find(key);
+        if (resampled != resampled_.end()) {
+            return resampled->second;
+        }
+
+        auto original = originals_.find(index);
+        if (original == originals_.end()) {
+            original = originals_.emplace(index, read(paths_[index])).first;
+        }
+
+        auto channels = original->second.channels;
+        if (original->second.sample_rate != sample_rate) {
+            for (auto& channel : channels) {
+                const auto adjusted = wayverb::waveguide::adjust_sampling_rate(
+                        channel, original->second.sample_rate, sample_rate);
+                channel.assign(adjusted.begin(), adjusted.end());
+            }
+        }
+
+        return resampled_.emplace(key, std::move(channels)).first->second;
+    }
+
+private:
+    std::vector<std::string> paths_;
+    std::mutex mutex_;
+    std::map<size_t, signal> originals_;
+    std::map<std::pair<size_t, double>, std::vector<std::vector<float>>>
+            resampled_;
+};
+
+struct file_closer final {
+    void operator()(std::FILE* f) const { std::fclose(f); }
+};
+
+/// Stream the input through the convolver a block at a time.
+/// If `mix_down` is set, the input is mixed to mono and fed to every channel
+/// of the convolver.
+/// Otherwise, each input channel is fed to the convolver channel with the
+/// same index.
+/// `sink` is called with each block of interleaved output, and the number of
+/// frames in it.
+/// Returns the number of frames produced.
+template <typename Sink>
+size_t convolve(audio_file::reader& input,
+                frequency_domain::partitioned_convolver& convolver,
+                bool mix_down,
+                const Sink& sink) {
+    const auto block_size = convolver.get_block_size();
+    const auto in_channels = static_cast<size_t>(input.get_channels());
+    const auto out_channels = convolver.get_channels();
+    const auto total_frames =
+            input.get_frames() + convolver.get_impulse_response_length() - 1;
+
+    std::vector<float> interleaved_in(block_size * in_channels);
+    std::vector<std::vector<float>> in(mix_down ? 1 : in_channels,
+                                       std::vector<float>(block_size));
+    std::vector<float> out(block_size);
+    std::vector<float> interleaved_out(block_size * out_channels);
+
+    convolver.reset();
+
+    for (auto written = 0ul; written < total_frames; written += block_size) {
+        //  Once the input is exhausted, keep going with silence until the
+        //  tail of the impulse response has been written.
+        const auto frames_read =
+                input.read(interleaved_in.data(), block_size);
+        std::fill(interleaved_in.begin() + frames_read * in_channels,
+                  interleaved_in.end(),
+                  0.0f);
+
+        for (auto i = 0ul; i != block_size; ++i) {
+            const auto frame = interleaved_in.data() + i * in_channels;
+            if (mix_down) {
+                in.front()[i] =
+                        std::accumulate(frame, frame + in_channels, 0.0f) /
+                        in_channels;
+            } else {
+                for (auto c = 0ul; c != in_channels; ++c) {
+                    in[c][i] = frame[c];
+                }
+            }
+        }
+
+        for (auto c = 0ul; c != out_channels; ++c) {
+            convolver.process(c, in[mix_down ? 0 : c].data(), out.data());
+            for (auto i = 0ul; i != block_size; ++i) {
+                interleaved_out[i * out_channels + c] = out[i];
+            }
+        }
+
+        sink(interleaved_out.data(),
+             std::min(block_size, total_frames - written));
+    }
+
+    return total_frames;
+}
+
+struct job_result final {
+    size_t samples;
+    double throughput;
+};
+
+job_result auralise(const options& opts,
+                    impulse_response_cache& cache,
+                    size_t ir_index,
+                    const std::string& input_path) {
+    audio_file::reader input{input_path.c_str()};
+    if (!input.get_frames()) {
+        throw std::runtime_error{"File is empty: " + input_path};
+    }
+
+    const auto sample_rate = input.get_sample_rate();
+    const auto ir = cache.get(ir_index, sample_rate);
+
+    //  A multichannel impulse response describes several receivers of one
+    //  source, so the input is mixed down to mono and given to all of them.
+    //  A mono impulse response is applied to each input channel in turn.
+    const auto mix_down = ir.size() != 1;
+    const auto channels =
+            mix_down ? ir.size() : static_cast<size_t>(input.get_channels());
+
+    frequency_domain::partitioned_convolver convolver{
+            opts.block_size,
+            mix_down ? ir : std::vector<std::vector<float>>(channels,
+                                                            ir.front())};
+
+    const auto output_path = opts.output_folder + "/" +
+                             stem(opts.impulse_responses[ir_index]) + "_" +
+                             stem(input_path) + "." +
+                             audio_file::get_extension(audio_file::format::wav);
+
+    audio_file::writer output{output_path.c_str(),
+                              static_cast<int>(channels),
+                              sample_rate,
+                              audio_file::format::wav,
+                              opts.bit_depth};
+
+    float max_magnitude = 0;
+    const auto update_max_magnitude = [&](const float* data, size_t samples) {
+        for (auto i = 0ul; i != samples; ++i) {
+            max_magnitude = std::max(max_magnitude, std::abs(data[i]));
+        }
+    };
+
+    size_t frames = 0;
+
+    if (opts.normalise) {
+        //  The peak isn't known until everything has been convolved, so the
+        //  output is spilled to a temporary file, and scaled on the way
+        //  back out.
+        const std::unique_ptr<std::FILE, file_closer> spill{std::tmpfile()};
+        if (spill == nullptr) {
+            throw std::runtime_error{"Unable to create temporary file."};
+        }
+
+        frames = convolve(
+                input, convolver, mix_down, [&](const float* data, size_t n) {
+                    const auto samples = n * channels;
+                    update_max_magnitude(data, samples);
+                    if (std::fwrite(data,
+                                    sizeof(float),
+                                    samples,
+                                    spill.get()) != samples) {
+                        throw std::runtime_error{
+                                "Failed to write temporary file."};
+                    }
+                });
+
+        const auto factor = max_magnitude ? 1 / max_magnitude : 1.0f;
+
+        std::rewind(spill.get());
+        std::vector<float> buffer(opts.block_size * channels);
+        for (auto done = 0ul; done < frames; done += opts.block_size) {
+            const auto count = std::min(opts.block_size, frames - done);
+            const auto samples = count * channels;
+            if (std::fread(buffer.data(),
+                           sizeof(float),
+                           samples,
+                           spill.get()) != samples) {
+                throw std::runtime_error{"Failed to read temporary file."};
+            }
+            for (auto i = 0ul; i != samples; ++i) {
+                buffer[i] *= factor;
+            }
+            output.write(buffer.data(), count);
+        }
+    } else {
+        frames = convolve(
+                input, convolver, mix_down, [&](const float* data, size_t n) {
+                    update_max_magnitude(data, n * channels);
+                    output.write(data, n);
+                });
+
+        if (1 < max_magnitude) {
+            std::cerr << "warning: " << output_path << " clips (peak "
+                      << max_magnitude << "), consider --normalise\n";
+        }
+    }
+
+    return {frames * channels, convolver.get_throughput()};
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const auto opts = parse_options(argc, argv);
+
+        //  Saved once every worker has finished.
+        const frequency_domain::scoped_wisdom wisdom{opts.wisdom};
+
+        impulse_response_cache cache{opts.impulse_responses};
+
+        const auto jobs = opts.impulse_responses.size() * opts.inputs.size();
+        std::atomic<size_t> next_job{0};
+        std::atomic<size_t> failures{0};
+        std::atomic<size_t> samples{0};
+        std::mutex output_mutex;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        const auto worker = [&] {
+            for (auto job = next_job++; job < jobs; job = next_job++) {
+                const auto ir_index = job / opts.inputs.size();
+                const auto& input = opts.inputs[job % opts.inputs.size()];
+                try {
+                    const auto result = auralise(opts, cache, ir_index, input);
+                    samples += result.samples;
+
+                    const std::lock_guard<std::mutex> lock{output_mutex};
+                    std::cout << opts.impulse_responses[ir_index] << " * "
+                              << input << ": " << result.throughput
+                              << " samples/s\n";
+                } catch (const std::exception& e) {
+                    ++failures;
+                    const std::lock_guard<std::mutex> lock{output_mutex};
+                    std::cerr << opts.impulse_responses[ir_index] << " * "
+                              << input << " failed: " << e.what() << '\n';
+                }
+            }
+        };
+
+        {
+            std::vector<util::scoped_thread> threads;
+            for (auto i = 0ul; i != std::min(opts.threads, jobs); ++i) {
+                threads.emplace_back(std::thread{worker});
+            }
+        }
+
+        const std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+        std::cout << jobs - failures << " of " << jobs << " files written in "
+                  << elapsed.count() << " s ("
+                  << samples / elapsed.count() << " samples/s)\n";
+
+        return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << '\n';
+        print_usage(std::cerr);
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,459 @@
+/// Render a project without the GUI.
+///
+/// Loads a scene and a project config (as saved by the app), runs the
+/// complete engine for every source-receiver pair, and writes the same output
+/// files that the app would.
+/// Progress, and the triangle count of the scene before and after
+/// simplification, are reported on stderr.
+///
+/// A project may be given as a .way folder, or as a separate scene file and
+/// config.json.
+/// If only a scene is given, the default project settings are used, with a
+/// single source and receiver at the centre of the scene.
+///
+/// With --cache, simulation results are kept in the given folder, so that
+/// rendering again with different capsules or output settings doesn't
+/// resimulate.
+/// The folder should only be used for the cache, because the least recently
+/// used entries are deleted from it when it grows too large.
+///
+/// With --trace, the time spent in each phase of the simulation and in each
+/// OpenCL kernel is written to a Chrome trace-event file, which can be opened
+/// in chrome://tracing or Perfetto, and a summary with ray and waveguide
+/// throughput is printed to stderr.
+///
+/// With --wisdom, FFT plans are measured rather than estimated, and the
+/// results are kept in the given file so that later runs can reuse them.
+///
+/// Exits with a nonzero status if rendering fails, or with 128 + the signal
+/// number if it is interrupted by SIGINT or SIGTERM.
+
+#include "combined/model/persistent.h"
+#include "combined/threaded_engine.h"
+
+#include "core/cl/common.h"
+#include "core/geo/box.h"
+#include "core/scene_analytics.h"
+#include "core/scene_data_loader.h"
+#include "core/scene_simplification.h"
+#include "core/serialize/range.h"
+#include "core/serialize/surface.h"
+
+#include "cereal/archives/json.hpp"
+#include "cereal/types/memory.hpp"
+#include "cereal/types/string.hpp"
+#include "cereal/types/tuple.hpp"
+
+#include "frequency_domain/wisdom.h"
+
+#include "utilities/trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+using namespace wayverb;
+
+struct options final {
+    std::string scene;
+    std::string config;
+    std::string output_directory = ".";
+    std::string unique_id;
+    std::string cache_directory;
+    std::string trace;
+    std::string wisdom;
+
+    combined::model::output::sample_rate sample_rate =
+            combined::model::output::sample_rate::sr44_1KHz;
+    audio_file::format format = audio_file::format::wav;
+    audio_file::bit_depth bit_depth = audio_file::bit_depth::pcm24;
+    combined::model::output::layout layout =
+            combined::model::output::layout::file_per_capsule;
+
+    bool cpu = false;
+    int device = -1;
+    bool list_devices = false;
+};
+
+void print_usage(std::ostream& os) {
+    os << "usage: render --project <folder.way>\n"
+          "       render --scene <file> [--config <config.json>]\n"
+          "    [--output <folder>] [--name <prefix>] [--cache <folder>]\n"
+          "    [--sample-rate 44.1|48|88.2|96|192] [--format wav|aif]\n"
+          "    [--bit-depth 16|24|32|float] [--layout capsule|receiver]\n"
+          "    [--cpu | --device <index>] [--list-devices]\n"
+          "    [--trace <file.json>] [--wisdom <file>]\n";
+}
+
+template <typename T>
+T parse_value(const std::map<std::string, T>& values,
+              const std::string& name,
+              const std::string& str) {
+    const auto it = values.find(str);
+    if (it == values.end()) {
+        throw std::runtime_error{"Unrecognised " + name + ": " + str};
+    }
+    return it->second;
+}
+
+options parse_options(int argc, char** argv) {
+    using sample_rate = combined::model::output::sample_rate;
+    using layout = combined::model::output::layout;
+
+    options ret;
+
+    for (auto i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        const auto next = [&] {
+            if (argc <= i + 1) {
+                throw std::runtime_error{"Expected a value after " + arg};
+            }
+            return std::string{argv[++i]};
+        };
+
+        if (arg == "--project") {
+            //  Project folders are laid out as the app saves them.
+            const auto root = next();
+            ret.scene = root + "/model.model";
+            ret.config = root + "/config.json";
+        } else if (arg == "--scene") {
+            ret.scene = next();
+        } else if (arg == "--config") {
+            ret.config = next();
+        } else if (arg == "--output") {
+            ret.output_directory = next();
+        } else if (arg == "--name") {
+            ret.unique_id = next();
+        } else if (arg == "--cache") {
+            ret.cache_directory = next();
+        } else if (arg == "--sample-rate") {
+            ret.sample_rate = parse_value(
+                    std::map<std::string, sample_rate>{
+                            {"44.1", sample_rate::sr44_1KHz},
+                            {"48", sample_rate::sr48KHz},
+                            {"88.2", sample_rate::sr88_2KHz},
+                            {"96", sample_rate::sr96KHz},
+                            {"192", sample_rate::sr192KHz}},
+                    "sample rate",
+                    next());
+        } else if (arg == "--format") {
+            ret.format = parse_value(
+                    std::map<std::string, audio_file::format>{
+                            {"wav", audio_file::format::wav},
+                            {"aif", audio_file::format::aif}},
+                    "format",
+                    next());
+        } else if (arg == "--bit-depth") {
+            ret.bit_depth = parse_value(
+                    std::map<std::string, audio_file::bit_depth>{
+                            {"16", audio_file::bit_depth::pcm16},
+                            {"24", audio_file::bit_depth::pcm24},
+                            {"32", audio_file::bit_depth::pcm32},
+                            {"float", audio_file::bit_depth::float32}},
+                    "bit depth",
+                    next());
+        } else if (arg == "--layout") {
+            ret.layout = parse_value(
+                    std::map<std::string, layout>{
+                            {"capsule", layout::file_per_capsule},
+                            {"receiver", layout::file_per_receiver}},
+                    "layout",
+                    next());
+        } else if (arg == "--cpu") {
+            ret.cpu = true;
+        } else if (arg == "--device") {
+            ret.device = std::stoi(next());
+        } else if (arg == "--list-devices") {
+            ret.list_devices = true;
+        } else if (arg == "--trace") {
+            ret.trace = next();
+        } else if (arg == "--wisdom") {
+            ret.wisdom = next();
+        } else {
+            throw std::runtime_error{"Unrecognised argument: " + arg};
+        }
+    }
+
+    if (ret.scene.empty() && !ret.list_devices) {
+        throw std::runtime_error{"Expected a project or a scene."};
+    }
+
+    if (ret.cpu && ret.device != -1) {
+        throw std::runtime_error{"--cpu and --device are mutually exclusive."};
+    }
+
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Every device on every platform, in a stable order, so that devices can be
+/// selected by index.
+std::vector<cl::Device> get_all_devices() {
+    std::vector<cl::Platform> platforms;
+    cl::Platform::get(&platforms);
+
+    std::vector<cl::Device> ret;
+    for (const auto& platform : platforms) {
+        std::vector<cl::Device> devices;
+        platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
+        ret.insert(ret.end(), devices.begin(), devices.end());
+    }
+    return ret;
+}
+
+void list_devices(std::ostream& os) {
+    const auto devices = get_all_devices();
+    for (auto i = 0ul; i != devices.size(); ++i) {
+        const auto& device = devices[i];
+        const auto is_cpu =
+                device.getInfo<CL_DEVICE_TYPE>() & CL_DEVICE_TYPE_CPU;
+        const auto has_double =
+                device.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE>() !=
+                0u;
+        os << i << ": " << device.getInfo<CL_DEVICE_NAME>() << " ("
+           << (is_cpu ? "cpu" : "gpu")
+           << (has_double ? "" : ", no double precision") << ")\n";
+    }
+}
+
+core::compute_context make_compute_context(const options& opts) {
+    if (opts.cpu) {
+        return core::compute_context{core::device_type::cpu};
+    }
+
+    if (opts.device != -1) {
+        const auto devices = get_all_devices();
+        if (opts.device < 0 || devices.size() <= size_t(opts.device)) {
+            throw std::runtime_error{"No OpenCL device with index " +
+                                     std::to_string(opts.device)};
+        }
+        const auto& device = devices[opts.device];
+        return core::compute_context{cl::Context{device}, device};
+    }
+
+    return core::compute_context{};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Loads the project in the same way as the app.
+struct project final {
+    core::scene_data_loader::scene_data scene_data;
+    combined::model::persistent persistent;
+};
+
+project load_project(const options& opts) {
+    const core::scene_data_loader loader{opts.scene};
+    if (!loader.get_scene_data()) {
+        throw std::runtime_error{"Unable to load scene: " + opts.scene};
+    }
+
+    project ret{*loader.get_scene_data(), {}};
+
+    //  Sensible defaults, in case there's no config.
+    const auto c = centre(
+            core::geo::compute_aabb(ret.scene_data.get_vertices()));
+    (*ret.persistent.sources())[0]->set_position(c);
+    (*ret.persistent.receivers())[0]->set_position(c);
+
+    const auto& surface_strings = ret.scene_data.get_surfaces();
+    *ret.persistent.materials() = combined::model::materials_from_names<1>(
+            begin(surface_strings), end(surface_strings));
+
+    if (!opts.config.empty()) {
+        std::ifstream stream{opts.config};
+        if (!stream.good()) {
+            throw std::runtime_error{"Unable to open config: " + opts.config};
+        }
+        cereal::JSONInputArchive archive{stream};
+        archive(ret.persistent);
+    }
+
+    //  The number of rays depends on the volume, which isn't saved with the
+    //  project.
+    ret.persistent.raytracer()->set_room_volume(
+            core::compute_geometry_analytics(ret.scene_data).volume);
+
+    return ret;
+}
+
+core::gpu_scene_data generate_scene_data(const project& project) {
+    util::aligned::unordered_map<std::string,
+                                 core::surface<core::simulation_bands>>
+            material_map;
+
+    for (const auto& i : *project.persistent.materials()) {
+        material_map[i->get_name()] = i->get_surface();
+    }
+
+    const auto scene =
+            scene_with_extracted_surfaces(project.scene_data, material_map);
+
+    //  Merging flat regions makes the voxel lists and image-source trees
+    //  smaller.
+    auto simplified = core::simplify_scene(scene);
+    std::cerr << "triangles: " << scene.get_triangles().size() << " -> "
+              << simplified.get_triangles().size() << '\n';
+    return simplified;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+volatile std::sig_atomic_t received_signal = 0;
+
+extern "C" void handle_signal(int signal) { received_signal = signal; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Installs the recorder for as long as the guard lives, if a trace file was
+/// requested.
+class trace_guard final {
+public:
+    trace_guard(const std::string& file, util::trace::recorder& r)
+            : enabled_{!file.empty()} {
+        if (enabled_) {
+            util::trace::set_recorder(&r);
+        }
+    }
+
+    trace_guard(const trace_guard&) = delete;
+    trace_guard& operator=(const trace_guard&) = delete;
+
+    ~trace_guard() noexcept {
+        if (enabled_) {
+            util::trace::set_recorder(nullptr);
+        }
+    }
+
+private:
+    bool enabled_;
+};
+
+void write_trace(const std::string& file, util::trace::recorder& r) {
+    std::ofstream os{file};
+    if (!os) {
+        throw std::runtime_error{"Unable to open trace file: " + file};
+    }
+    r.write_chrome_trace(os);
+    r.write_summary(std::cerr);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const auto opts = parse_options(argc, argv);
+
+        if (opts.list_devices) {
+            list_devices(std::cout);
+            return EXIT_SUCCESS;
+        }
+
+        //  Must outlive the engine, which records from its worker threads.
+        util::trace::recorder recorder;
+        const trace_guard guard{opts.trace, recorder};
+
+        //  Saved on the way out, even if rendering fails or is cancelled.
+        const frequency_domain::scoped_wisdom wisdom{opts.wisdom};
+
+        const auto project = load_project(opts);
+
+        combined::model::output output;
+        output.set_output_directory(opts.output_directory);
+        output.set_unique_id(opts.unique_id);
+        output.set_sample_rate(opts.sample_rate);
+        output.set_format(opts.format);
+        output.set_bit_depth(opts.bit_depth);
+        output.set_layout(opts.layout);
+
+        const auto compute_context = make_compute_context(opts);
+
+        combined::complete_engine engine;
+        engine.set_cache_directory(opts.cache_directory);
+
+        std::atomic_bool finished{false};
+        std::mutex error_mutex;
+        std::string error;
+
+        const combined::complete_engine::engine_state_changed::
+                scoped_connection state_connection{
+                        engine.connect_engine_state_changed(
+                                [](auto run, auto runs, auto state, auto p) {
+                                    std::cerr << "\r[" << run + 1 << '/'
+                                              << runs << "] " << std::setw(20)
+                                              << std::left << to_string(state)
+                                              << std::right << std::setw(4)
+                                              << static_cast<int>(p * 100)
+                                              << '%' << std::flush;
+                                })};
+
+        const combined::complete_engine::encountered_error::scoped_connection
+                error_connection{engine.connect_encountered_error(
+                        [&](auto message) {
+                            const std::lock_guard<std::mutex> lock{
+                                    error_mutex};
+                            error = std::move(message);
+                        })};
+
+        const combined::complete_engine::finished::scoped_connection
+                finished_connection{engine.connect_finished(
+                        [&] { finished = true; })};
+
+        std::signal(SIGINT, handle_signal);
+        std::signal(SIGTERM, handle_signal);
+
+        engine.run(compute_context,
+                   generate_scene_data(project),
+                   project.persistent,
+                   output);
+
+        while (!finished) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+            if (received_signal) {
+                engine.cancel();
+            }
+        }
+
+        std::cerr << '\n';
+
+        if (!opts.trace.empty()) {
+            write_trace(opts.trace, recorder);
+        }
+
+        if (received_signal) {
+            std::cerr << "cancelled\n";
+            return 128 + received_signal;
+        }
+
+        {
+            const std::lock_guard<std::mutex> lock{error_mutex};
+            if (!error.empty()) {
+                std::cerr << "error: " << error << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+
+        for (const auto& name :
+             combined::model::compute_all_file_names(project.persistent,
+                                                     output)) {
+            std::cout << name << '\n';
+        }
+
+        return EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << '\n';
+        print_usage(std::cerr);
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "audio_file/audio_file.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace audio_file {
+
+/// Reads interleaved frames from a sound file a chunk at a time, so that the
+/// whole signal never needs to be held in memory.
+class reader final {
+public:
+    explicit reader(const char* fname);
+
+    reader(const reader&) = delete;
+    reader(reader&&) noexcept;
+    reader& operator=(const reader&) = delete;
+    reader& operator=(reader&&) noexcept;
+    ~reader() noexcept;
+
+    int get_channels() const;
+    int get_sample_rate() const;
+
+    /// The total number of frames in the file.
+    size_t get_frames() const;
+
+    /// Read up to `frames` interleaved frames.
+    /// Returns the number of frames read, which is only less than `frames`
+    /// at the end of the file.
+    size_t read(float* interleaved, size_t frames);
+
+    /// Go back to the first frame.
+    void rewind();
+
+private:
+    class impl;
+    std::unique_ptr<impl> pimpl_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Writes interleaved frames to a sound file a chunk at a time, so that the
+/// whole signal never needs to be held in memory.
+class writer final {
+public:
+    writer(const char* fname,
+           int channels,
+           int sr,
+           format format,
+           bit_depth bit_depth);
+
+    writer(const writer&) = delete;
+    writer(writer&&) noexcept;
+    writer& operator=(const writer&) = delete;
+    writer& operator=(writer&&) noexcept;
+    ~writer() noexcept;
+
+    int get_channels() const;
+
+    /// Append `frames` interleaved frames.
+    void write(const float* interleaved, size_t frames);
+
+private:
+    class impl;
+    std::unique_ptr<impl> pimpl_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Collects many output files, and writes them all with a single global
+/// normalisation factor.
+/// Signals are spilled to an anonymous temporary file as soon as they are
+/// added, and only their peak magnitude is kept in memory.
+/// When `write` is called, the spilled signals are streamed back in chunks,
+/// scaled, and written out.
+/// This way, peak memory use is bounded by the largest single signal passed
+/// to `add`, rather than by the total size of all outputs.
+class normalising_writer final {
+public:
+    normalising_writer(int sr, format format, bit_depth bit_depth);
+
+    normalising_writer(const normalising_writer&) = delete;
+    normalising_writer(normalising_writer&&) noexcept;
+    normalising_writer& operator=(const normalising_writer&) = delete;
+    normalising_writer& operator=(normalising_writer&&) noexcept;
+    ~normalising_writer() noexcept;
+
+    /// Queue a file made of `channels` equal-length channels.
+    /// `channel_data` points to one array of `frames` samples per channel.
+    void add(std::string fname,
+             const float* const* channel_data,
+             size_t channels,
+             size_t frames);
+
+    /// It is an iterator over contiguous containers of float, one per channel.
+    template <typename It>
+    void add(std::string fname, It b, It e) {
+        std::vector<const float*> pointers;
+        size_t frames = 0;
+        for (; b != e; ++b) {
+            if (!pointers.empty() && b->size() != frames) {
+                throw std::runtime_error{
+                        "All channels must have equal length."};
+            }
+            frames = b->size();
+            pointers.emplace_back(b->data());
+        }
+        add(std::move(fname), pointers.data(), pointers.size(), frames);
+    }
+
+    size_t get_num_files() const;
+
+    /// The largest absolute sample value seen so far.
+    float get_max_magnitude() const;
+
+    /// Normalise all queued files so that the loudest sample has magnitude
+    /// 1, and write them out.
+    /// Throws if every queued file is silent.
+    void write();
+
+private:
+    class impl;
+    std::unique_ptr<impl> pimpl_;
+};
+
+}  // namespace audio_file
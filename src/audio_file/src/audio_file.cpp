@@ -1,6 +1,6 @@
 #include "audio_file/audio_file.h"
 
-#include "sndfile.hh"
+#include "sndfile_format.h"
 
 #include <fstream>
 #include <iostream>
@@ -9,26 +9,6 @@
 
 namespace audio_file {
 
-namespace {
-
-constexpr auto get_sndfile_format(format f) {
-    switch (f) {
-        case format::wav: return SF_FORMAT_WAV;
-        case format::aif: return SF_FORMAT_AIFF;
-    }
-}
-
-constexpr auto get_sndfile_bit_depth(bit_depth b) {
-    switch (b) {
-        case bit_depth::pcm16: return SF_FORMAT_PCM_16;
-        case bit_depth::pcm24: return SF_FORMAT_PCM_24;
-        case bit_depth::pcm32: return SF_FORMAT_PCM_32;
-        case bit_depth::float32: return SF_FORMAT_FLOAT;
-    }
-}
-
-}  // namespace
-
 template <typename T>
 void write_interleaved(const char* name,
                        const T* data,
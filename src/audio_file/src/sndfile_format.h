@@ -0,0 +1,25 @@
+#pragma once
+
+#include "audio_file/audio_file.h"
+
+#include "sndfile.hh"
+
+namespace audio_file {
+
+constexpr auto get_sndfile_format(format f) {
+    switch (f) {
+        case format::wav: return SF_FORMAT_WAV;
+        case format::aif: return SF_FORMAT_AIFF;
+    }
+}
+
+constexpr auto get_sndfile_bit_depth(bit_depth b) {
+    switch (b) {
+        case bit_depth::pcm16: return SF_FORMAT_PCM_16;
+        case bit_depth::pcm24: return SF_FORMAT_PCM_24;
+        case bit_depth::pcm32: return SF_FORMAT_PCM_32;
+        case bit_depth::float32: return SF_FORMAT_FLOAT;
+    }
+}
+
+}  // namespace audio_file
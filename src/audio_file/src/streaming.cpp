@@ -0,0 +1,254 @@
+#include "audio_file/streaming.h"
+
+#include "sndfile_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace audio_file {
+
+namespace {
+
+/// Frames moved at once when spilling and when writing out.
+constexpr size_t chunk_frames = 1 << 14;
+
+struct file_closer final {
+    void operator()(std::FILE* f) const { std::fclose(f); }
+};
+
+}  // namespace
+
+class reader::impl final {
+public:
+    explicit impl(const char* fname)
+            : file_{fname, SFM_READ} {
+        if (file_.error()) {
+            throw std::runtime_error("Failed to open audio file.");
+        }
+    }
+
+    int get_channels() const { return file_.channels(); }
+    int get_sample_rate() const { return file_.samplerate(); }
+    size_t get_frames() const { return file_.frames(); }
+
+    size_t read(float* interleaved, size_t frames) {
+        const auto count = file_.readf(interleaved, frames);
+        if (count < 0) {
+            throw std::runtime_error("Failed to read audio file.");
+        }
+        return count;
+    }
+
+    void rewind() {
+        if (file_.seek(0, SEEK_SET) != 0) {
+            throw std::runtime_error("Failed to seek in audio file.");
+        }
+    }
+
+private:
+    SndfileHandle file_;
+};
+
+reader::reader(const char* fname)
+        : pimpl_{std::make_unique<impl>(fname)} {}
+
+reader::reader(reader&&) noexcept = default;
+reader& reader::operator=(reader&&) noexcept = default;
+reader::~reader() noexcept = default;
+
+int reader::get_channels() const { return pimpl_->get_channels(); }
+int reader::get_sample_rate() const { return pimpl_->get_sample_rate(); }
+size_t reader::get_frames() const { return pimpl_->get_frames(); }
+
+size_t reader::read(float* interleaved, size_t frames) {
+    return pimpl_->read(interleaved, frames);
+}
+
+void reader::rewind() { pimpl_->rewind(); }
+
+////////////////////////////////////////////////////////////////////////////////
+
+class writer::impl final {
+public:
+    impl(const char* fname,
+         int channels,
+         int sr,
+         format format,
+         bit_depth bit_depth)
+            : channels_{channels} {
+        const auto fmt =
+                get_sndfile_format(format) | get_sndfile_bit_depth(bit_depth);
+        if (!SndfileHandle::formatCheck(fmt, channels, sr)) {
+            throw std::runtime_error(
+                    "Sound file library can't write with those parameters.");
+        }
+
+        file_ = SndfileHandle{fname, SFM_WRITE, fmt, channels, sr};
+        if (file_.error()) {
+            throw std::runtime_error("Failed to open audio file.");
+        }
+    }
+
+    int get_channels() const { return channels_; }
+
+    void write(const float* interleaved, size_t frames) {
+        const auto written = file_.writef(interleaved, frames);
+        if (written != static_cast<sf_count_t>(frames)) {
+            throw std::runtime_error("Failed to write audio file.");
+        }
+    }
+
+private:
+    int channels_;
+    SndfileHandle file_;
+};
+
+writer::writer(const char* fname,
+               int channels,
+               int sr,
+               format format,
+               bit_depth bit_depth)
+        : pimpl_{std::make_unique<impl>(
+                  fname, channels, sr, format, bit_depth)} {}
+
+writer::writer(writer&&) noexcept = default;
+writer& writer::operator=(writer&&) noexcept = default;
+writer::~writer() noexcept = default;
+
+int writer::get_channels() const { return pimpl_->get_channels(); }
+
+void writer::write(const float* interleaved, size_t frames) {
+    pimpl_->write(interleaved, frames);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class normalising_writer::impl final {
+public:
+    impl(int sr, format format, bit_depth bit_depth)
+            : sr_{sr}
+            , format_{format}
+            , bit_depth_{bit_depth}
+            , spill_{std::tmpfile()} {
+        if (spill_ == nullptr) {
+            throw std::runtime_error{"Unable to create temporary file."};
+        }
+    }
+
+    void add(std::string fname,
+             const float* const* channel_data,
+             size_t channels,
+             size_t frames) {
+        if (!channels) {
+            throw std::runtime_error{"Channels must be non-zero."};
+        }
+
+        //  Interleave a chunk at a time, straight into the spill file.
+        std::vector<float> buffer(std::min(frames, chunk_frames) * channels);
+        for (size_t begin = 0; begin < frames; begin += chunk_frames) {
+            const auto count = std::min(chunk_frames, frames - begin);
+            for (size_t i = 0; i != count; ++i) {
+                for (size_t c = 0; c != channels; ++c) {
+                    const auto sample = channel_data[c][begin + i];
+                    max_mag_ = std::max(max_mag_, std::abs(sample));
+                    buffer[i * channels + c] = sample;
+                }
+            }
+            const auto samples = count * channels;
+            if (std::fwrite(buffer.data(),
+                            sizeof(float),
+                            samples,
+                            spill_.get()) != samples) {
+                throw std::runtime_error{"Failed to write temporary file."};
+            }
+        }
+
+        entries_.emplace_back(entry{std::move(fname), channels, frames});
+    }
+
+    size_t get_num_files() const { return entries_.size(); }
+
+    float get_max_magnitude() const { return max_mag_; }
+
+    void write() {
+        if (max_mag_ == 0.0f) {
+            throw std::runtime_error{"All channels are silent."};
+        }
+        const auto factor = 1.0f / max_mag_;
+
+        std::rewind(spill_.get());
+
+        std::vector<float> buffer;
+        for (const auto& i : entries_) {
+            writer out{i.file_name.c_str(),
+                       static_cast<int>(i.channels),
+                       sr_,
+                       format_,
+                       bit_depth_};
+
+            buffer.resize(std::min(i.frames, chunk_frames) * i.channels);
+            for (size_t begin = 0; begin < i.frames; begin += chunk_frames) {
+                const auto count = std::min(chunk_frames, i.frames - begin);
+                const auto samples = count * i.channels;
+                if (std::fread(buffer.data(),
+                               sizeof(float),
+                               samples,
+                               spill_.get()) != samples) {
+                    throw std::runtime_error{"Failed to read temporary file."};
+                }
+                for (auto j = 0u; j != samples; ++j) {
+                    buffer[j] *= factor;
+                }
+                out.write(buffer.data(), count);
+            }
+        }
+    }
+
+private:
+    struct entry final {
+        std::string file_name;
+        size_t channels;
+        size_t frames;
+    };
+
+    int sr_;
+    format format_;
+    bit_depth bit_depth_;
+
+    /// Spilled signals, stored back-to-back in the order they were added.
+    std::unique_ptr<std::FILE, file_closer> spill_;
+    std::vector<entry> entries_;
+    float max_mag_ = 0;
+};
+
+normalising_writer::normalising_writer(int sr,
+                                       format format,
+                                       bit_depth bit_depth)
+        : pimpl_{std::make_unique<impl>(sr, format, bit_depth)} {}
+
+normalising_writer::normalising_writer(normalising_writer&&) noexcept =
+        default;
+normalising_writer& normalising_writer::operator=(
+        normalising_writer&&) noexcept = default;
+normalising_writer::~normalising_writer() noexcept = default;
+
+void normalising_writer::add(std::string fname,
+                             const float* const* channel_data,
+                             size_t channels,
+                             size_t frames) {
+    pimpl_->add(std::move(fname), channel_data, channels, frames);
+}
+
+size_t normalising_writer::get_num_files() const {
+    return pimpl_->get_num_files();
+}
+
+float normalising_writer::get_max_magnitude() const {
+    return pimpl_->get_max_magnitude();
+}
+
+void normalising_writer::write() { pimpl_->write(); }
+
+}  // namespace audio_file
@@ -9,6 +9,7 @@
 
 #include "glm/fwd.hpp"
 
+#include <iosfwd>
 #include <memory>
 
 namespace wayverb {
@@ -84,8 +85,16 @@ public:
     /// Takes attenuator and sample rate.
     virtual util::aligned::vector<float> postprocess(
             const core::attenuator::microphone&, double) const = 0;
+
+    /// Write the simulation results to a binary stream, so that they can be
+    /// postprocessed again later without rerunning the simulation.
+    virtual void save(std::ostream& os) const = 0;
 };
 
+/// Read simulation results previously written by intermediate::save.
+/// Throws if the stream does not hold a compatible intermediate.
+std::unique_ptr<intermediate> load_intermediate(std::istream& is);
+
 //  engine  ////////////////////////////////////////////////////////////////////
 
 class engine final {
@@ -102,6 +111,15 @@ public:
 
     std::unique_ptr<intermediate> run(const std::atomic_bool& keep_going) const;
 
+    /// Replace the scene's surfaces without changing its geometry.
+    /// The waveguide mesh and any image-source paths found by earlier runs
+    /// are kept, so the next run only refits the boundary filters,
+    /// re-evaluates the image-source paths, and reruns the stochastic
+    /// raytracer and the waveguide.
+    /// Throws if the number of surfaces differs from the original scene.
+    void set_surfaces(const util::aligned::vector<
+                      core::surface<core::simulation_bands>>& surfaces);
+
     //  notifications  /////////////////////////////////////////////////////////
 
     /// Args: Current engine state, progress within state.
@@ -131,6 +149,10 @@ public:
 
     const waveguide::voxels_and_mesh& get_voxels_and_mesh() const;
 
+    /// An estimate of the host memory held by the mesh, the scene geometry,
+    /// and any stored image-source paths, in bytes.
+    size_t get_memory_usage() const;
+
 private:
     class impl;
     std::unique_ptr<impl> pimpl_;
@@ -4,11 +4,46 @@
 #include "combined/engine.h"
 #include "combined/forwarding_call.h"
 
+#include "utilities/map_to_vector.h"
+
+#include <future>
 #include <optional>
 
 namespace wayverb {
 namespace combined {
 
+/// Postprocess simulation results for each of a collection of capsules.
+/// Capsules share their capsule-independent postprocessing through the
+/// intermediate, so the remaining per-capsule work runs concurrently.
+template <typename It>
+std::optional<util::aligned::vector<util::aligned::vector<float>>>
+postprocess(const intermediate& intermediate,
+            It b_capsules,
+            It e_capsules,
+            double sample_rate,
+            const std::atomic_bool& keep_going) {
+    auto futures = util::map_to_vector(
+            b_capsules, e_capsules, [&](const auto& capsule) {
+                return std::async(std::launch::async, [&] {
+                    return keep_going ? capsule->postprocess(intermediate,
+                                                             sample_rate)
+                                      : util::aligned::vector<float>{};
+                });
+            });
+
+    util::aligned::vector<util::aligned::vector<float>> channels;
+    channels.reserve(futures.size());
+    for (auto& fut : futures) {
+        channels.emplace_back(fut.get());
+    }
+
+    if (!keep_going) {
+        return std::nullopt;
+    }
+
+    return channels;
+}
+
 /// Similar to `engine` but immediately runs the postprocessing step.
 
 class postprocessing_engine final {
@@ -27,6 +62,14 @@ public:
     postprocessing_engine& operator=(const postprocessing_engine&) = delete;
     postprocessing_engine& operator=(postprocessing_engine&&) noexcept = delete;
 
+    /// Run the simulation, without postprocessing.
+    /// Returns nullptr if the simulation was cancelled.
+    std::unique_ptr<intermediate> simulate(const std::atomic_bool& keep_going);
+
+    /// See engine::set_surfaces.
+    void set_surfaces(const util::aligned::vector<
+                      core::surface<core::simulation_bands>>& surfaces);
+
     template <typename It>
     std::optional<
             util::aligned::vector<util::aligned::vector<float>>>
@@ -34,34 +77,7 @@ public:
         It e_capsules,
         double sample_rate,
         const std::atomic_bool& keep_going) {
-        //  Only add engine listeners if things are listening to this object.
-
-        engine_state_changed::scoped_connection state;
-        if (!engine_state_changed_.empty()) {
-            state = engine_state_changed::scoped_connection{
-                    engine_.connect_engine_state_changed(
-                            make_forwarding_call(engine_state_changed_))};
-        }
-
-        waveguide_node_pressures_changed::scoped_connection pressures;
-        if (!waveguide_node_pressures_changed_.empty()) {
-            pressures = waveguide_node_pressures_changed::scoped_connection{
-                    engine_.connect_waveguide_node_pressures_changed(
-                            make_forwarding_call(
-                                    waveguide_node_pressures_changed_))};
-        }
-
-        raytracer_reflections_generated::scoped_connection reflections;
-        if (!raytracer_reflections_generated_.empty()) {
-            reflections = raytracer_reflections_generated::scoped_connection{
-                    engine_.connect_raytracer_reflections_generated(
-                            make_forwarding_call(
-                                    raytracer_reflections_generated_))};
-        }
-
-        //  Start running.
-
-        const auto intermediate = engine_.run(keep_going);
+        const auto intermediate = simulate(keep_going);
 
         if (intermediate == nullptr) {
             return std::nullopt;
@@ -69,17 +85,8 @@ public:
 
         engine_state_changed_(state::postprocessing, 1.0);
 
-        util::aligned::vector<util::aligned::vector<float>> channels;
-        for (auto it = b_capsules; it != e_capsules && keep_going; ++it) {
-            channels.emplace_back(
-                    (*it)->postprocess(*intermediate, sample_rate));
-        }
-
-        if (!keep_going) {
-            return std::nullopt;
-        }
-
-        return channels;
+        return postprocess(
+                *intermediate, b_capsules, e_capsules, sample_rate, keep_going);
     }
 
     //  notifications
@@ -105,6 +112,9 @@ public:
 
     const waveguide::voxels_and_mesh& get_voxels_and_mesh() const;
 
+    /// See engine::get_memory_usage.
+    size_t get_memory_usage() const;
+
 private:
     engine engine_;
 
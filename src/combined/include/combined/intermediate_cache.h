@@ -0,0 +1,85 @@
+#pragma once
+
+#include "combined/engine.h"
+
+#include <cstdint>
+#include <string>
+
+namespace wayverb {
+
+namespace core {
+struct environment;
+}  // namespace core
+namespace raytracer {
+struct simulation_parameters;
+}  // namespace raytracer
+
+namespace combined {
+namespace model {
+class waveguide;
+}  // namespace model
+
+/// Identifies the inputs to a single source-receiver simulation.
+/// Everything which could change the simulation results contributes to the
+/// key, and nothing which only affects postprocessing (capsules, receiver
+/// orientation, output settings) does.
+std::uint64_t compute_simulation_key(
+        const core::gpu_scene_data& scene_data,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::environment& environment,
+        const raytracer::simulation_parameters& raytracer,
+        const model::waveguide& waveguide);
+
+/// As compute_simulation_key, but ignores the scene's surfaces.
+/// Engines with equal geometry keys differ only in their materials, so an
+/// existing engine can be updated with engine::set_surfaces rather than
+/// being rebuilt.
+std::uint64_t compute_geometry_key(
+        const core::gpu_scene_data& scene_data,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::environment& environment,
+        const raytracer::simulation_parameters& raytracer,
+        const model::waveguide& waveguide);
+
+/// Stores simulation results on disk, with one file per simulation key.
+/// Cached results can be postprocessed again with different capsules or
+/// output settings without rerunning the simulation.
+///
+/// Entries are large (tens of MB each for long responses), and any change to
+/// the scene or parameters produces new ones, so the total size of the cache
+/// is bounded.
+/// Whenever an entry is saved, the least recently used entries are removed
+/// until the cache fits within `max_bytes`.
+class intermediate_cache final {
+public:
+    static constexpr std::uint64_t default_max_bytes = std::uint64_t{1} << 30;
+
+    explicit intermediate_cache(std::string directory,
+                                std::uint64_t max_bytes = default_max_bytes);
+
+    std::string get_path(std::uint64_t key) const;
+
+    /// Returns nullptr if there is no usable entry for the key.
+    /// Entries which are unreadable or were written by an incompatible
+    /// version are treated as missing.
+    /// Loading an entry marks it as recently used.
+    std::unique_ptr<intermediate> load(std::uint64_t key) const;
+
+    /// Throws if the entry can't be written.
+    void save(std::uint64_t key, const intermediate& intermediate) const;
+
+    /// Removes the least recently used entries until the cache is no larger
+    /// than `max_bytes`.
+    /// The entry for `keep` is never removed.
+    /// Files in the directory which aren't cache entries are left alone.
+    void evict(std::uint64_t keep) const;
+
+private:
+    std::string directory_;
+    std::uint64_t max_bytes_;
+};
+
+}  // namespace combined
+}  // namespace wayverb
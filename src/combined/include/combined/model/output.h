@@ -25,6 +25,13 @@ public:
         sr192KHz
     };
 
+    /// How capsule outputs are grouped into files.
+    enum class layout {
+        file_per_capsule = 1,  ///< One mono file per capsule.
+        file_per_receiver,     ///< One multichannel file per receiver, with
+                               ///< a channel per capsule.
+    };
+
     void set_bit_depth(audio_file::bit_depth bit_depth);
     audio_file::bit_depth get_bit_depth() const;
 
@@ -34,6 +41,9 @@ public:
     void set_sample_rate(sample_rate sample_rate);
     sample_rate get_sample_rate() const;
 
+    void set_layout(layout layout);
+    layout get_layout() const;
+
     void set_output_directory(std::string path);
     std::string get_output_directory() const;
 
@@ -47,6 +57,7 @@ private:
         swap(bit_depth_, other.bit_depth_);
         swap(format_, other.format_);
         swap(sample_rate_, other.sample_rate_);
+        swap(layout_, other.layout_);
         swap(output_directory_, other.output_directory_);
         swap(unique_id_, other.unique_id_);
     };
@@ -54,6 +65,7 @@ private:
     audio_file::bit_depth bit_depth_ = audio_file::bit_depth::pcm24;
     audio_file::format format_ = audio_file::format::wav;
     sample_rate sample_rate_ = sample_rate::sr44_1KHz;
+    layout layout_ = layout::file_per_capsule;
 
     std::string output_directory_ = "";
     std::string unique_id_ = "";
@@ -76,6 +88,12 @@ std::string compute_output_path(const source& source,
                                 const capsule& capsule,
                                 const output& output);
 
+/// The path of a multichannel file containing all of a receiver's capsules.
+std::string compute_output_path(const source& source,
+                                const receiver& receiver,
+                                const output& output);
+
+/// Takes the layout of the output into account.
 std::vector<std::string> compute_all_file_names(const persistent& persistent,
                                                 const output& output);
 
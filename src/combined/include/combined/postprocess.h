@@ -6,11 +6,15 @@
 #include "waveguide/config.h"
 #include "waveguide/postprocess.h"
 
+#include "core/attenuator/microphone.h"
+#include "core/attenuator/null.h"
 #include "core/sinc.h"
 #include "core/sum_ranges.h"
 
 #include "audio_file/audio_file.h"
 
+#include <array>
+
 namespace wayverb {
 namespace combined {
 
@@ -30,6 +34,49 @@ auto make_combined_results(
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/// Filters signals either side of the waveguide/raytracer crossover.
+/// Every signal filtered by one crossover uses the same transform length, so
+/// the filtering is linear across them: filtering a sum of signals gives the
+/// same result as summing the filtered signals.
+class crossover final {
+public:
+    /// Wider = more natural-sounding.
+    static constexpr auto default_width = 0.2;
+
+    crossover(size_t fft_length, double cutoff, double width = default_width)
+            : filter_{fft_length}
+            , cutoff_{cutoff}
+            , width_{width} {}
+
+    template <typename In, typename Out>
+    void lopass(In b, In e, Out out) {
+        run(b, e, out, frequency_domain::compute_lopass_magnitude);
+    }
+
+    template <typename In, typename Out>
+    void hipass(In b, In e, Out out) {
+        run(b, e, out, frequency_domain::compute_hipass_magnitude);
+    }
+
+private:
+    template <typename In, typename Out, typename MagFunc>
+    void run(In b, In e, Out out, MagFunc mag_func) {
+        constexpr auto l = 0;
+        filter_.run(b, e, out, [&](auto cplx, auto freq) {
+            return cplx *
+                   static_cast<float>(mag_func(freq, cutoff_, width_, l));
+        });
+    }
+
+    frequency_domain::filter filter_;
+    double cutoff_;
+    double width_;
+};
+
+inline auto crossover_fft_length(size_t signal_length) {
+    return frequency_domain::best_fft_length(signal_length) << 2;
+}
+
 template <typename LoIt, typename HiIt>
 auto crossover_filter(LoIt b_lo,
                       LoIt e_lo,
@@ -37,25 +84,16 @@ auto crossover_filter(LoIt b_lo,
                       HiIt e_hi,
                       double cutoff,
                       double width) {
-    frequency_domain::filter filt{
-            frequency_domain::best_fft_length(std::max(
-                    std::distance(b_lo, e_lo), std::distance(b_hi, e_hi)))
-            << 2};
+    crossover filt{crossover_fft_length(std::max(std::distance(b_lo, e_lo),
+                                                 std::distance(b_hi, e_hi))),
+                   cutoff,
+                   width};
 
-    constexpr auto l = 0;
+    auto lo = std::vector<float>(std::distance(b_lo, e_lo));
+    filt.lopass(b_lo, e_lo, begin(lo));
 
-    const auto run_filter = [&](auto b, auto e, auto mag_func) {
-        auto ret = std::vector<float>(std::distance(b, e));
-        filt.run(b, e, begin(ret), [&](auto cplx, auto freq) {
-            return cplx * static_cast<float>(mag_func(freq, cutoff, width, l));
-        });
-        return ret;
-    };
-
-    const auto lo =
-            run_filter(b_lo, e_lo, frequency_domain::compute_lopass_magnitude);
-    const auto hi =
-            run_filter(b_hi, e_hi, frequency_domain::compute_hipass_magnitude);
+    auto hi = std::vector<float>(std::distance(b_hi, e_hi));
+    filt.hipass(b_hi, e_hi, begin(hi));
 
     return core::sum_vectors(lo, hi);
 }
@@ -69,70 +107,333 @@ struct max_frequency_functor final {
     }
 };
 
-template <typename Histogram, typename Method>
-auto postprocess(const combined_results<Histogram>& input,
-                 const Method& method,
-                 const glm::vec3& source_position,
-                 const glm::vec3& receiver_position,
-                 double room_volume,
-                 const core::environment& environment,
-                 double output_sample_rate) {
-    //  Individual processing.
-    const auto waveguide_processed =
-            waveguide::postprocess(input.waveguide,
-                                   method,
-                                   environment.acoustic_impedance,
-                                   output_sample_rate);
+/// The parts of postprocessing which don't depend on the receiver's
+/// attenuation method.
+/// These are computed once, and then shared between all the capsules of a
+/// receiver, so that each capsule only pays for its own attenuation and
+/// mixdown.
+struct capsule_independent_results final {
+    double output_sample_rate;
+
+    /// A single noise sequence for the stochastic tail, already split into
+    /// bands.
+    /// If there is a waveguide, the bands are also high-passed at the
+    /// crossover, so that the tail is filtered once rather than once per
+    /// capsule.
+    /// Sharing it also means that all capsules see the same noise.
+    raytracer::stochastic::multiband_dirac_sequence dirac_sequence;
+
+    /// Waveguide/raytracer crossover, normalised to the output sample rate.
+    double crossover_cutoff;
+
+    /// The transform length for everything passed through the crossover.
+    size_t crossover_fft_length;
+
+    /// Fade-in for the start of the output, up to the direct-path time.
+    util::aligned::vector<float> window;
+};
 
-    const auto raytracer_processed = raytracer::postprocess(input.raytracer,
-                                                            method,
-                                                            receiver_position,
-                                                            room_volume,
-                                                            environment,
-                                                            output_sample_rate);
+/// An estimate of the longest signal which passes through the crossover.
+/// It doesn't depend on the attenuation method.
+/// The crossover's transforms have four times this much room, so signals
+/// which are slightly longer, such as those delayed by an hrtf ear offset,
+/// still fit.
+template <typename Histogram>
+size_t estimate_crossover_signal_length(
+        const combined_results<Histogram>& input,
+        double speed_of_sound,
+        double output_sample_rate,
+        size_t stochastic_length) {
+    auto ret = stochastic_length;
+
+    for (const auto& band : input.waveguide) {
+        ret = std::max(ret,
+                       static_cast<size_t>(std::ceil(
+                               band.band.directional.size() *
+                               output_sample_rate / band.band.sample_rate)) +
+                               1);
+    }
+
+    const auto& image_source = input.raytracer.image_source;
+    if (!image_source.empty()) {
+        const auto furthest = std::max_element(
+                begin(image_source),
+                end(image_source),
+                [](const auto& a, const auto& b) {
+                    return a.distance < b.distance;
+                })->distance;
+        ret = std::max(
+                ret,
+                static_cast<size_t>(std::ceil(
+                        furthest * output_sample_rate / speed_of_sound)) +
+                        raytracer::get_default_sinc_table().get_width());
+    }
+
+    return ret;
+}
+
+template <typename Histogram>
+auto compute_capsule_independent_results(
+        const combined_results<Histogram>& input,
+        const glm::vec3& source_position,
+        const glm::vec3& receiver_position,
+        double room_volume,
+        const core::environment& environment,
+        double output_sample_rate) {
+    const auto& stochastic = input.raytracer.stochastic;
+    const auto max_seconds =
+            max_size(stochastic.histogram) / stochastic.sample_rate;
 
     const auto make_iterator = [](auto it) {
         return util::make_mapping_iterator_adapter(std::move(it),
                                                    max_frequency_functor{});
     };
 
+    const auto cutoff =
+            input.waveguide.empty()
+                    ? 0.0
+                    : *std::max_element(make_iterator(begin(input.waveguide)),
+                                        make_iterator(end(input.waveguide))) /
+                              output_sample_rate;
+
+    auto dirac_sequence = raytracer::stochastic::split_dirac_sequence(
+            raytracer::stochastic::generate_dirac_sequence(
+                    environment.speed_of_sound,
+                    room_volume,
+                    output_sample_rate,
+                    max_seconds));
+
+    const auto fft_length =
+            crossover_fft_length(estimate_crossover_signal_length(
+                    input,
+                    environment.speed_of_sound,
+                    output_sample_rate,
+                    dirac_sequence.bands.size()));
+
+    //  High-pass each band before it is weighted by the histogram envelope.
+    //  This is the same filter-first approximation as the band splitting.
+    if (!input.waveguide.empty()) {
+        crossover filt{fft_length, cutoff};
+        auto& bands = dirac_sequence.bands;
+        for (auto band = 0ul; band != core::simulation_bands; ++band) {
+            const auto b = core::make_cl_type_iterator(begin(bands), band);
+            const auto e = core::make_cl_type_iterator(end(bands), band);
+            filt.hipass(b, e, b);
+        }
+    }
+
+    const auto window_length = static_cast<size_t>(
+            std::floor(distance(source_position, receiver_position) *
+                       output_sample_rate / environment.speed_of_sound));
+
+    return capsule_independent_results{output_sample_rate,
+                                       std::move(dirac_sequence),
+                                       cutoff,
+                                       fft_length,
+                                       core::left_hanning(window_length)};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// The waveguide and image-source output for a single attenuation method,
+/// after the crossover.
+template <typename Histogram, typename Method>
+util::aligned::vector<float> compute_early(
+        const combined_results<Histogram>& input,
+        const capsule_independent_results& shared,
+        const Method& method,
+        const glm::vec3& receiver_position,
+        const core::environment& environment) {
+    const auto output_sample_rate = shared.output_sample_rate;
+
+    auto image_source_processed = raytracer::image_source::postprocess(
+            begin(input.raytracer.image_source),
+            end(input.raytracer.image_source),
+            method,
+            receiver_position,
+            environment.speed_of_sound,
+            output_sample_rate);
+
     if (input.waveguide.empty()) {
-        return raytracer_processed;
+        return image_source_processed;
     }
 
-    const auto cutoff = *std::max_element(make_iterator(begin(input.waveguide)),
-                                          make_iterator(end(input.waveguide))) /
-                        output_sample_rate;
-    const auto width = 0.2;  //  Wider = more natural-sounding
-    auto filtered = crossover_filter(begin(waveguide_processed),
-                                     end(waveguide_processed),
-                                     begin(raytracer_processed),
-                                     end(raytracer_processed),
-                                     cutoff,
-                                     width);
+    auto waveguide_processed =
+            waveguide::postprocess(input.waveguide,
+                                   method,
+                                   environment.acoustic_impedance,
+                                   output_sample_rate);
+
+    crossover filt{shared.crossover_fft_length, shared.crossover_cutoff};
+    filt.lopass(begin(waveguide_processed),
+                end(waveguide_processed),
+                begin(waveguide_processed));
+    filt.hipass(begin(image_source_processed),
+                end(image_source_processed),
+                begin(image_source_processed));
+
+    return core::sum_vectors(std::move(waveguide_processed),
+                             std::move(image_source_processed));
+}
+
+/// The early output for each linear component of an attenuation method.
+/// Attenuators which are fixed mixes of these components can then be
+/// postprocessed without filtering or resampling anything again.
+using early_components = util::aligned::vector<util::aligned::vector<float>>;
+
+/// It is an iterator over attenuation methods, one per component.
+template <typename Histogram, typename It>
+early_components compute_early_components(
+        const combined_results<Histogram>& input,
+        const capsule_independent_results& shared,
+        It b_components,
+        It e_components,
+        const glm::vec3& receiver_position,
+        const core::environment& environment) {
+    return util::map_to_vector(
+            b_components, e_components, [&](const auto& component) {
+                return compute_early(input,
+                                     shared,
+                                     component,
+                                     receiver_position,
+                                     environment);
+            });
+}
+
+inline auto linear_components(const core::attenuator::null&) {
+    return std::array<core::attenuator::null, 1>{};
+}
+
+inline auto component_weights(const core::attenuator::null&) {
+    return std::array<float, 1>{{1}};
+}
+
+inline auto linear_components(const core::attenuator::microphone&) {
+    using component = core::attenuator::microphone_component;
+    return std::array<component, 4>{
+            {component{0}, component{1}, component{2}, component{3}}};
+}
+
+//  component_weights for microphones is found in core.
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Add the stochastic tail to the early output, and fade in the start.
+template <typename Histogram, typename Method>
+auto finish_postprocessing(const combined_results<Histogram>& input,
+                           const capsule_independent_results& shared,
+                           util::aligned::vector<float> early,
+                           const Method& method,
+                           const core::environment& environment) {
+    auto ret = core::sum_vectors(
+            std::move(early),
+            raytracer::stochastic::postprocessing(
+                    raytracer::stochastic::compute_summed_histogram(
+                            input.raytracer.stochastic, method),
+                    shared.dirac_sequence,
+                    environment.acoustic_impedance));
 
     //  Just in case the start has a bit of a dc offset, we do a sneaky window.
-    const auto window_length =
-            std::min(filtered.size(),
-                     static_cast<size_t>(std::floor(
-                             distance(source_position, receiver_position) *
-                             output_sample_rate / environment.speed_of_sound)));
-
-    if (window_length == 0) {
-        return filtered;
+    if (input.waveguide.empty() || shared.window.empty() || ret.empty()) {
+        return ret;
     }
 
-    const auto window = core::left_hanning(std::floor(window_length));
-
     //  Multiply together the window and filtered signal.
-    std::transform(
-            begin(window),
-            end(window),
-            begin(filtered),
-            begin(filtered),
-            [](auto envelope, auto signal) { return envelope * signal; });
-
-    return filtered;
+    const auto apply_window = [&](const auto& window) {
+        std::transform(begin(window),
+                       end(window),
+                       begin(ret),
+                       begin(ret),
+                       [](auto envelope, auto signal) {
+                           return envelope * signal;
+                       });
+    };
+
+    //  The shared window only fits if the output is long enough.
+    if (shared.window.size() <= ret.size()) {
+        apply_window(shared.window);
+    } else {
+        apply_window(core::left_hanning(ret.size()));
+    }
+
+    return ret;
+}
+
+/// Finish postprocessing for a single capsule, using precomputed shared
+/// results.
+/// This works for any attenuation method, but filters and resamples the
+/// early output for every call.
+/// This is safe to call concurrently for different capsules.
+template <typename Histogram, typename Method>
+auto postprocess(const combined_results<Histogram>& input,
+                 const capsule_independent_results& shared,
+                 const Method& method,
+                 const glm::vec3& receiver_position,
+                 const core::environment& environment) {
+    return finish_postprocessing(
+            input,
+            shared,
+            compute_early(
+                    input, shared, method, receiver_position, environment),
+            method,
+            environment);
+}
+
+/// Finish postprocessing for a single capsule, by mixing the early output
+/// of each component of its attenuation method.
+/// `components` must have been computed from `linear_components(method)`.
+/// This only attenuates the stochastic histogram and weights the shared
+/// Dirac sequence, so it costs much less than the general overload.
+/// This is safe to call concurrently for different capsules.
+template <typename Histogram, typename Method>
+auto postprocess(const combined_results<Histogram>& input,
+                 const capsule_independent_results& shared,
+                 const early_components& components,
+                 const Method& method,
+                 const core::environment& environment) {
+    const auto weights = component_weights(method);
+    if (components.size() != weights.size()) {
+        throw std::runtime_error{
+                "Wrong number of early components for attenuation method."};
+    }
+
+    util::aligned::vector<float> early;
+    for (auto i = 0ul; i != weights.size(); ++i) {
+        const auto& component = components[i];
+        early.resize(std::max(early.size(), component.size()), 0.0f);
+        std::transform(begin(component),
+                       end(component),
+                       begin(early),
+                       begin(early),
+                       [&](auto a, auto b) { return weights[i] * a + b; });
+    }
+
+    return finish_postprocessing(
+            input, shared, std::move(early), method, environment);
+}
+
+/// Postprocess a single capsule on its own.
+/// This shares the stochastic noise and crossover treatment with the
+/// capsule-independent path, so the stochastic tail is high-passed and
+/// band-split before it is weighted.
+template <typename Histogram, typename Method>
+auto postprocess(const combined_results<Histogram>& input,
+                 const Method& method,
+                 const glm::vec3& source_position,
+                 const glm::vec3& receiver_position,
+                 double room_volume,
+                 const core::environment& environment,
+                 double output_sample_rate) {
+    return postprocess(input,
+                       compute_capsule_independent_results(input,
+                                                           source_position,
+                                                           receiver_position,
+                                                           room_volume,
+                                                           environment,
+                                                           output_sample_rate),
+                       method,
+                       receiver_position,
+                       environment);
 }
 
 }  // namespace combined
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "combined/postprocess.h"
+
+#include "raytracer/serialize/simulation_results.h"
+
+#include "waveguide/serialize/bandpass_band.h"
+
+namespace cereal {
+
+template <typename Archive, typename Histogram>
+void serialize(Archive& archive,
+               wayverb::combined::combined_results<Histogram>& m) {
+    archive(make_nvp("raytracer", m.raytracer),
+            make_nvp("waveguide", m.waveguide));
+}
+
+}  // namespace cereal
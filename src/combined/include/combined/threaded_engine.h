@@ -6,15 +6,20 @@
 #include "waveguide/mesh_descriptor.h"
 
 #include <future>
+#include <list>
+#include <mutex>
 
 namespace wayverb {
 namespace combined {
 
 /// Given a scene, and a collection of sources and receivers,
 /// For each source-receiver pair:
-///     Simulate the scene.
+///     Simulate the scene, or reuse cached results if nothing which affects
+///     the simulation has changed.
+///     If only the surfaces have changed, reuse the previous run's mesh and
+///     image-source paths.
 ///     Do microphone post-processing according to the receiver's capsules.
-///     Cache the results.
+///     Spill the results to a temporary file.
 /// Once all outputs have been calculated:
 ///     Do global normalization.
 ///     Write files out.
@@ -36,6 +41,25 @@ public:
 
     void cancel();
 
+    /// Simulation results are cached in this directory, so that changing
+    /// only the capsules or output settings doesn't require resimulation.
+    /// The directory should be dedicated to the cache, because old entries
+    /// are deleted from it to keep its size bounded.
+    /// If empty (the default), results aren't cached.
+    /// Takes effect from the next call to `run`.
+    void set_cache_directory(std::string directory);
+
+    static constexpr size_t default_retained_engine_budget = size_t{1} << 29;
+
+    /// Engines are kept between runs, so that a run which only changes the
+    /// surfaces can reuse their meshes and image-source paths.
+    /// The least recently used engines are released whenever the retained
+    /// engines would hold more than this many bytes, so peak memory use is
+    /// bounded by the budget plus one source-receiver pair.
+    /// A budget of zero keeps nothing between pairs.
+    /// Takes effect from the next call to `run`.
+    void set_retained_engine_budget(size_t bytes);
+
     using engine_state_changed = util::event<size_t, size_t, state, double>;
     using waveguide_node_positions_changed =
             util::event<waveguide::mesh_descriptor>;
@@ -82,6 +106,20 @@ private:
     begun begun_;
     finished finished_;
 
+    std::string cache_directory_;
+    size_t retained_engine_budget_{default_retained_engine_budget};
+
+    /// Engines from earlier pairs and runs, by geometry key, most recently
+    /// used first.
+    /// If only the surfaces change between renders, these are updated
+    /// rather than rebuilt, keeping their meshes and image-source paths.
+    std::list<std::pair<std::uint64_t, std::unique_ptr<postprocessing_engine>>>
+            retained_engines_;
+
+    /// A new run may start before a cancelled one has finished, and runs
+    /// share the retained engines, so only one may proceed at a time.
+    std::mutex run_mutex_;
+
     std::atomic_bool is_running_{false};
     std::atomic_bool keep_going_{true};
 
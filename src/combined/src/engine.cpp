@@ -1,5 +1,6 @@
 #include "combined/engine.h"
 #include "combined/postprocess.h"
+#include "combined/serialize/combined_results.h"
 #include "combined/waveguide_base.h"
 
 #include "waveguide/mesh.h"
@@ -9,14 +10,32 @@
 #include "core/cl/common.h"
 #include "core/environment.h"
 #include "core/reverb_time.h"
+#include "core/scene_analytics.h"
 #include "core/scene_data.h"
+#include "core/serialize/environment.h"
+#include "core/serialize/vec.h"
 
 #include "glm/glm.hpp"
 
+#include "cereal/archives/binary.hpp"
+#include "cereal/types/string.hpp"
+
+#include <mutex>
+
 namespace wayverb {
 namespace combined {
 
 namespace {
+
+/// The histogram type produced by raytracer::canonical.
+using canonical_histogram =
+        raytracer::stochastic::directional_energy_histogram<20, 9>;
+
+/// Identifies intermediate files, and is bumped whenever the layout of the
+/// serialized results changes.
+constexpr auto intermediate_magic = "wayverb intermediate";
+constexpr std::uint32_t intermediate_version = 1;
+
 template <typename Histogram>
 class intermediate_impl final : public intermediate {
 public:
@@ -34,7 +53,7 @@ public:
     util::aligned::vector<float> postprocess(
             const core::attenuator::null& a,
             double sample_rate) const override {
-        return postprocess_impl(a, sample_rate);
+        return postprocess_linear(a, sample_rate, null_components_);
     }
 
     util::aligned::vector<float> postprocess(
@@ -46,20 +65,86 @@ public:
     util::aligned::vector<float> postprocess(
             const core::attenuator::microphone& a,
             double sample_rate) const override {
-        return postprocess_impl(a, sample_rate);
+        return postprocess_linear(a, sample_rate, microphone_components_);
+    }
+
+    void save(std::ostream& os) const override {
+        cereal::BinaryOutputArchive archive{os};
+        archive(std::string{intermediate_magic},
+                intermediate_version,
+                to_process_,
+                source_position_,
+                receiver_position_,
+                room_volume_,
+                environment_);
     }
 
 private:
     template <typename Attenuator>
     auto postprocess_impl(const Attenuator& attenuator,
                           double output_sample_rate) const {
+        const auto shared = get_shared(output_sample_rate);
         return wayverb::combined::postprocess(to_process_,
+                                              *shared,
                                               attenuator,
-                                              source_position_,
                                               receiver_position_,
-                                              room_volume_,
-                                              environment_,
-                                              output_sample_rate);
+                                              environment_);
+    }
+
+    /// For attenuators which are mixes of linear components, the early
+    /// output of each component is computed once, by whichever capsule
+    /// gets here first.
+    template <typename Attenuator>
+    auto postprocess_linear(
+            const Attenuator& attenuator,
+            double output_sample_rate,
+            std::shared_ptr<const early_components>& cached) const {
+        std::shared_ptr<const capsule_independent_results> shared;
+        std::shared_ptr<const early_components> components;
+        {
+            const std::lock_guard<std::mutex> lock{shared_mutex_};
+            shared = update_shared(output_sample_rate);
+            if (cached == nullptr) {
+                const auto linear = linear_components(attenuator);
+                cached = std::make_shared<const early_components>(
+                        compute_early_components(to_process_,
+                                                 *shared,
+                                                 begin(linear),
+                                                 end(linear),
+                                                 receiver_position_,
+                                                 environment_));
+            }
+            components = cached;
+        }
+        return wayverb::combined::postprocess(
+                to_process_, *shared, *components, attenuator, environment_);
+    }
+
+    /// The capsule-independent stage is computed by whichever capsule gets
+    /// here first, and other capsules wait for it.
+    /// Only the most recent output sample rate is kept.
+    std::shared_ptr<const capsule_independent_results> get_shared(
+            double output_sample_rate) const {
+        const std::lock_guard<std::mutex> lock{shared_mutex_};
+        return update_shared(output_sample_rate);
+    }
+
+    /// shared_mutex_ must be held.
+    std::shared_ptr<const capsule_independent_results> update_shared(
+            double output_sample_rate) const {
+        if (shared_ == nullptr ||
+            shared_->output_sample_rate != output_sample_rate) {
+            shared_ = std::make_shared<const capsule_independent_results>(
+                    compute_capsule_independent_results(to_process_,
+                                                        source_position_,
+                                                        receiver_position_,
+                                                        room_volume_,
+                                                        environment_,
+                                                        output_sample_rate));
+            null_components_ = nullptr;
+            microphone_components_ = nullptr;
+        }
+        return shared_;
     }
 
     combined_results<Histogram> to_process_;
@@ -68,8 +153,18 @@ private:
     double room_volume_;
     core::environment environment_;
     engine::engine_state_changed engine_state_changed_;
+
+    mutable std::mutex shared_mutex_;
+    mutable std::shared_ptr<const capsule_independent_results> shared_;
+    mutable std::shared_ptr<const early_components> null_components_;
+    mutable std::shared_ptr<const early_components> microphone_components_;
 };
 
+template <typename T>
+size_t bytes(const util::aligned::vector<T>& v) {
+    return v.size() * sizeof(T);
+}
+
 template <typename Histogram>
 auto make_intermediate_impl_ptr(combined_results<Histogram> to_process,
                                 const glm::vec3& source_position,
@@ -85,6 +180,34 @@ auto make_intermediate_impl_ptr(combined_results<Histogram> to_process,
 
 }  // namespace
 
+std::unique_ptr<intermediate> load_intermediate(std::istream& is) {
+    cereal::BinaryInputArchive archive{is};
+
+    std::string magic;
+    std::uint32_t version{};
+    archive(magic, version);
+    if (magic != intermediate_magic || version != intermediate_version) {
+        throw std::runtime_error{"Not a compatible intermediate file."};
+    }
+
+    combined_results<canonical_histogram> to_process;
+    glm::vec3 source_position;
+    glm::vec3 receiver_position;
+    double room_volume{};
+    core::environment environment;
+    archive(to_process,
+            source_position,
+            receiver_position,
+            room_volume,
+            environment);
+
+    return make_intermediate_impl_ptr(std::move(to_process),
+                                      source_position,
+                                      receiver_position,
+                                      room_volume,
+                                      environment);
+}
+
 class engine::impl final {
 public:
     impl(const core::compute_context& compute_context,
@@ -101,7 +224,7 @@ public:
                       receiver,
                       waveguide->compute_sampling_frequency(),
                       environment.speed_of_sound)}
-            , room_volume_{estimate_volume(voxels_and_mesh_.mesh)}
+            , analytics_{scene_data}
             , source_{source}
             , receiver_{receiver}
             , environment_{environment}
@@ -128,7 +251,8 @@ public:
                 [&](auto step, auto total_steps) {
                     engine_state_changed_(state::running_raytracer,
                                           step / (total_steps - 1.0));
-                });
+                },
+                image_source_paths_);
 
 
         if (!(keep_going && raytracer_output)) {
@@ -178,15 +302,27 @@ public:
 
         engine_state_changed_(state::finishing_waveguide, 1.0);
 
+        static_assert(
+                std::is_same<decltype(raytracer_output->aural.stochastic),
+                             canonical_histogram>::value,
+                "load_intermediate must know the histogram type");
+
         return make_intermediate_impl_ptr(
                 make_combined_results(std::move(raytracer_output->aural),
                                       std::move(*waveguide_output)),
                 source_,
                 receiver_,
-                room_volume_,
+                analytics_.get_volume(),
                 environment_);
     }
 
+    void set_surfaces(const util::aligned::vector<
+                      core::surface<core::simulation_bands>>& surfaces) {
+        analytics_.set_surfaces(surfaces);
+        waveguide::set_surfaces(
+                voxels_and_mesh_, surfaces, environment_.speed_of_sound);
+    }
+
     //  notifications  /////////////////////////////////////////////////////////
 
     engine_state_changed::connection connect_engine_state_changed(
@@ -212,16 +348,44 @@ public:
         return voxels_and_mesh_;
     }
 
+    size_t get_memory_usage() const {
+        const auto& structure = voxels_and_mesh_.mesh.get_structure();
+        const auto& scene = voxels_and_mesh_.voxels.get_scene_data();
+
+        auto ret = bytes(structure.get_condensed_nodes()) +
+                   bytes(structure.get_coefficients()) +
+                   bytes(structure.get_boundary_indices<1>()) +
+                   bytes(structure.get_boundary_indices<2>()) +
+                   bytes(structure.get_boundary_indices<3>()) +
+                   bytes(scene.get_triangles()) + bytes(scene.get_vertices()) +
+                   bytes(scene.get_surfaces());
+
+        if (image_source_paths_) {
+            ret += bytes(*image_source_paths_);
+            for (const auto& path : *image_source_paths_) {
+                ret += bytes(path.reflections);
+            }
+        }
+
+        return ret;
+    }
+
 private:
     core::compute_context compute_context_;
     waveguide::voxels_and_mesh voxels_and_mesh_;
-    double room_volume_;
+    core::scene_analytics<core::surface<core::simulation_bands>> analytics_;
     glm::vec3 source_;
     glm::vec3 receiver_;
     core::environment environment_;
     raytracer::simulation_parameters raytracer_;
     std::unique_ptr<waveguide_base> waveguide_;
 
+    /// Found by the first run, and reused by later runs, which is valid
+    /// because the paths don't depend on the surfaces.
+    mutable std::optional<
+            util::aligned::vector<raytracer::image_source::image_source_path>>
+            image_source_paths_;
+
     engine_state_changed engine_state_changed_;
     waveguide_node_pressures_changed waveguide_node_pressures_changed_;
     raytracer_reflections_generated raytracer_reflections_generated_;
@@ -251,6 +415,12 @@ std::unique_ptr<intermediate> engine::run(
     return pimpl_->run(keep_going);
 }
 
+void engine::set_surfaces(
+        const util::aligned::vector<core::surface<core::simulation_bands>>&
+                surfaces) {
+    pimpl_->set_surfaces(surfaces);
+}
+
 engine::engine_state_changed::connection engine::connect_engine_state_changed(
         engine_state_changed::callback_type callback) {
     return pimpl_->connect_engine_state_changed(std::move(callback));
@@ -273,5 +443,7 @@ const waveguide::voxels_and_mesh& engine::get_voxels_and_mesh() const {
     return pimpl_->get_voxels_and_mesh();
 }
 
+size_t engine::get_memory_usage() const { return pimpl_->get_memory_usage(); }
+
 }  // namespace combined
 }  // namespace wayverb
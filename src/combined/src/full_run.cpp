@@ -20,6 +20,44 @@ postprocessing_engine::postprocessing_engine(
                   raytracer,
                   std::move(waveguide)} {}
 
+std::unique_ptr<intermediate> postprocessing_engine::simulate(
+        const std::atomic_bool& keep_going) {
+    //  Only add engine listeners if things are listening to this object.
+
+    engine_state_changed::scoped_connection state;
+    if (!engine_state_changed_.empty()) {
+        state = engine_state_changed::scoped_connection{
+                engine_.connect_engine_state_changed(
+                        make_forwarding_call(engine_state_changed_))};
+    }
+
+    waveguide_node_pressures_changed::scoped_connection pressures;
+    if (!waveguide_node_pressures_changed_.empty()) {
+        pressures = waveguide_node_pressures_changed::scoped_connection{
+                engine_.connect_waveguide_node_pressures_changed(
+                        make_forwarding_call(
+                                waveguide_node_pressures_changed_))};
+    }
+
+    raytracer_reflections_generated::scoped_connection reflections;
+    if (!raytracer_reflections_generated_.empty()) {
+        reflections = raytracer_reflections_generated::scoped_connection{
+                engine_.connect_raytracer_reflections_generated(
+                        make_forwarding_call(
+                                raytracer_reflections_generated_))};
+    }
+
+    //  Start running.
+
+    return engine_.run(keep_going);
+}
+
+void postprocessing_engine::set_surfaces(
+        const util::aligned::vector<core::surface<core::simulation_bands>>&
+                surfaces) {
+    engine_.set_surfaces(surfaces);
+}
+
 postprocessing_engine::engine_state_changed::connection
 postprocessing_engine::connect_engine_state_changed(
         engine_state_changed::callback_type callback) {
@@ -45,5 +83,9 @@ const waveguide::voxels_and_mesh& postprocessing_engine::get_voxels_and_mesh()
     return engine_.get_voxels_and_mesh();
 }
 
+size_t postprocessing_engine::get_memory_usage() const {
+    return engine_.get_memory_usage();
+}
+
 }  // namespace combined
 }  // namespace wayverb
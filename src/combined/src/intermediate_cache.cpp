@@ -0,0 +1,280 @@
+#include "combined/intermediate_cache.h"
+#include "combined/model/waveguide.h"
+
+#include "raytracer/simulation_parameters.h"
+
+#include "core/cl/scene_structs.h"
+#include "core/environment.h"
+
+#include "utilities/hash.h"
+#include "utilities/string_builder.h"
+
+#include "glm/glm.hpp"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace wayverb {
+namespace combined {
+
+namespace {
+
+using hasher = util::fnv1a_hasher;
+
+constexpr auto entry_prefix = ".wayverb_cache.";
+constexpr auto entry_suffix = ".bin";
+
+bool is_entry_name(const std::string& name) {
+    const auto prefix = std::strlen(entry_prefix);
+    const auto suffix = std::strlen(entry_suffix);
+    return prefix + suffix < name.size() &&
+           name.compare(0, prefix, entry_prefix) == 0 &&
+           name.compare(name.size() - suffix, suffix, entry_suffix) == 0;
+}
+
+struct entry final {
+    std::string path;
+    std::uint64_t bytes;
+    time_t last_used;
+};
+
+/// Returns an empty list if the directory can't be read.
+std::vector<entry> list_entries(const std::string& directory) {
+    struct close_directory final {
+        void operator()(DIR* d) const { closedir(d); }
+    };
+    const std::unique_ptr<DIR, close_directory> dir{opendir(directory.c_str())};
+    if (!dir) {
+        return {};
+    }
+
+    std::vector<entry> ret;
+    while (const auto item = readdir(dir.get())) {
+        const std::string name{item->d_name};
+        if (!is_entry_name(name)) {
+            continue;
+        }
+        //  TODO platform-dependent, Windows path behaviour is different.
+        auto path = util::build_string(directory, '/', name);
+        struct stat info {};
+        if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+            ret.emplace_back(entry{std::move(path),
+                                   static_cast<std::uint64_t>(info.st_size),
+                                   info.st_mtime});
+        }
+    }
+    return ret;
+}
+
+void add(hasher& h, const glm::vec3& v) {
+    h.add(v.x);
+    h.add(v.y);
+    h.add(v.z);
+}
+
+void add(hasher& h, const cl_float3& v) {
+    //  The fourth component is padding, and may hold anything.
+    h.add(v.s[0]);
+    h.add(v.s[1]);
+    h.add(v.s[2]);
+}
+
+void add(hasher& h, const core::bands_type& v) {
+    for (const auto& i : v.s) {
+        h.add(i);
+    }
+}
+
+void add_geometry(hasher& h, const core::gpu_scene_data& scene_data) {
+    h.add(scene_data.get_triangles().size());
+    for (const auto& i : scene_data.get_triangles()) {
+        h.add(i.surface);
+        h.add(i.v0);
+        h.add(i.v1);
+        h.add(i.v2);
+    }
+
+    h.add(scene_data.get_vertices().size());
+    for (const auto& i : scene_data.get_vertices()) {
+        add(h, i);
+    }
+
+    //  Surfaces are referred to by index, so their number is part of the
+    //  geometry, even though their values aren't.
+    h.add(scene_data.get_surfaces().size());
+}
+
+void add_surfaces(hasher& h, const core::gpu_scene_data& scene_data) {
+    for (const auto& i : scene_data.get_surfaces()) {
+        add(h, i.absorption);
+        add(h, i.scattering);
+    }
+}
+
+void add(hasher& h, const model::waveguide& waveguide) {
+    switch (waveguide.get_mode()) {
+        case model::waveguide::mode::single: {
+            const auto params = waveguide.single_band().item()->get();
+            h.add(0);
+            h.add(params.cutoff);
+            h.add(params.usable_portion);
+            break;
+        }
+        case model::waveguide::mode::multiple: {
+            const auto params = waveguide.multiple_band().item()->get();
+            h.add(1);
+            h.add(params.bands);
+            h.add(params.cutoff);
+            h.add(params.usable_portion);
+            break;
+        }
+    }
+}
+
+void add_parameters(hasher& h,
+                    const glm::vec3& source,
+                    const glm::vec3& receiver,
+                    const core::environment& environment,
+                    const raytracer::simulation_parameters& raytracer,
+                    const model::waveguide& waveguide) {
+    add(h, source);
+    add(h, receiver);
+    h.add(environment.speed_of_sound);
+    h.add(environment.acoustic_impedance);
+    h.add(raytracer.rays);
+    h.add(raytracer.maximum_image_source_order);
+    h.add(raytracer.receiver_radius);
+    h.add(raytracer.histogram_sample_rate);
+    add(h, waveguide);
+}
+
+}  // namespace
+
+std::uint64_t compute_simulation_key(
+        const core::gpu_scene_data& scene_data,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::environment& environment,
+        const raytracer::simulation_parameters& raytracer,
+        const model::waveguide& waveguide) {
+    hasher h;
+    add_geometry(h, scene_data);
+    add_surfaces(h, scene_data);
+    add_parameters(h, source, receiver, environment, raytracer, waveguide);
+    return h.get();
+}
+
+std::uint64_t compute_geometry_key(
+        const core::gpu_scene_data& scene_data,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::environment& environment,
+        const raytracer::simulation_parameters& raytracer,
+        const model::waveguide& waveguide) {
+    hasher h;
+    add_geometry(h, scene_data);
+    add_parameters(h, source, receiver, environment, raytracer, waveguide);
+    return h.get();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+intermediate_cache::intermediate_cache(std::string directory,
+                                       std::uint64_t max_bytes)
+        : directory_{std::move(directory)}
+        , max_bytes_{max_bytes} {}
+
+std::string intermediate_cache::get_path(std::uint64_t key) const {
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key;
+    //  TODO platform-dependent, Windows path behaviour is different.
+    return util::build_string(
+            directory_, '/', entry_prefix, name.str(), entry_suffix);
+}
+
+std::unique_ptr<intermediate> intermediate_cache::load(
+        std::uint64_t key) const {
+    const auto path = get_path(key);
+    std::ifstream is{path, std::ios::binary};
+    if (!is.good()) {
+        return nullptr;
+    }
+
+    try {
+        //  Guard against the (unlikely) case of a file name collision.
+        std::uint64_t stored_key{};
+        is.read(reinterpret_cast<char*>(&stored_key), sizeof(stored_key));
+        if (!is.good() || stored_key != key) {
+            return nullptr;
+        }
+        auto ret = load_intermediate(is);
+
+        //  The modification time doubles as the last-used time for eviction.
+        utime(path.c_str(), nullptr);
+        return ret;
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+void intermediate_cache::save(std::uint64_t key,
+                              const intermediate& intermediate) const {
+    const auto path = get_path(key);
+
+    //  Write to a temporary file and then move it into place, so that a
+    //  cancelled or failed write never leaves a truncated entry behind.
+    const auto temporary = path + ".tmp";
+    {
+        std::ofstream os{temporary, std::ios::binary};
+        os.write(reinterpret_cast<const char*>(&key), sizeof(key));
+        intermediate.save(os);
+        if (!os.good()) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error{"Unable to write intermediate cache."};
+        }
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str())) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error{"Unable to write intermediate cache."};
+    }
+
+    evict(key);
+}
+
+void intermediate_cache::evict(std::uint64_t keep) const {
+    auto entries = list_entries(directory_);
+
+    std::uint64_t total = 0;
+    for (const auto& i : entries) {
+        total += i.bytes;
+    }
+
+    //  Oldest first.
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.last_used < b.last_used;
+    });
+
+    const auto kept = get_path(keep);
+    for (const auto& i : entries) {
+        if (total <= max_bytes_) {
+            break;
+        }
+        if (i.path != kept && std::remove(i.path.c_str()) == 0) {
+            total -= i.bytes;
+        }
+    }
+}
+
+}  // namespace combined
+}  // namespace wayverb
@@ -28,6 +28,13 @@ void output::set_format(audio_file::format format) {
 
 audio_file::format output::get_format() const { return format_; }
 
+void output::set_layout(layout layout) {
+    layout_ = layout;
+    notify();
+}
+
+output::layout output::get_layout() const { return layout_; }
+
 void output::set_output_directory(std::string path) {
     output_directory_ = std::move(path);
     notify();
@@ -44,9 +51,11 @@ std::string output::get_unique_id() const { return unique_id_; }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
 std::string compute_output_path(const source& source,
                                 const receiver& receiver,
-                                const capsule& capsule,
+                                const capsule* capsule,
                                 const output& output) {
     //  TODO platform-dependent, Windows path behaviour is different.
     return util::build_string(
@@ -58,20 +67,42 @@ std::string compute_output_path(const source& source,
             source.get_name().c_str(),
             ".r_",
             receiver.get_name().c_str(),
-            ".c_",
-            capsule.get_name().c_str(),
+            (capsule ? ".c_" + capsule->get_name() : std::string{}),
             '.',
             audio_file::get_extension(output.get_format()));
 }
 
+}  // namespace
+
+std::string compute_output_path(const source& source,
+                                const receiver& receiver,
+                                const capsule& capsule,
+                                const output& output) {
+    return compute_output_path(source, receiver, &capsule, output);
+}
+
+std::string compute_output_path(const source& source,
+                                const receiver& receiver,
+                                const output& output) {
+    return compute_output_path(source, receiver, nullptr, output);
+}
+
 std::vector<std::string> compute_all_file_names(const persistent& persistent,
                                                 const output& output) {
     std::vector<std::string> ret;
     for (const auto& source : *persistent.sources()) {
         for (const auto& receiver : *persistent.receivers()) {
-            for (const auto& capsule : *receiver.item()->capsules()) {
-                ret.emplace_back(compute_output_path(
-                        *source, *receiver, *capsule, output));
+            switch (output.get_layout()) {
+                case output::layout::file_per_capsule:
+                    for (const auto& capsule : *receiver.item()->capsules()) {
+                        ret.emplace_back(compute_output_path(
+                                *source, *receiver, *capsule, output));
+                    }
+                    break;
+                case output::layout::file_per_receiver:
+                    ret.emplace_back(
+                            compute_output_path(*source, *receiver, output));
+                    break;
             }
         }
     }
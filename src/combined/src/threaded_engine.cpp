@@ -1,34 +1,24 @@
 #include "combined/threaded_engine.h"
 #include "combined/forwarding_call.h"
+#include "combined/intermediate_cache.h"
 #include "combined/validate_placements.h"
 #include "combined/waveguide_base.h"
 
 #include "waveguide/config.h"
 
-#include "core/dsp_vector_ops.h"
 #include "core/environment.h"
 
 #include "waveguide/mesh.h"
 
-#include "audio_file/audio_file.h"
+#include "audio_file/streaming.h"
 
-namespace wayverb {
-namespace combined {
-namespace {
-
-struct max_mag_functor final {
-    template <typename T>
-    auto operator()(const T& t) const {
-        return core::max_mag(t.data);
-    }
-};
+#include "utilities/trace.h"
 
-struct channel_info final {
-    util::aligned::vector<float> data;
-    std::string file_name;
-};
+#include <algorithm>
+#include <optional>
 
-}  // namespace
+namespace wayverb {
+namespace combined {
 
 std::unique_ptr<capsule_base> polymorphic_capsule_model(
         const model::capsule& i, const core::orientation& orientation) {
@@ -57,6 +47,14 @@ complete_engine::~complete_engine() noexcept { cancel(); }
 bool complete_engine::is_running() const { return is_running_; }
 void complete_engine::cancel() { keep_going_ = false; }
 
+void complete_engine::set_cache_directory(std::string directory) {
+    cache_directory_ = std::move(directory);
+}
+
+void complete_engine::set_retained_engine_budget(size_t bytes) {
+    retained_engine_budget_ = bytes;
+}
+
 void complete_engine::run(core::compute_context compute_context,
                           core::gpu_scene_data scene_data,
                           model::persistent persistent,
@@ -81,6 +79,8 @@ void complete_engine::do_run(core::compute_context compute_context,
                              core::gpu_scene_data scene_data,
                              model::persistent persistent,
                              model::output output) {
+    const std::lock_guard<std::mutex> lock{run_mutex_};
+
     try {
         is_running_ = true;
         keep_going_ = true;
@@ -144,7 +144,49 @@ void complete_engine::do_run(core::compute_context compute_context,
         const auto poly_waveguide =
                 polymorphic_waveguide_model(*persistent.waveguide().item());
 
-        std::vector<channel_info> all_channels;
+        //  Rendered channels are spilled to disk as each pair finishes, so
+        //  that memory use doesn't grow with the size of the project.
+        audio_file::normalising_writer writer{
+                static_cast<int>(get_sample_rate(output.get_sample_rate())),
+                output.get_format(),
+                output.get_bit_depth()};
+
+        //  Caching is off unless a directory has been set.
+        std::optional<intermediate_cache> cache;
+        if (!cache_directory_.empty()) {
+            cache.emplace(cache_directory_);
+        }
+
+        //  Release the least recently used engines until the rest fit in
+        //  the budget.
+        const auto trim_retained_engines = [&] {
+            size_t total = 0;
+            auto it = retained_engines_.begin();
+            for (; it != retained_engines_.end(); ++it) {
+                total += it->second->get_memory_usage();
+                if (retained_engine_budget_ < total) {
+                    break;
+                }
+            }
+            retained_engines_.erase(it, retained_engines_.end());
+        };
+
+        //  Find an engine with the given geometry key, and mark it as the
+        //  most recently used.
+        const auto retain_engine = [&](auto key) -> postprocessing_engine* {
+            const auto it = std::find_if(
+                    retained_engines_.begin(),
+                    retained_engines_.end(),
+                    [&](const auto& i) { return i.first == key; });
+            if (it == retained_engines_.end()) {
+                return nullptr;
+            }
+            retained_engines_.splice(
+                    retained_engines_.begin(), retained_engines_, it);
+            return it->second.get();
+        };
+
+        trim_retained_engines();
 
         const auto runs = persistent.sources().item()->size() *
                           persistent.receivers().item()->size();
@@ -160,38 +202,119 @@ void complete_engine::do_run(core::compute_context compute_context,
                       e_receiver = std::end(*persistent.receivers().item());
                  receiver != e_receiver && keep_going_;
                  ++receiver, ++run) {
-                //  Set up an engine to use.
-                postprocessing_engine eng{compute_context,
-                                          scene_data,
-                                          source->item()->get_position(),
-                                          receiver->item()->get_position(),
-                                          environment,
-                                          persistent.raytracer().item()->get(),
-                                          poly_waveguide->clone()};
-
-                //  Send new node position notification.
-                waveguide_node_positions_changed_(
-                        eng.get_voxels_and_mesh().mesh.get_descriptor());
-
-                //  Register callbacks.
-                if (!engine_state_changed_.empty()) {
-                    eng.connect_engine_state_changed([this, runs, run](
-                            auto state, auto progress) {
-                        engine_state_changed_(run, runs, state, progress);
-                    });
+                const auto key = compute_simulation_key(
+                        scene_data,
+                        source->item()->get_position(),
+                        receiver->item()->get_position(),
+                        environment,
+                        persistent.raytracer().item()->get(),
+                        *persistent.waveguide().item());
+
+                const auto geometry_key = compute_geometry_key(
+                        scene_data,
+                        source->item()->get_position(),
+                        receiver->item()->get_position(),
+                        environment,
+                        persistent.raytracer().item()->get(),
+                        *persistent.waveguide().item());
+
+                auto retained = retain_engine(geometry_key);
+
+                //  If nothing which affects the simulation has changed since
+                //  the last run, skip straight to postprocessing.
+                auto intermediate = cache ? cache->load(key) : nullptr;
+
+                if (intermediate == nullptr) {
+                    //  Set up an engine to use.
+                    //  If only the surfaces have changed, the retained engine
+                    //  can be updated rather than rebuilt.
+                    if (retained != nullptr) {
+                        retained->set_surfaces(scene_data.get_surfaces());
+                    } else {
+                        auto built = std::make_unique<postprocessing_engine>(
+                                compute_context,
+                                scene_data,
+                                source->item()->get_position(),
+                                receiver->item()->get_position(),
+                                environment,
+                                persistent.raytracer().item()->get(),
+                                poly_waveguide->clone());
+                        retained = built.get();
+                        retained_engines_.emplace_front(geometry_key,
+                                                        std::move(built));
+                    }
+
+                    auto& eng = *retained;
+
+                    //  Send new node position notification.
+                    waveguide_node_positions_changed_(
+                            eng.get_voxels_and_mesh().mesh.get_descriptor());
+
+                    //  Register callbacks.
+                    //  Retained engines outlive this run, so the connections
+                    //  must not.
+                    using state_connection = postprocessing_engine::
+                            engine_state_changed::scoped_connection;
+                    using pressures_connection = postprocessing_engine::
+                            waveguide_node_pressures_changed::scoped_connection;
+                    using reflections_connection = postprocessing_engine::
+                            raytracer_reflections_generated::scoped_connection;
+
+                    state_connection state_changed;
+                    if (!engine_state_changed_.empty()) {
+                        const auto forward_state = [this, runs, run](
+                                auto state, auto progress) {
+                            engine_state_changed_(run, runs, state, progress);
+                        };
+                        state_changed = state_connection{
+                                eng.connect_engine_state_changed(forward_state)};
+                    }
+
+                    pressures_connection pressures_changed;
+                    if (!waveguide_node_pressures_changed_.empty()) {
+                        pressures_changed = pressures_connection{
+                                eng.connect_waveguide_node_pressures_changed(
+                                        make_forwarding_call(
+                                                waveguide_node_pressures_changed_))};
+                    }
+
+                    reflections_connection reflections_generated;
+                    if (!raytracer_reflections_generated_.empty()) {
+                        reflections_generated = reflections_connection{
+                                eng.connect_raytracer_reflections_generated(
+                                        make_forwarding_call(
+                                                raytracer_reflections_generated_))};
+                    }
+
+                    intermediate = eng.simulate(keep_going_);
+
+                    //  If user cancelled while simulating, intermediate will
+                    //  be null, but we want to exit before throwing an
+                    //  exception.
+                    if (!keep_going_) {
+                        break;
+                    }
+
+                    if (!intermediate) {
+                        throw std::runtime_error{
+                                "Encountered unknown error, causing channel "
+                                "not to be rendered."};
+                    }
+
+                    if (cache) {
+                        try {
+                            cache->save(key, *intermediate);
+                        } catch (const std::exception&) {
+                            //  Failing to cache shouldn't stop the render.
+                        }
+                    }
                 }
 
-                if (!waveguide_node_pressures_changed_.empty()) {
-                    eng.connect_waveguide_node_pressures_changed(
-                            make_forwarding_call(
-                                    waveguide_node_pressures_changed_));
-                }
+                //  The engine for this pair is finished with, so it may be
+                //  released along with any others over the budget.
+                trim_retained_engines();
 
-                if (!raytracer_reflections_generated_.empty()) {
-                    eng.connect_raytracer_reflections_generated(
-                            make_forwarding_call(
-                                    raytracer_reflections_generated_));
-                }
+                engine_state_changed_(run, runs, state::postprocessing, 1.0);
 
                 const auto polymorphic_capsules = util::map_to_vector(
                         std::begin(*receiver->item()->capsules().item()),
@@ -202,16 +325,16 @@ void complete_engine::do_run(core::compute_context compute_context,
                                     receiver->item()->get_orientation());
                         });
 
-                //  Run the simulation, cache the result.
-                auto channel =
-                        eng.run(begin(polymorphic_capsules),
-                                end(polymorphic_capsules),
-                                get_sample_rate(output.get_sample_rate()),
-                                keep_going_);
+                auto channel = [&] {
+                    const util::trace::scope scope{"postprocess"};
+                    return postprocess(
+                            *intermediate,
+                            begin(polymorphic_capsules),
+                            end(polymorphic_capsules),
+                            get_sample_rate(output.get_sample_rate()),
+                            keep_going_);
+                }();
 
-                //  If user cancelled while processing the channel, channel
-                //  will be null, but we want to exit before throwing an
-                //  exception.
                 if (!keep_going_) {
                     break;
                 }
@@ -222,58 +345,55 @@ void complete_engine::do_run(core::compute_context compute_context,
                             "be rendered."};
                 }
 
-                for (size_t i = 0,
-                            e = receiver->item()->capsules().item()->size();
-                     i != e;
-                     ++i) {
-                    all_channels.emplace_back(channel_info{
-                            std::move((*channel)[i]),
-                            compute_output_path(
-                                    *source->item(),
-                                    *receiver->item(),
-                                    *(*receiver->item()->capsules().item())[i]
-                                             .item(),
-                                    output)});
+                const auto& capsules = *receiver->item()->capsules().item();
+
+                switch (output.get_layout()) {
+                    case model::output::layout::file_per_capsule:
+                        for (size_t i = 0, e = capsules.size(); i != e; ++i) {
+                            writer.add(compute_output_path(*source->item(),
+                                                           *receiver->item(),
+                                                           *capsules[i].item(),
+                                                           output),
+                                       &(*channel)[i],
+                                       &(*channel)[i] + 1);
+                        }
+                        break;
+
+                    case model::output::layout::file_per_receiver: {
+                        if (channel->empty()) {
+                            break;
+                        }
+
+                        //  Capsule outputs may differ slightly in length, so
+                        //  pad them to match before interleaving.
+                        const auto frames = std::max_element(
+                                begin(*channel),
+                                end(*channel),
+                                [](const auto& a, const auto& b) {
+                                    return a.size() < b.size();
+                                })->size();
+                        for (auto& i : *channel) {
+                            i.resize(frames, 0.0f);
+                        }
+                        writer.add(compute_output_path(*source->item(),
+                                                       *receiver->item(),
+                                                       output),
+                                   begin(*channel),
+                                   end(*channel));
+                        break;
+                    }
                 }
             }
         }
 
         //  If keep going is false now, then the simulation was cancelled.
         if (keep_going_) {
-            if (all_channels.empty()) {
+            if (!writer.get_num_files()) {
                 throw std::runtime_error{"No channels were rendered."};
             }
 
-            //  Normalize.
-            const auto make_iterator = [](auto it) {
-                return util::make_mapping_iterator_adapter(std::move(it),
-                                                           max_mag_functor{});
-            };
-
-            const auto max_mag =
-                    *std::max_element(make_iterator(begin(all_channels)),
-                                      make_iterator(end(all_channels)));
-
-            if (max_mag == 0.0f) {
-                throw std::runtime_error{"All channels are silent."};
-            }
-
-            const auto factor = 1.0 / max_mag;
-
-            for (auto& channel : all_channels) {
-                for (auto& sample : channel.data) {
-                    sample *= factor;
-                }
-            }
-
-            //  Write out files.
-            for (const auto& i : all_channels) {
-                audio_file::write(i.file_name.c_str(),
-                                  i.data,
-                                  get_sample_rate(output.get_sample_rate()),
-                                  output.get_format(),
-                                  output.get_bit_depth());
-            }
+            //  Normalize and write out files.
+            writer.write();
         }
 
     } catch (const std::exception& e) {
@@ -0,0 +1,152 @@
+#include "combined/intermediate_cache.h"
+#include "combined/model/waveguide.h"
+
+#include "raytracer/simulation_parameters.h"
+
+#include "core/cl/common.h"
+#include "core/environment.h"
+#include "core/geo/box.h"
+
+#include "utilities/string_builder.h"
+
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+
+using namespace wayverb::combined;
+using namespace wayverb::core;
+
+namespace {
+
+const auto scene_data = geo::get_scene_data(
+        geo::box{glm::vec3{0, 0, 0}, glm::vec3{5.56, 3.97, 2.81}},
+        make_surface<simulation_bands>(0.1, 0.1));
+
+constexpr glm::vec3 source{2.09, 2.12, 2.12};
+constexpr glm::vec3 receiver{2.09, 3.08, 0.96};
+constexpr environment env{};
+
+const wayverb::raytracer::simulation_parameters raytracer{1 << 10, 4};
+
+/// Saves a fixed number of bytes, and nothing else.
+class sized_intermediate final : public intermediate {
+public:
+    explicit sized_intermediate(size_t bytes)
+            : bytes_{bytes} {}
+
+    util::aligned::vector<float> postprocess(const attenuator::null&,
+                                             double) const override {
+        return {};
+    }
+    util::aligned::vector<float> postprocess(const attenuator::hrtf&,
+                                             double) const override {
+        return {};
+    }
+    util::aligned::vector<float> postprocess(const attenuator::microphone&,
+                                             double) const override {
+        return {};
+    }
+
+    void save(std::ostream& os) const override {
+        const std::string data(bytes_, '\0');
+        os.write(data.data(), data.size());
+    }
+
+private:
+    size_t bytes_;
+};
+
+bool exists(const std::string& fpath) { return std::ifstream{fpath}.good(); }
+
+}  // namespace
+
+TEST(intermediate_cache, key_is_deterministic) {
+    const model::waveguide waveguide{};
+    ASSERT_EQ(compute_simulation_key(
+                      scene_data, source, receiver, env, raytracer, waveguide),
+              compute_simulation_key(
+                      scene_data, source, receiver, env, raytracer, waveguide));
+}
+
+TEST(intermediate_cache, key_depends_on_simulation_inputs) {
+    const model::waveguide waveguide{};
+    const auto key = compute_simulation_key(
+            scene_data, source, receiver, env, raytracer, waveguide);
+
+    ASSERT_NE(key,
+              compute_simulation_key(scene_data,
+                                     source + glm::vec3{0.1, 0, 0},
+                                     receiver,
+                                     env,
+                                     raytracer,
+                                     waveguide));
+
+    ASSERT_NE(key,
+              compute_simulation_key(scene_data,
+                                     source,
+                                     receiver,
+                                     env,
+                                     wayverb::raytracer::simulation_parameters{
+                                             1 << 11, 4},
+                                     waveguide));
+
+    auto other_scene = scene_data;
+    other_scene.set_surfaces(make_surface<simulation_bands>(0.2, 0.1));
+    ASSERT_NE(key,
+              compute_simulation_key(
+                      other_scene, source, receiver, env, raytracer, waveguide));
+
+    model::waveguide other_waveguide{};
+    other_waveguide.set_mode(model::waveguide::mode::multiple);
+    ASSERT_NE(key,
+              compute_simulation_key(scene_data,
+                                     source,
+                                     receiver,
+                                     env,
+                                     raytracer,
+                                     other_waveguide));
+}
+
+TEST(intermediate_cache, missing_entry) {
+    const intermediate_cache cache{SCRATCH_PATH};
+    ASSERT_EQ(cache.load(0xdeadbeef), nullptr);
+}
+
+TEST(intermediate_cache, eviction) {
+    const auto directory =
+            util::build_string(SCRATCH_PATH, "/intermediate_cache_eviction");
+    mkdir(directory.c_str(), 0755);
+
+    //  Files which aren't cache entries must survive eviction.
+    const auto unrelated = util::build_string(directory, "/output.wav");
+    std::ofstream{unrelated} << "audio";
+
+    //  Each entry is a little larger than this, so only two fit.
+    constexpr auto entry_bytes = 1000;
+    const intermediate_cache cache{directory, 3 * entry_bytes};
+
+    constexpr auto entries = 5;
+    for (auto key = 0; key != entries; ++key) {
+        cache.save(key, sized_intermediate{entry_bytes});
+
+        //  The entry which was just saved is never evicted.
+        ASSERT_TRUE(exists(cache.get_path(key)));
+    }
+
+    auto remaining = 0;
+    for (auto key = 0; key != entries; ++key) {
+        remaining += exists(cache.get_path(key));
+    }
+    ASSERT_EQ(remaining, 2);
+    ASSERT_TRUE(exists(unrelated));
+
+    for (auto key = 0; key != entries; ++key) {
+        std::remove(cache.get_path(key).c_str());
+    }
+    std::remove(unrelated.c_str());
+    rmdir(directory.c_str());
+}
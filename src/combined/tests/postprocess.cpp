@@ -0,0 +1,128 @@
+#include "combined/postprocess.h"
+
+#include "core/conversions.h"
+
+#include "gtest/gtest.h"
+
+#include <random>
+
+using namespace wayverb;
+using namespace wayverb::combined;
+
+namespace {
+
+using histogram_type =
+        raytracer::stochastic::directional_energy_histogram<20, 9>;
+using directional_histogram =
+        raytracer::stochastic::directional_histogram<20, 9>;
+using waveguide_output = waveguide::postprocessor::directional_receiver::output;
+
+constexpr glm::vec3 source_position{1, 0, 0};
+constexpr glm::vec3 receiver_position{0, 0, 0};
+constexpr auto room_volume = 100.0;
+constexpr auto output_sample_rate = 16000.0;
+constexpr core::environment environment{};
+
+auto make_input() {
+    std::mt19937 engine{0};
+    std::uniform_real_distribution<float> dist{-1, 1};
+
+    const auto make_bands = [&] {
+        core::bands_type ret{};
+        for (auto& i : ret.s) {
+            i = 0.5f + 0.5f * dist(engine);
+        }
+        return ret;
+    };
+
+    util::aligned::vector<raytracer::impulse<core::simulation_bands>>
+            image_source;
+    for (auto i = 0; i != 30; ++i) {
+        const auto position =
+                glm::vec3{dist(engine), dist(engine), dist(engine)} * 10.0f;
+        image_source.emplace_back(raytracer::make_impulse(
+                make_bands(),
+                core::to_cl_float3{}(position),
+                glm::distance(position, receiver_position) + 1));
+    }
+
+    util::aligned::vector<core::bands_type> histogram(
+            200 * directional_histogram::directions);
+    for (auto& i : histogram) {
+        i = make_bands() * 0.000001f;
+    }
+
+    util::aligned::vector<waveguide_output> directional;
+    for (auto i = 0; i != 400; ++i) {
+        directional.emplace_back(waveguide_output{
+                glm::vec3{dist(engine), dist(engine), dist(engine)} * 0.001f,
+                dist(engine)});
+    }
+
+    return make_combined_results(
+            raytracer::make_simulation_results(
+                    std::move(image_source),
+                    histogram_type{
+                            1000, directional_histogram{std::move(histogram)}}),
+            util::aligned::vector<waveguide::bandpass_band>{
+                    waveguide::bandpass_band{
+                            waveguide::band{std::move(directional), 2000},
+                            util::make_range(0.0, 500.0)}});
+}
+
+template <typename Method>
+void check_shared_matches_per_capsule(
+        const combined_results<histogram_type>& input,
+        const capsule_independent_results& shared,
+        const Method& method) {
+    const auto per_capsule = postprocess(
+            input, shared, method, receiver_position, environment);
+
+    const auto components = linear_components(method);
+    const auto early = compute_early_components(input,
+                                                shared,
+                                                begin(components),
+                                                end(components),
+                                                receiver_position,
+                                                environment);
+    const auto mixed = postprocess(input, shared, early, method, environment);
+
+    ASSERT_EQ(per_capsule.size(), mixed.size());
+    ASSERT_FALSE(per_capsule.empty());
+
+    const auto max_magnitude = std::abs(*std::max_element(
+            begin(per_capsule),
+            end(per_capsule),
+            [](auto a, auto b) { return std::abs(a) < std::abs(b); }));
+    ASSERT_NE(max_magnitude, 0);
+
+    for (auto i = 0ul; i != per_capsule.size(); ++i) {
+        ASSERT_NEAR(per_capsule[i], mixed[i], max_magnitude * 0.0001) << i;
+    }
+}
+
+}  // namespace
+
+TEST(postprocess, shared_matches_per_capsule) {
+    const auto input = make_input();
+    const auto shared = compute_capsule_independent_results(input,
+                                                            source_position,
+                                                            receiver_position,
+                                                            room_volume,
+                                                            environment,
+                                                            output_sample_rate);
+
+    check_shared_matches_per_capsule(input, shared, core::attenuator::null{});
+
+    for (const auto shape : {0.0f, 0.5f, 0.75f, 1.0f}) {
+        for (const auto& pointing : {glm::vec3{0, 0, -1},
+                                     glm::vec3{1, 0, 0},
+                                     glm::vec3{-1, 2, 1}}) {
+            check_shared_matches_per_capsule(
+                    input,
+                    shared,
+                    core::attenuator::microphone{core::orientation{pointing},
+                                                 shape});
+        }
+    }
+}
@@ -0,0 +1,198 @@
+#include "combined/model/persistent.h"
+
+#include "audio_file/streaming.h"
+
+#include "utilities/string_builder.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#ifndef SCRATCH_PATH
+#define SCRATCH_PATH ""
+#endif
+
+using namespace wayverb::combined;
+
+namespace {
+
+using signal = std::vector<std::vector<float>>;
+
+/// Shorter than, equal to, and not a multiple of the writers' internal chunk
+/// size.
+const std::vector<size_t> lengths{1, 1000, 1 << 14, (1 << 14) + 7, 40000};
+
+signal make_noise(size_t channels, size_t frames, float peak) {
+    std::mt19937 engine{static_cast<unsigned>(channels * frames)};
+    std::uniform_real_distribution<float> dist{-peak, peak};
+    signal ret(channels, std::vector<float>(frames));
+    for (auto& channel : ret) {
+        for (auto& sample : channel) {
+            sample = dist(engine);
+        }
+    }
+    //  Make sure the peak is actually reached.
+    ret.front().front() = peak;
+    return ret;
+}
+
+std::string make_path(const std::string& name) {
+    return util::build_string(SCRATCH_PATH, "/streaming_writer.", name, ".wav");
+}
+
+void check_file(const std::string& path,
+                const signal& expected,
+                float factor,
+                int sample_rate) {
+    const auto read = audio_file::read(path.c_str());
+    ASSERT_EQ(read.sample_rate, sample_rate);
+    ASSERT_EQ(read.signal.size(), expected.size());
+    for (auto i = 0ul; i != expected.size(); ++i) {
+        ASSERT_EQ(read.signal[i].size(), expected[i].size());
+        for (auto j = 0ul; j != expected[i].size(); ++j) {
+            //  Written as 32-bit float, so there's only the rounding of the
+            //  scaling to allow for.
+            ASSERT_NEAR(read.signal[i][j], expected[i][j] * factor, 1.0e-6)
+                    << "channel " << i << ", frame " << j;
+        }
+    }
+}
+
+}  // namespace
+
+TEST(streaming_writer, writer) {
+    constexpr auto sample_rate = 44100;
+
+    for (const auto frames : lengths) {
+        SCOPED_TRACE(frames);
+
+        const auto input = make_noise(2, frames, 0.5f);
+        const auto interleaved =
+                audio_file::interleave(begin(input), end(input));
+        const auto path = make_path("writer");
+
+        {
+            audio_file::writer writer{path.c_str(),
+                                      2,
+                                      sample_rate,
+                                      audio_file::format::wav,
+                                      audio_file::bit_depth::float32};
+            ASSERT_EQ(writer.get_channels(), 2);
+
+            //  Written in uneven pieces, as a convolver might produce them.
+            for (size_t begin = 0; begin < frames; begin += 333) {
+                const auto count = std::min<size_t>(333, frames - begin);
+                writer.write(interleaved.data() + begin * 2, count);
+            }
+        }
+
+        check_file(path, input, 1, sample_rate);
+        std::remove(path.c_str());
+    }
+}
+
+TEST(streaming_writer, normalising_writer) {
+    constexpr auto sample_rate = 48000;
+
+    audio_file::normalising_writer writer{sample_rate,
+                                          audio_file::format::wav,
+                                          audio_file::bit_depth::float32};
+
+    //  Files with different lengths, channel counts, and peaks, which must
+    //  all be scaled by the same factor.
+    std::vector<std::pair<std::string, signal>> files;
+    for (auto i = 0ul; i != lengths.size(); ++i) {
+        const auto peak = 0.25f * (i + 1);
+        files.emplace_back(make_path(std::to_string(i)),
+                           make_noise(i % 3 + 1, lengths[i], peak));
+        writer.add(files.back().first,
+                   begin(files.back().second),
+                   end(files.back().second));
+    }
+
+    ASSERT_EQ(writer.get_num_files(), files.size());
+
+    const auto peak = 0.25f * lengths.size();
+    ASSERT_EQ(writer.get_max_magnitude(), peak);
+
+    //  Everything added so far has been spilled to disk, so changing the
+    //  originals must not affect the output.
+    const auto expected = files;
+    for (auto& file : files) {
+        for (auto& channel : file.second) {
+            std::fill(begin(channel), end(channel), 0.0f);
+        }
+    }
+
+    writer.write();
+
+    for (const auto& file : expected) {
+        SCOPED_TRACE(file.first);
+        check_file(file.first, file.second, 1 / peak, sample_rate);
+        std::remove(file.first.c_str());
+    }
+}
+
+TEST(streaming_writer, silent) {
+    audio_file::normalising_writer writer{44100,
+                                          audio_file::format::wav,
+                                          audio_file::bit_depth::float32};
+
+    const auto path = make_path("silent");
+    const signal silence(2, std::vector<float>(100, 0.0f));
+    writer.add(path, begin(silence), end(silence));
+
+    ASSERT_EQ(writer.get_max_magnitude(), 0);
+    ASSERT_THROW(writer.write(), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(streaming_writer, unequal_channels) {
+    audio_file::normalising_writer writer{44100,
+                                          audio_file::format::wav,
+                                          audio_file::bit_depth::float32};
+
+    const signal input{std::vector<float>(100), std::vector<float>(99)};
+    ASSERT_THROW(writer.add(make_path("unequal"), begin(input), end(input)),
+                 std::runtime_error);
+    ASSERT_EQ(writer.get_num_files(), 0);
+}
+
+TEST(streaming_writer, file_per_receiver) {
+    constexpr auto sample_rate = 44100;
+
+    model::persistent persistent{};
+    auto& capsules = *(*persistent.receivers())[0]->capsules().item();
+    capsules[0]->set_name("a");
+    capsules.push_back(model::capsule{"b"});
+    capsules.push_back(model::capsule{"c"});
+
+    model::output output;
+    output.set_output_directory(SCRATCH_PATH);
+    output.set_format(audio_file::format::wav);
+    output.set_bit_depth(audio_file::bit_depth::float32);
+
+    output.set_layout(model::output::layout::file_per_capsule);
+    ASSERT_EQ(model::compute_all_file_names(persistent, output).size(), 3);
+
+    output.set_layout(model::output::layout::file_per_receiver);
+    const auto names = model::compute_all_file_names(persistent, output);
+    ASSERT_EQ(names.size(), 1);
+
+    //  One channel per capsule, in capsule order.
+    signal channels;
+    for (auto i = 0; i != 3; ++i) {
+        channels.emplace_back(1000, 0.0f);
+        channels.back()[i] = 0.25f * (i + 1);
+    }
+
+    audio_file::normalising_writer writer{
+            sample_rate, output.get_format(), output.get_bit_depth()};
+    writer.add(names.front(), begin(channels), end(channels));
+    writer.write();
+
+    check_file(names.front(), channels, 1 / 0.75f, sample_rate);
+    std::remove(names.front().c_str());
+}
@@ -2,6 +2,8 @@
 
 #include "core/orientation.h"
 
+#include <array>
+
 namespace wayverb {
 namespace core {
 namespace attenuator {
@@ -30,6 +32,21 @@ bool operator!=(const microphone& a, const microphone& b);
 
 float attenuation(const microphone& mic, const glm::vec3& incident);
 
+/// A microphone's response is linear in four components: an omnidirectional
+/// one (axis 0), and figure-of-eight ones along x, y and z (axes 1 to 3).
+/// Signals can be postprocessed once per component, and then mixed for any
+/// number of microphones at the same position.
+struct microphone_component final {
+    size_t axis;
+};
+
+float attenuation(const microphone_component& component,
+                  const glm::vec3& incident);
+
+/// The weight of each microphone_component in the response of `mic`, in axis
+/// order.
+std::array<float, 4> component_weights(const microphone& mic);
+
 }  // namespace attenuator
 }  // namespace core
 }  // namespace wayverb
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "core/cl/scene_structs.h"
+#include "core/filters_common.h"
+
+#include <algorithm>
+#include <array>
+
+namespace wayverb {
+namespace core {
+namespace filter {
+
+/// Runs several independent biquad cascades in lockstep, one per lane.
+/// Lanes might be frequency bands (filtering a bands_type per sample) or
+/// separate channels of interleaved audio.
+/// Each cascade uses transposed direct form II, like `biquad`.
+/// State and coefficients are stored lane-contiguous, so that the inner
+/// loop over lanes compiles to SIMD instructions.
+/// Like `biquad`, arithmetic is double-precision, because single-precision
+/// coefficients are too coarse for low cutoffs.
+/// Adheres to the IIR filter concept, where each 'sample' is a whole frame.
+///
+/// Nothing in the render path uses this yet: bands are split in the
+/// frequency domain, and the only recursive filters on the host (in the PCS
+/// source design) run over a single double-precision signal, which a bank of
+/// single-precision frames can't reproduce exactly.
+/// It is meant for new multiband or multichannel IIR code, in place of one
+/// series_biquads per lane.
+template <size_t Stages, size_t Lanes = simulation_bands>
+class biquad_bank final {
+public:
+    static constexpr auto num_biquads = Stages;
+    static constexpr auto lanes = Lanes;
+
+    using frame_type = std::array<float, lanes>;
+
+    /// Coefficients for every lane of a single stage.
+    using stage_coefficients = std::array<biquad::coefficients, lanes>;
+
+    explicit biquad_bank(
+            const std::array<stage_coefficients, num_biquads>& coefficients) {
+        for (auto i = 0ul; i != num_biquads; ++i) {
+            for (auto j = 0ul; j != lanes; ++j) {
+                const auto& c = coefficients[i][j];
+                stages_[i].b0[j] = c.b0;
+                stages_[i].b1[j] = c.b1;
+                stages_[i].b2[j] = c.b2;
+                stages_[i].a1[j] = c.a1;
+                stages_[i].a2[j] = c.a2;
+            }
+        }
+        clear();
+    }
+
+    /// Filter one frame of `lanes` samples in place.
+    void filter(float* frame) {
+        std::array<double, lanes> x;
+        std::copy(frame, frame + lanes, x.begin());
+        for (auto& s : stages_) {
+            for (auto j = 0ul; j != lanes; ++j) {
+                const auto in = x[j];
+                const auto out = in * s.b0[j] + s.z1[j];
+                s.z1[j] = in * s.b1[j] - s.a1[j] * out + s.z2[j];
+                s.z2[j] = in * s.b2[j] - s.a2[j] * out;
+                x[j] = out;
+            }
+        }
+        std::copy(x.begin(), x.end(), frame);
+    }
+
+    frame_type filter(frame_type frame) {
+        filter(frame.data());
+        return frame;
+    }
+
+    bands_type filter(bands_type frame) {
+        static_assert(lanes == simulation_bands,
+                      "bands_type frames require one lane per band");
+        filter(frame.s);
+        return frame;
+    }
+
+    /// Filter `frames` interleaved frames in place, in order.
+    void filter(float* interleaved, size_t frames) {
+        for (auto i = 0ul; i != frames; ++i) {
+            filter(interleaved + i * lanes);
+        }
+    }
+
+    /// Filter `frames` interleaved frames in place, last frame first.
+    void filter_reversed(float* interleaved, size_t frames) {
+        for (auto i = frames; i != 0; --i) {
+            filter(interleaved + (i - 1) * lanes);
+        }
+    }
+
+    ///	Resets delay lines, does *not* affect filter coefficients.
+    void clear() {
+        for (auto& s : stages_) {
+            s.z1.fill(0);
+            s.z2.fill(0);
+        }
+    }
+
+private:
+    struct alignas(1 << 5) stage final {
+        std::array<double, lanes> b0, b1, b2, a1, a2;
+        std::array<double, lanes> z1, z2;
+    };
+
+    std::array<stage, num_biquads> stages_;
+};
+
+/// Build a bank where every lane has the same cascade.
+template <size_t Lanes = simulation_bands, size_t Stages>
+auto make_biquad_bank(
+        const std::array<biquad::coefficients, Stages>& coefficients) {
+    std::array<std::array<biquad::coefficients, Lanes>, Stages> per_lane;
+    for (auto i = 0ul; i != Stages; ++i) {
+        per_lane[i].fill(coefficients[i]);
+    }
+    return biquad_bank<Stages, Lanes>{per_lane};
+}
+
+template <size_t Stages, size_t Lanes>
+void run_one_pass(biquad_bank<Stages, Lanes>& filter,
+                  float* interleaved,
+                  size_t frames) {
+    filter.clear();
+    filter.filter(interleaved, frames);
+}
+
+/// Zero-phase forward-backward filtering of interleaved frames.
+/// Like the other run_two_pass, this doesn't pad or estimate initial
+/// conditions.
+template <size_t Stages, size_t Lanes>
+void run_two_pass(biquad_bank<Stages, Lanes>& filter,
+                  float* interleaved,
+                  size_t frames) {
+    run_one_pass(filter, interleaved, frames);
+    filter.clear();
+    filter.filter_reversed(interleaved, frames);
+}
+
+}  // namespace filter
+}  // namespace core
+}  // namespace wayverb
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "core/cl/include.h"
+
+/// \file trace.h
+/// Device-side timings for `util::trace`.
+
+namespace wayverb {
+namespace core {
+
+/// Command queues should be created with these properties, so that their
+/// kernels can be timed when tracing is enabled.
+/// Profiling is only requested while a recorder is installed.
+cl_command_queue_properties get_queue_properties();
+
+/// Records the time spent running a kernel on the device, if a recorder is
+/// installed.
+/// The event must have been enqueued on a queue created with
+/// `get_queue_properties`.
+/// Device timestamps are read later, in batches or once the results are
+/// requested, by which time the kernel has normally finished.
+void trace_kernel(const char* name, const cl::Event& event);
+
+}  // namespace core
+}  // namespace wayverb
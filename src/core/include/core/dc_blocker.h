@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/cl/scene_structs.h"
 #include "core/filters_common.h"
 #include "core/schroeder.h"
 
@@ -123,6 +124,53 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/// Block versions of the linear dc blockers.
+/// These give the same output as running a freshly-cleared
+/// linear_dc_blocker or extra_linear_dc_blocker over each channel, but each
+/// moving average stage runs as a single running-sum loop over the whole
+/// buffer, rather than through a circular delay line one sample at a time.
+/// Signals are interleaved, with `channels` samples per frame, and are
+/// filtered in place.
+
+void run_linear_dc_blocker(float* interleaved,
+                           size_t frames,
+                           size_t channels,
+                           int d = 128);
+
+void run_extra_linear_dc_blocker(float* interleaved,
+                                 size_t frames,
+                                 size_t channels,
+                                 int d = 128);
+
+/// The linear dc blockers are symmetric FIR filters, so removing their
+/// group delay (d - 1 samples, or 2 * (d - 1) for the extra-linear version)
+/// makes them zero-phase.
+/// Unlike run_two_pass, this leaves the magnitude response unchanged.
+
+void run_linear_dc_blocker_zero_phase(float* interleaved,
+                                      size_t frames,
+                                      size_t channels,
+                                      int d = 128);
+
+void run_extra_linear_dc_blocker_zero_phase(float* interleaved,
+                                            size_t frames,
+                                            size_t channels,
+                                            int d = 128);
+
+/// Apply a block dc blocker to every band of a multiband signal.
+template <typename Callback>
+void run_per_band(util::aligned::vector<bands_type>& signal,
+                  const Callback& callback,
+                  int d = 128) {
+    static_assert(sizeof(bands_type) == sizeof(float) * simulation_bands,
+                  "bands_type must be tightly packed");
+    if (!signal.empty()) {
+        callback(signal.front().s, signal.size(), simulation_bands, d);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 /// This uses a butterworth filter for a flat passband and steep falloff.
 /// The butterworth is chosen to provide a reasonable balance between stope
 /// steepness and impulse response length.
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "utilities/aligned/vector.h"
+
+#include <cstdint>
 #include <functional>
+#include <stdexcept>
 
 namespace wayverb {
 namespace core {
@@ -9,11 +13,11 @@ using mls_callback = std::function<void(bool value, size_t step)>;
 
 namespace {
 constexpr uint32_t masks[] = {
-        0x000000U, 0x000000U, 0x000002U, 0x000006U, 0x00000CU,
-        0x000014U, 0x000030U, 0x000060U, 0x0000E1U, 0x000100U,
+        0x000000U, 0x000000U, 0x000003U, 0x000006U, 0x00000CU,
+        0x000014U, 0x000030U, 0x000060U, 0x0000E1U, 0x000110U,
         0x000240U, 0x000500U, 0x000E08U, 0x001C80U, 0x003802U,
         0x006000U, 0x00D008U, 0x012000U, 0x020400U, 0x072000U,
-        0x090000U, 0x500000U, 0xC00000U, 0x420000U, 0xE10000U};
+        0x090000U, 0x140000U, 0x300000U, 0x420000U, 0xE10000U};
 }  // namespace
 
 template <typename Word>
@@ -27,5 +31,61 @@ void generate_maximum_length_sequence(Word order,
     }
 }
 
+/// Generate a whole sequence at once, as a bipolar signal.
+/// Bits which are set map to -1, and clear bits map to +1.
+/// Supports orders from 2 to 24 inclusive.
+util::aligned::vector<float> generate_bipolar_maximum_length_sequence(
+        size_t order);
+
+/// Recovers impulse responses from MLS-excited signals, using a fast
+/// Walsh-Hadamard transform rather than FFT correlation.
+/// The correlation matrix of a maximum length sequence is a permuted
+/// Hadamard matrix, so the circular cross-correlation with the sequence can
+/// be found by permuting the input, running a Hadamard transform, and
+/// permuting the output.
+/// Constructing the permutation tables is O(N); each correlation is
+/// O(N log N) using only additions.
+class mls_correlator final {
+public:
+    explicit mls_correlator(size_t order);
+
+    size_t get_order() const;
+
+    /// The length of the sequence, (2 ^ order) - 1.
+    size_t size() const;
+
+    /// The bipolar excitation signal.
+    const util::aligned::vector<float>& get_sequence() const;
+
+    /// Circular cross-correlation of one period of a response with the
+    /// sequence, scaled by 1 / (size() + 1).
+    /// If the response was produced by exciting a system with (periodic)
+    /// repeats of the sequence, the result is the system's impulse response,
+    /// minus a small constant offset equal to the response's sum
+    /// divided by (size() + 1).
+    /// `response` must point to size() samples.
+    util::aligned::vector<float> correlate(const float* response) const;
+
+    template <typename T>
+    auto correlate(const T& response) const {
+        if (response.size() != size()) {
+            throw std::runtime_error{
+                    "Response length must equal sequence length."};
+        }
+        return correlate(response.data());
+    }
+
+private:
+    size_t order_;
+    util::aligned::vector<float> sequence_;
+
+    /// The generator state at each step, which is where each input sample is
+    /// placed before the transform.
+    util::aligned::vector<uint32_t> input_permutation_;
+
+    /// The transform output index holding the correlation at each lag.
+    util::aligned::vector<uint32_t> output_permutation_;
+};
+
 }  // namespace core
 }  // namespace wayverb
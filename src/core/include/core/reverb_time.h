@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/geo/triangle_vec.h"
+#include "core/scene_analytics.h"
 #include "core/scene_data.h"
 
 #include "utilities/aligned/set.h"
@@ -19,12 +20,11 @@ namespace core {
 /// a result, let alone a *valid* result.
 
 /// Find the area covered by a particular material.
+/// This has to look at every triangle in the scene, so if the areas of
+/// several materials are needed, use compute_geometry_analytics instead.
 template <typename Vertex, typename Surface>
 double area(const generic_scene_data<Vertex, Surface>& scene,
             size_t surface_index) {
-    //  TODO this is dumb because of the linear search.
-    //  If this becomes a bottleneck, maybe scene_data could store surfaces
-    //  pre-sorted by material.
     return std::accumulate(
             begin(scene.get_triangles()),
             end(scene.get_triangles()),
@@ -66,12 +66,7 @@ auto absorption_area(const generic_scene_data<Vertex, Surface>& scene,
 template <typename Vertex, typename Surface>
 auto equivalent_absorption_area(
         const generic_scene_data<Vertex, Surface>& scene) {
-    const auto num_surfaces = scene.get_surfaces().size();
-    decltype(absorption_area(scene, 0)) running_total{};
-    for (auto i = 0u; i != num_surfaces; ++i) {
-        running_total += absorption_area(scene, i);
-    }
-    return running_total;
+    return make_scene_analytics(scene).get_equivalent_absorption_area();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -100,8 +95,6 @@ bool triangles_are_oriented(It begin, It end) {
     return true;
 }
 
-float six_times_tetrahedron_volume(const geo::triangle_vec3& t);
-
 /// http://research.microsoft.com/en-us/um/people/chazhang/publications/icip01_ChaZhang.pdf
 template <typename Vertex, typename Surface>
 float estimate_room_volume(const generic_scene_data<Vertex, Surface>& scene) {
@@ -163,12 +156,18 @@ auto sabine_reverb_time(double room_volume,
 
 /// Sabine reverb time (use the damping constant function above too)
 /// (kuttruff 5.9) (vorlander 4.33)
+template <typename Surface, typename Coeff>
+auto sabine_reverb_time(const scene_analytics<Surface>& analytics,
+                        Coeff air_coefficient) {
+    return sabine_reverb_time(analytics.get_volume(),
+                              analytics.get_equivalent_absorption_area(),
+                              air_coefficient);
+}
+
 template <typename Vertex, typename Surface, typename Coeff>
 auto sabine_reverb_time(const generic_scene_data<Vertex, Surface>& scene,
                         Coeff air_coefficient) {
-    return sabine_reverb_time(estimate_room_volume(scene),
-                              equivalent_absorption_area(scene),
-                              air_coefficient);
+    return sabine_reverb_time(make_scene_analytics(scene), air_coefficient);
 }
 
 template <typename Absorption, typename Coeff>
@@ -191,13 +190,19 @@ auto eyring_reverb_time(double room_volume,
 }
 
 /// Eyring reverb time (kuttruff 5.24) (vorlander 4.32)
+template <typename Surface, typename Coeff>
+auto eyring_reverb_time(const scene_analytics<Surface>& analytics,
+                        Coeff air_coefficient) {
+    return eyring_reverb_time(analytics.get_volume(),
+                              analytics.get_equivalent_absorption_area(),
+                              analytics.get_total_area(),
+                              air_coefficient);
+}
+
 template <typename Vertex, typename Surface, typename Coeff>
 auto eyring_reverb_time(const generic_scene_data<Vertex, Surface>& scene,
                         Coeff air_coefficient) {
-    return eyring_reverb_time(estimate_room_volume(scene),
-                              equivalent_absorption_area(scene),
-                              area(scene),
-                              air_coefficient);
+    return eyring_reverb_time(make_scene_analytics(scene), air_coefficient);
 }
 
 }  // namespace core
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "core/geo/triangle_vec.h"
+#include "core/scene_data.h"
+
+#include <cmath>
+#include <utility>
+
+namespace wayverb {
+namespace core {
+
+float six_times_tetrahedron_volume(const geo::triangle_vec3& t);
+
+/// Properties of a scene which only depend on its geometry.
+/// The same assumptions as the functions in reverb_time.h apply: the volume
+/// is only meaningful for a closed, consistently-oriented scene.
+struct geometry_analytics final {
+    /// Area covered by each surface, by surface index.
+    util::aligned::vector<double> surface_areas;
+    double total_area{};
+    double volume{};
+};
+
+/// Finds the areas and volume of a scene in a single pass over its
+/// triangles.
+template <typename Vertex, typename Surface>
+geometry_analytics compute_geometry_analytics(
+        const generic_scene_data<Vertex, Surface>& scene) {
+    geometry_analytics ret;
+    ret.surface_areas.resize(scene.get_surfaces().size());
+
+    auto six_times_volume = 0.0;
+    for (const auto& tri : scene.get_triangles()) {
+        const auto t = geo::get_triangle_vec3(tri, scene.get_vertices().data());
+        const auto a = geo::area(t);
+        ret.surface_areas[tri.surface] += a;
+        ret.total_area += a;
+        six_times_volume += six_times_tetrahedron_volume(t);
+    }
+    ret.volume = std::abs(six_times_volume) / 6;
+
+    return ret;
+}
+
+/// Everything needed to estimate the reverb time of a scene.
+/// The geometric properties are found once, on construction.
+/// When only the surfaces change, just the absorption area is recomputed.
+template <typename Surface>
+class scene_analytics final {
+public:
+    using absorption_type = decltype(std::declval<Surface>().absorption * 0.0);
+
+    template <typename Vertex>
+    explicit scene_analytics(const generic_scene_data<Vertex, Surface>& scene)
+            : geometry_{compute_geometry_analytics(scene)} {
+        set_surfaces(scene.get_surfaces());
+    }
+
+    /// Throws if the number of surfaces differs from the original scene.
+    void set_surfaces(const util::aligned::vector<Surface>& surfaces) {
+        if (surfaces.size() != geometry_.surface_areas.size()) {
+            throw std::runtime_error{
+                    "Number of surfaces differs from the original scene."};
+        }
+
+        absorption_type absorption_area{};
+        for (auto i = 0u; i != surfaces.size(); ++i) {
+            absorption_area +=
+                    surfaces[i].absorption * geometry_.surface_areas[i];
+        }
+        absorption_area_ = absorption_area;
+    }
+
+    const geometry_analytics& get_geometry() const { return geometry_; }
+
+    double get_area(size_t surface_index) const {
+        return geometry_.surface_areas[surface_index];
+    }
+    double get_total_area() const { return geometry_.total_area; }
+    double get_volume() const { return geometry_.volume; }
+
+    /// Sum of the areas covered by each surface, weighted by the absorption
+    /// coefficients of those surfaces.
+    const absorption_type& get_equivalent_absorption_area() const {
+        return absorption_area_;
+    }
+
+private:
+    geometry_analytics geometry_;
+    absorption_type absorption_area_;
+};
+
+template <typename Vertex, typename Surface>
+auto make_scene_analytics(const generic_scene_data<Vertex, Surface>& scene) {
+    return scene_analytics<Surface>{scene};
+}
+
+}  // namespace core
+}  // namespace wayverb
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "core/cl/include.h"
+#include "core/scene_data.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/// \file scene_cache.h
+/// A compact binary copy of an imported scene, so that large models only
+/// need to be parsed once.
+/// The file is laid out so that it can be memory-mapped: a fixed-size header,
+/// followed by the vertex and triangle arrays exactly as they are laid out in
+/// memory, followed by the surface names.
+
+namespace wayverb {
+namespace core {
+
+using named_scene_data = generic_scene_data<cl_float3, std::string>;
+
+/// Identifies the contents of a scene file.
+/// If there is a material library next to the file with the same name (i.e.
+/// an .obj with an .mtl) its contents contribute too, because it determines
+/// the surface names.
+std::uint64_t compute_scene_file_hash(const std::string& scene_file);
+
+/// The folder which holds cached scenes, for every model in every project.
+/// Defaults to a wayverb/scenes folder in the per-user cache folder
+/// ($XDG_CACHE_HOME or ~/.cache, or ~/Library/Caches on macOS), so that
+/// nothing is written next to the user's models.
+/// An empty string disables the cache.
+/// Applies to scenes loaded after the call.
+void set_scene_cache_directory(std::string directory);
+std::string get_scene_cache_directory();
+
+/// Where the cached copy of a scene file with the given contents is stored.
+/// Entries are named after both the absolute path of the scene file and the
+/// hash of its contents, so that different models with the same name never
+/// share an entry.
+std::string compute_scene_cache_path(const std::string& directory,
+                                     const std::string& scene_file,
+                                     std::uint64_t hash);
+
+/// Deletes any entries for the scene file other than the one with the given
+/// hash, so that editing a model doesn't leave an outdated copy behind for
+/// every version.
+void remove_stale_scene_cache_entries(const std::string& directory,
+                                      const std::string& scene_file,
+                                      std::uint64_t hash);
+
+/// Creates the enclosing folder if necessary.
+/// Throws if the file can't be written.
+void write_scene_cache(const std::string& fpath,
+                       const named_scene_data& scene,
+                       std::uint64_t hash);
+
+/// Returns nullopt if the file doesn't exist, was written by an incompatible
+/// version, was made from a different source file, or is corrupt.
+std::optional<named_scene_data> read_scene_cache(const std::string& fpath,
+                                                 std::uint64_t hash);
+
+}  // namespace core
+}  // namespace wayverb
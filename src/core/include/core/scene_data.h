@@ -5,6 +5,7 @@
 #include "utilities/aligned/vector.h"
 
 #include <numeric>
+#include <stdexcept>
 
 namespace wayverb {
 namespace core {
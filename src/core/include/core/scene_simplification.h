@@ -0,0 +1,72 @@
+#pragma once
+
+#include "core/conversions.h"
+#include "core/scene_data.h"
+
+#include "utilities/map_to_vector.h"
+
+namespace wayverb {
+namespace core {
+
+/// Imported models often contain duplicated vertices, zero-area triangles,
+/// and flat walls which have been split into many triangles.
+/// All of these make the voxel lists, ray-triangle tests, and image-source
+/// trees bigger than they need to be.
+///
+/// This function:
+///     Welds together vertices closer than `tolerance`.
+///     Removes triangles which have no area once welded.
+///     Removes vertices which lie inside a flat region with a single surface,
+///     or on a straight edge between two such regions, and retriangulates
+///     the hole.
+///
+/// Vertices are never moved, so if every merged region is exactly flat the
+/// area and volume of the scene are unchanged.
+///
+/// Returns the indices of the triangles which remain, referring to the
+/// original vertex array.
+util::aligned::vector<triangle> simplify_triangles(
+        const util::aligned::vector<glm::vec3>& vertices,
+        const util::aligned::vector<triangle>& triangles,
+        float tolerance);
+
+/// Returns a copy of the scene with duplicate vertices, degenerate triangles,
+/// and unnecessary subdivisions of flat regions removed.
+/// The surfaces are copied unchanged.
+template <typename Vertex, typename Surface>
+auto simplify_scene(const generic_scene_data<Vertex, Surface>& scene,
+                    float tolerance = 0.0001f) {
+    const auto& vertices = scene.get_vertices();
+    auto triangles = simplify_triangles(
+            util::map_to_vector(begin(vertices), end(vertices), to_vec3{}),
+            scene.get_triangles(),
+            tolerance);
+
+    //  Drop vertices which are no longer used, keeping the rest in order.
+    constexpr auto unused = ~cl_uint{0};
+    util::aligned::vector<cl_uint> new_index(vertices.size(), unused);
+    for (const auto& tri : triangles) {
+        new_index[tri.v0] = new_index[tri.v1] = new_index[tri.v2] = 0;
+    }
+
+    util::aligned::vector<Vertex> new_vertices;
+    for (auto i = 0u; i != vertices.size(); ++i) {
+        if (new_index[i] != unused) {
+            new_index[i] = new_vertices.size();
+            new_vertices.emplace_back(vertices[i]);
+        }
+    }
+
+    for (auto& tri : triangles) {
+        tri.v0 = new_index[tri.v0];
+        tri.v1 = new_index[tri.v1];
+        tri.v2 = new_index[tri.v2];
+    }
+
+    return make_scene_data(std::move(triangles),
+                           std::move(new_vertices),
+                           scene.get_surfaces());
+}
+
+}  // namespace core
+}  // namespace wayverb
@@ -1,9 +1,9 @@
 #pragma once
 
-#include "common/cl_include.h"
+#include "core/cl/include.h"
+
+#include "cereal/cereal.hpp"
 
-namespace wayverb {
-namespace core {
 namespace cereal {
 
 template <typename Archive>
@@ -14,5 +14,3 @@ void serialize(Archive& archive, cl_float3& m) {
 }
 
 }  // namespace cereal
-}  // namespace core
-}  // namespace wayverb
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "core/environment.h"
+
+#include "cereal/cereal.hpp"
+
+namespace cereal {
+
+template <typename Archive>
+void serialize(Archive& archive, wayverb::core::environment& m) {
+    archive(make_nvp("speed_of_sound", m.speed_of_sound),
+            make_nvp("acoustic_impedance", m.acoustic_impedance));
+}
+
+}  // namespace cereal
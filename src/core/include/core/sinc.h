@@ -4,6 +4,9 @@
 
 #include "utilities/aligned/vector.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace wayverb {
 namespace core {
 
@@ -5,6 +5,8 @@
 #include "core/scene_data.h"
 #include "core/spatial_division/voxel_collection.h"
 
+#include "utilities/trace.h"
+
 #include <random>
 
 namespace wayverb {
@@ -62,6 +64,7 @@ template <typename Vertex, typename Surface, typename T>
 auto make_voxelised_scene_data(generic_scene_data<Vertex, Surface> scene,
                                size_t octree_depth,
                                const util::range<T>& aabb) {
+    const util::trace::scope scope{"voxelise"};
     return voxelised_scene_data<Vertex, Surface>{
             std::move(scene), octree_depth, aabb};
 }
@@ -24,6 +24,23 @@ float attenuation(const microphone& mic, const glm::vec3& incident) {
     return 0;
 }
 
+float attenuation(const microphone_component& component,
+                  const glm::vec3& incident) {
+    if (const auto l = glm::length(incident)) {
+        return component.axis ? incident[component.axis - 1] / l : 1;
+    }
+    return 0;
+}
+
+std::array<float, 4> component_weights(const microphone& mic) {
+    const auto shape = mic.get_shape();
+    const auto pointing = mic.orientation.get_pointing();
+    return {{1 - shape,
+             shape * pointing.x,
+             shape * pointing.y,
+             shape * pointing.z}};
+}
+
 bool operator==(const microphone& a, const microphone& b) {
     return a.get_shape() == b.get_shape() && a.orientation == b.orientation;
 }
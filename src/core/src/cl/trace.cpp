@@ -0,0 +1,49 @@
+#include "core/cl/trace.h"
+
+#include "utilities/trace.h"
+
+namespace wayverb {
+namespace core {
+
+cl_command_queue_properties get_queue_properties() {
+    return util::trace::get_recorder() ? CL_QUEUE_PROFILING_ENABLE : 0;
+}
+
+void trace_kernel(const char* name, const cl::Event& event) {
+    const auto recorder = util::trace::get_recorder();
+    if (!recorder) {
+        return;
+    }
+
+    //  The device clock is unrelated to the host clock, so device times are
+    //  placed relative to the moment the kernel was enqueued.
+    const auto enqueued = util::trace::now();
+    const auto track = recorder->get_named_track("OpenCL device");
+
+    recorder->add_deferred_event([name, event, enqueued, track] {
+        try {
+            event.wait();
+            //  Profiling info is in nanoseconds.
+            const auto queued = static_cast<double>(
+                    event.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>());
+            const auto start = static_cast<double>(
+                    event.getProfilingInfo<CL_PROFILING_COMMAND_START>());
+            const auto end = static_cast<double>(
+                    event.getProfilingInfo<CL_PROFILING_COMMAND_END>());
+
+            return std::make_pair(
+                    true,
+                    util::trace::event{name,
+                                       "kernel",
+                                       enqueued + (start - queued) / 1000,
+                                       (end - start) / 1000,
+                                       track});
+        } catch (const cl::Error&) {
+            //  The queue wasn't created with profiling enabled.
+            return std::make_pair(false, util::trace::event{});
+        }
+    });
+}
+
+}  // namespace core
+}  // namespace wayverb
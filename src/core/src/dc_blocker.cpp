@@ -1,5 +1,8 @@
 #include "core/dc_blocker.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace wayverb {
 namespace core {
 namespace filter {
@@ -76,6 +79,156 @@ void extra_linear_dc_blocker::clear() {
     moving_averages.clear();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+/// A cascade of moving averages over interleaved channels, processed in
+/// chunks.
+/// The arithmetic matches moving_average::filter exactly.
+class moving_average_cascade final {
+public:
+    moving_average_cascade(size_t channels, int d, int modules)
+            : channels_{channels}
+            , d_{d}
+            , lag_{d * channels}
+            , stages_(modules,
+                      util::aligned::vector<double>(
+                              lag_ + chunk_frames * channels, 0))
+            , sums_(modules * channels, 0) {}
+
+    /// Filter up to chunk_frames frames.
+    /// Missing input is treated as zero.
+    void filter(const float* in,
+                size_t in_frames,
+                size_t frames,
+                double* out) {
+        auto& first = stages_.front();
+        const auto in_samples = in_frames * channels_;
+        std::copy(in, in + in_samples, first.begin() + lag_);
+        std::fill(first.begin() + lag_ + in_samples,
+                  first.begin() + lag_ + frames * channels_,
+                  0.0);
+
+        for (auto f = 0ul; f != frames; ++f) {
+            for (auto m = 0ul; m != stages_.size(); ++m) {
+                const auto base = lag_ + f * channels_;
+                const auto in_stage = stages_[m].data() + base;
+                const auto oldest = in_stage - lag_;
+                const auto out_stage = m + 1 == stages_.size()
+                                               ? out + f * channels_
+                                               : stages_[m + 1].data() + base;
+                const auto sums = sums_.data() + m * channels_;
+                for (auto c = 0ul; c != channels_; ++c) {
+                    sums[c] = in_stage[c] - oldest[c] + sums[c];
+                    out_stage[c] = sums[c] / d_;
+                }
+            }
+        }
+
+        //  Keep the most recent input to each stage, for the next chunk.
+        for (auto& stage : stages_) {
+            const auto end = stage.begin() + lag_ + frames * channels_;
+            std::copy(end - lag_, end, stage.begin());
+        }
+    }
+
+    static constexpr size_t chunk_frames = 1 << 10;
+
+private:
+    size_t channels_;
+    int d_;
+    size_t lag_;
+    util::aligned::vector<util::aligned::vector<double>> stages_;
+    util::aligned::vector<double> sums_;
+};
+
+/// Output = input delayed by `delay` - moving averages.
+/// The first `advance` frames of output are dropped.
+void linear_dc_blocker_impl(float* interleaved,
+                            size_t frames,
+                            size_t channels,
+                            int d,
+                            int modules,
+                            size_t delay,
+                            size_t advance) {
+    if (d <= 0) {
+        throw std::runtime_error{"Moving average length must be positive."};
+    }
+
+    const util::aligned::vector<float> input(interleaved,
+                                             interleaved + frames * channels);
+
+    moving_average_cascade cascade{channels, d, modules};
+    constexpr auto chunk_frames = moving_average_cascade::chunk_frames;
+    util::aligned::vector<double> averaged(chunk_frames * channels);
+
+    const auto total_frames = frames + advance;
+    for (auto start = 0ul; start < total_frames; start += chunk_frames) {
+        const auto chunk = std::min(chunk_frames, total_frames - start);
+        const auto available =
+                start < frames ? std::min(chunk, frames - start) : 0;
+        cascade.filter(input.data() + start * channels,
+                       available,
+                       chunk,
+                       averaged.data());
+
+        for (auto f = 0ul; f != chunk; ++f) {
+            const auto frame = start + f;
+            if (frame < advance) {
+                continue;
+            }
+            for (auto c = 0ul; c != channels; ++c) {
+                const auto delayed =
+                        delay <= frame && frame - delay < frames
+                                ? static_cast<double>(
+                                          input[(frame - delay) * channels + c])
+                                : 0.0;
+                interleaved[(frame - advance) * channels + c] =
+                        delayed - averaged[f * channels + c];
+            }
+        }
+    }
+}
+
+}  // namespace
+
+void run_linear_dc_blocker(float* interleaved,
+                           size_t frames,
+                           size_t channels,
+                           int d) {
+    linear_dc_blocker_impl(interleaved, frames, channels, d, 2, d - 1, 0);
+}
+
+void run_extra_linear_dc_blocker(float* interleaved,
+                                 size_t frames,
+                                 size_t channels,
+                                 int d) {
+    linear_dc_blocker_impl(
+            interleaved, frames, channels, d, 4, 2 * (d - 1), 0);
+}
+
+void run_linear_dc_blocker_zero_phase(float* interleaved,
+                                      size_t frames,
+                                      size_t channels,
+                                      int d) {
+    linear_dc_blocker_impl(
+            interleaved, frames, channels, d, 2, d - 1, d - 1);
+}
+
+void run_extra_linear_dc_blocker_zero_phase(float* interleaved,
+                                            size_t frames,
+                                            size_t channels,
+                                            int d) {
+    linear_dc_blocker_impl(interleaved,
+                           frames,
+                           channels,
+                           d,
+                           4,
+                           2 * (d - 1),
+                           2 * (d - 1));
+}
+
 }  // namespace filter
 }  // namespace core
 }  // namespace wayverb
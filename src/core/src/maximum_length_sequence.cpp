@@ -0,0 +1,123 @@
+#include "core/maximum_length_sequence.h"
+
+#include "utilities/popcount.h"
+
+#include <algorithm>
+
+namespace wayverb {
+namespace core {
+
+namespace {
+
+constexpr size_t min_order = 2;
+constexpr size_t max_order = 24;
+
+void check_order(size_t order) {
+    if (order < min_order || max_order < order) {
+        throw std::runtime_error{
+                "Maximum length sequence order must be between 2 and 24."};
+    }
+}
+
+/// Calls callback(state, step) for each step.
+/// The output bit at each step is the lowest bit of the state.
+/// Matches generate_maximum_length_sequence.
+template <typename Callback>
+void for_each_state(size_t order, const Callback& callback) {
+    const uint32_t signal_length = (uint32_t{1} << order) - 1;
+    const auto mask = masks[order];
+    for (uint32_t i = 0, reg = 1; i != signal_length; ++i) {
+        callback(reg, i);
+        reg = (reg >> 1) ^ ((0 - (reg & 1)) & mask);
+    }
+}
+
+/// In-place unnormalised fast Walsh-Hadamard transform.
+void fwht(util::aligned::vector<double>& data) {
+    const auto size = data.size();
+    for (auto half = 1ul; half < size; half *= 2) {
+        for (auto block = 0ul; block < size; block += half * 2) {
+            const auto a = data.data() + block;
+            const auto b = a + half;
+            for (auto i = 0ul; i != half; ++i) {
+                const auto x = a[i];
+                const auto y = b[i];
+                a[i] = x + y;
+                b[i] = x - y;
+            }
+        }
+    }
+}
+
+}  // namespace
+
+util::aligned::vector<float> generate_bipolar_maximum_length_sequence(
+        size_t order) {
+    check_order(order);
+    util::aligned::vector<float> ret((size_t{1} << order) - 1);
+    for_each_state(order, [&](auto state, auto step) {
+        ret[step] = state & 1 ? -1.0f : 1.0f;
+    });
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+mls_correlator::mls_correlator(size_t order)
+        : order_{order}
+        , sequence_{generate_bipolar_maximum_length_sequence(order)}
+        , input_permutation_(sequence_.size())
+        , output_permutation_(sequence_.size()) {
+    //  Each nonzero state appears exactly once.
+    //  Also find the step at which each single-bit state appears.
+    util::aligned::vector<uint32_t> unit_steps(order);
+    for_each_state(order, [&](auto state, auto step) {
+        input_permutation_[step] = state;
+        if (!(state & (state - 1))) {
+            unit_steps[util::popcount(state - 1)] = step;
+        }
+    });
+
+    //  The bit at step (n - k) is a linear function of the state at step n,
+    //  so it can be written as parity(c_k & state_n).
+    //  Bit j of c_k is found by evaluating at the step where the state is
+    //  (1 << j).
+    //  The correlation at lag k is then the Hadamard transform at index c_k.
+    const auto length = sequence_.size();
+    for (auto lag = 0ul; lag != length; ++lag) {
+        uint32_t c = 0;
+        for (auto bit = 0ul; bit != order; ++bit) {
+            const auto step = (unit_steps[bit] + length - lag) % length;
+            c |= uint32_t{sequence_[step] < 0} << bit;
+        }
+        output_permutation_[lag] = c;
+    }
+}
+
+size_t mls_correlator::get_order() const { return order_; }
+size_t mls_correlator::size() const { return sequence_.size(); }
+
+const util::aligned::vector<float>& mls_correlator::get_sequence() const {
+    return sequence_;
+}
+
+util::aligned::vector<float> mls_correlator::correlate(
+        const float* response) const {
+    //  Double precision, because each output sums every input.
+    util::aligned::vector<double> permuted(size() + 1, 0.0);
+    for (auto i = 0ul; i != size(); ++i) {
+        permuted[input_permutation_[i]] = response[i];
+    }
+
+    fwht(permuted);
+
+    const auto scale = 1.0 / (size() + 1);
+    util::aligned::vector<float> ret(size());
+    for (auto i = 0ul; i != size(); ++i) {
+        ret[i] = permuted[output_permutation_[i]] * scale;
+    }
+    return ret;
+}
+
+}  // namespace core
+}  // namespace wayverb
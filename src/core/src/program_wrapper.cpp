@@ -1,5 +1,7 @@
 #include "core/program_wrapper.h"
 
+#include "utilities/trace.h"
+
 #include <iostream>
 
 namespace wayverb {
@@ -34,6 +36,7 @@ program_wrapper::program_wrapper(
 }
 
 void program_wrapper::build(const cl::Device& device) const {
+    const util::trace::scope scope{"build program"};
     program.build({device}, "-Werror");
 }
 
@@ -0,0 +1,348 @@
+#include "core/scene_cache.h"
+
+#include "utilities/hash.h"
+#include "utilities/string_builder.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <type_traits>
+
+namespace wayverb {
+namespace core {
+
+namespace {
+
+constexpr char scene_cache_magic[8] = "wvscene";
+
+constexpr auto entry_suffix = ".bin";
+
+/// Bumped whenever the layout changes.
+constexpr std::uint32_t scene_cache_version = 1;
+
+/// Padded to a multiple of 16 bytes so that the vertex array which follows
+/// it is suitably aligned.
+struct alignas(16) header final {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t hash;
+    std::uint64_t num_vertices;
+    std::uint64_t num_triangles;
+    std::uint64_t num_surfaces;
+    std::uint64_t surface_bytes;
+};
+
+static_assert(sizeof(header) % 16 == 0, "Header must keep arrays aligned.");
+static_assert(sizeof(cl_float3) == 16, "Unexpected vertex layout.");
+static_assert(sizeof(triangle) == 16, "Unexpected triangle layout.");
+static_assert(std::is_trivially_copyable<cl_float3>::value &&
+                      std::is_trivially_copyable<triangle>::value,
+              "Arrays are copied byte-for-byte.");
+
+/// Returns false if the file couldn't be opened.
+bool add_file(util::fnv1a_hasher& h, const std::string& fpath) {
+    std::ifstream file{fpath, std::ios::binary};
+    if (!file.good()) {
+        return false;
+    }
+    char buffer[1 << 16];
+    while (file) {
+        file.read(buffer, sizeof(buffer));
+        h.add_bytes(buffer, file.gcount());
+    }
+    return true;
+}
+
+std::string strip_extension(const std::string& fpath) {
+    const auto slash = fpath.find_last_of('/');
+    const auto dot = fpath.find_last_of('.');
+    if (dot == std::string::npos ||
+        (slash != std::string::npos && dot < slash)) {
+        return fpath;
+    }
+    return fpath.substr(0, dot);
+}
+
+std::string default_scene_cache_directory() {
+    if (const auto cache = std::getenv("XDG_CACHE_HOME")) {
+        if (*cache != '\0') {
+            return util::build_string(cache, "/wayverb/scenes");
+        }
+    }
+    if (const auto home = std::getenv("HOME")) {
+#ifdef __APPLE__
+        return util::build_string(home, "/Library/Caches/wayverb/scenes");
+#else
+        return util::build_string(home, "/.cache/wayverb/scenes");
+#endif
+    }
+    return "";
+}
+
+std::mutex& scene_cache_directory_mutex() {
+    static std::mutex ret;
+    return ret;
+}
+
+std::string& scene_cache_directory() {
+    static std::string ret = default_scene_cache_directory();
+    return ret;
+}
+
+std::string absolute_path(const std::string& fpath) {
+    char buffer[PATH_MAX];
+    return realpath(fpath.c_str(), buffer) ? std::string{buffer} : fpath;
+}
+
+std::string to_hex(std::uint64_t t) {
+    std::ostringstream ret;
+    ret << std::hex << std::setw(16) << std::setfill('0') << t;
+    return ret.str();
+}
+
+/// Entries for the same scene file share this prefix, whatever its contents.
+std::string compute_entry_prefix(const std::string& scene_file) {
+    const auto path = absolute_path(scene_file);
+    util::fnv1a_hasher h;
+    h.add_bytes(path.data(), path.size());
+    return to_hex(h.get()) + '.';
+}
+
+/// Like mkdir -p.
+/// Stops at the first folder which can't be created, in which case writing
+/// into it will fail instead.
+void create_directories(const std::string& directory) {
+    for (auto slash = directory.find('/', 1);;
+         slash = directory.find('/', slash + 1)) {
+        const auto partial = directory.substr(0, slash);
+        if ((mkdir(partial.c_str(), 0755) == -1 && errno != EEXIST) ||
+            slash == std::string::npos) {
+            return;
+        }
+    }
+}
+
+/// Read-only memory mapping of a whole file.
+class mapped_file final {
+public:
+    explicit mapped_file(const std::string& fpath)
+            : fd_{open(fpath.c_str(), O_RDONLY)} {
+        if (fd_ == -1) {
+            return;
+        }
+
+        struct stat info {};
+        if (fstat(fd_, &info) == -1 || info.st_size == 0) {
+            return;
+        }
+
+        const auto data =
+                mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (data != MAP_FAILED) {
+            data_ = static_cast<const char*>(data);
+            size_ = info.st_size;
+        }
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() noexcept {
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+        if (fd_ != -1) {
+            close(fd_);
+        }
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    int fd_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+template <typename T>
+void write_array(std::ostream& os, const util::aligned::vector<T>& t) {
+    os.write(reinterpret_cast<const char*>(t.data()), t.size() * sizeof(T));
+}
+
+template <typename T>
+util::aligned::vector<T> read_array(const char* data, size_t elements) {
+    util::aligned::vector<T> ret(elements);
+    std::memcpy(ret.data(), data, elements * sizeof(T));
+    return ret;
+}
+
+}  // namespace
+
+std::uint64_t compute_scene_file_hash(const std::string& scene_file) {
+    util::fnv1a_hasher h;
+    if (!add_file(h, scene_file)) {
+        throw std::runtime_error{
+                util::build_string("Unable to open scene file: ", scene_file)};
+    }
+    add_file(h, strip_extension(scene_file) + ".mtl");
+    return h.get();
+}
+
+void set_scene_cache_directory(std::string directory) {
+    const std::lock_guard<std::mutex> lock{scene_cache_directory_mutex()};
+    scene_cache_directory() = std::move(directory);
+}
+
+std::string get_scene_cache_directory() {
+    const std::lock_guard<std::mutex> lock{scene_cache_directory_mutex()};
+    return scene_cache_directory();
+}
+
+std::string compute_scene_cache_path(const std::string& directory,
+                                     const std::string& scene_file,
+                                     std::uint64_t hash) {
+    //  TODO platform-dependent, Windows path behaviour is different.
+    return util::build_string(directory,
+                              '/',
+                              compute_entry_prefix(scene_file),
+                              to_hex(hash),
+                              entry_suffix);
+}
+
+void remove_stale_scene_cache_entries(const std::string& directory,
+                                      const std::string& scene_file,
+                                      std::uint64_t hash) {
+    struct close_directory final {
+        void operator()(DIR* d) const { closedir(d); }
+    };
+    const std::unique_ptr<DIR, close_directory> dir{opendir(directory.c_str())};
+    if (!dir) {
+        return;
+    }
+
+    const auto prefix = compute_entry_prefix(scene_file);
+    const auto current = prefix + to_hex(hash) + entry_suffix;
+
+    while (const auto item = readdir(dir.get())) {
+        const std::string name{item->d_name};
+        if (name.compare(0, prefix.size(), prefix) == 0 && name != current) {
+            std::remove(util::build_string(directory, '/', name).c_str());
+        }
+    }
+}
+
+void write_scene_cache(const std::string& fpath,
+                       const named_scene_data& scene,
+                       std::uint64_t hash) {
+    std::string surfaces;
+    for (const auto& name : scene.get_surfaces()) {
+        const auto length = static_cast<std::uint32_t>(name.size());
+        surfaces.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        surfaces.append(name);
+    }
+
+    header h{};
+    std::memcpy(h.magic, scene_cache_magic, sizeof(h.magic));
+    h.version = scene_cache_version;
+    h.hash = hash;
+    h.num_vertices = scene.get_vertices().size();
+    h.num_triangles = scene.get_triangles().size();
+    h.num_surfaces = scene.get_surfaces().size();
+    h.surface_bytes = surfaces.size();
+
+    const auto slash = fpath.find_last_of('/');
+    if (slash != std::string::npos && slash != 0) {
+        create_directories(fpath.substr(0, slash));
+    }
+
+    //  Write to a temporary file and then move it into place, so that a
+    //  failed write never leaves a truncated file behind.
+    const auto temporary = fpath + ".tmp";
+    {
+        std::ofstream os{temporary, std::ios::binary};
+        os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        write_array(os, scene.get_vertices());
+        write_array(os, scene.get_triangles());
+        os.write(surfaces.data(), surfaces.size());
+        if (!os.good()) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error{"Unable to write scene cache."};
+        }
+    }
+
+    if (std::rename(temporary.c_str(), fpath.c_str())) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error{"Unable to write scene cache."};
+    }
+}
+
+std::optional<named_scene_data> read_scene_cache(const std::string& fpath,
+                                                 std::uint64_t hash) {
+    const mapped_file file{fpath};
+    if (file.data() == nullptr || file.size() < sizeof(header)) {
+        return std::nullopt;
+    }
+
+    header h;
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (std::memcmp(h.magic, scene_cache_magic, sizeof(h.magic)) ||
+        h.version != scene_cache_version || h.hash != hash) {
+        return std::nullopt;
+    }
+
+    const auto vertex_bytes = h.num_vertices * sizeof(cl_float3);
+    const auto triangle_bytes = h.num_triangles * sizeof(triangle);
+    if (file.size() !=
+        sizeof(header) + vertex_bytes + triangle_bytes + h.surface_bytes) {
+        return std::nullopt;
+    }
+
+    auto ptr = file.data() + sizeof(header);
+    auto vertices = read_array<cl_float3>(ptr, h.num_vertices);
+    ptr += vertex_bytes;
+    auto triangles = read_array<triangle>(ptr, h.num_triangles);
+    ptr += triangle_bytes;
+
+    util::aligned::vector<std::string> surfaces;
+    surfaces.reserve(h.num_surfaces);
+    const auto end = ptr + h.surface_bytes;
+    while (surfaces.size() != h.num_surfaces) {
+        std::uint32_t length{};
+        if (static_cast<size_t>(end - ptr) < sizeof(length)) {
+            return std::nullopt;
+        }
+        std::memcpy(&length, ptr, sizeof(length));
+        ptr += sizeof(length);
+        if (static_cast<size_t>(end - ptr) < length) {
+            return std::nullopt;
+        }
+        surfaces.emplace_back(ptr, length);
+        ptr += length;
+    }
+
+    try {
+        //  Checks that all the indices are in range.
+        return make_scene_data(
+                std::move(triangles), std::move(vertices), std::move(surfaces));
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+}  // namespace core
+}  // namespace wayverb
@@ -1,5 +1,6 @@
 #include "core/scene_data_loader.h"
 #include "core/conversions.h"
+#include "core/scene_cache.h"
 #include "core/scene_data.h"
 
 #include "utilities/map_to_vector.h"
@@ -13,12 +14,14 @@
 namespace wayverb {
 namespace core {
 
+namespace {
+constexpr auto import_flags =
+        aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs;
+}  // namespace
+
 class scene_data_loader::impl final {
     auto load_from_file(const std::string& scene_file) {
-        const auto scene = importer_.ReadFile(
-                scene_file,
-                (aiProcess_Triangulate | aiProcess_GenSmoothNormals |
-                 aiProcess_FlipUVs));
+        const auto scene = importer_.ReadFile(scene_file, import_flags);
 
         if (scene == nullptr) {
             throw std::runtime_error{util::build_string(
@@ -76,11 +79,56 @@ public:
 
     impl(const std::string& f) { load(f); }
 
-    void load(const std::string& f) { data_ = load_from_file(f); }
+    /// Importing large models is slow, so a binary copy of each imported
+    /// scene is kept in the per-user scene cache, and used instead whenever
+    /// the original hasn't changed.
+    void load(const std::string& f) {
+        const auto hash = compute_scene_file_hash(f);
+        const auto cache_directory = get_scene_cache_directory();
+
+        importer_.FreeScene();
+        source_ = f;
+
+        if (cache_directory.empty()) {
+            data_ = load_from_file(f);
+            return;
+        }
+
+        const auto cache_path =
+                compute_scene_cache_path(cache_directory, f, hash);
+
+        if (auto cached = read_scene_cache(cache_path, hash)) {
+            data_ = std::move(*cached);
+            return;
+        }
+
+        data_ = load_from_file(f);
+
+        try {
+            write_scene_cache(cache_path, *data_, hash);
+            remove_stale_scene_cache_entries(cache_directory, f, hash);
+        } catch (const std::exception&) {
+            //  The folder might not be writable, but the scene is still
+            //  usable.
+        }
+    }
 
     void save(const std::string& f) const {
         if (data_) {
-            Assimp::Exporter().Export(importer_.GetScene(), "obj", f);
+            if (const auto scene = importer_.GetScene()) {
+                Assimp::Exporter().Export(scene, "obj", f);
+            } else {
+                //  The scene came from the cache, so we have to import the
+                //  original to export it.
+                Assimp::Importer importer;
+                const auto imported = importer.ReadFile(source_, import_flags);
+                if (imported == nullptr) {
+                    throw std::runtime_error{util::build_string(
+                            "Couldn't load scene.\n",
+                            importer.GetErrorString())};
+                }
+                Assimp::Exporter().Export(imported, "obj", f);
+            }
         }
     }
 
@@ -88,7 +136,10 @@ public:
         return data_;
     }
 
-    void clear() { data_ = std::nullopt; };
+    void clear() {
+        data_ = std::nullopt;
+        source_.clear();
+    };
 
     std::string get_extensions() const {
         aiString str;
@@ -98,6 +149,7 @@ public:
 
 private:
     Assimp::Importer importer_;
+    std::string source_;
     std::optional<scene_data> data_;
 };
 
@@ -0,0 +1,444 @@
+#include "core/scene_simplification.h"
+
+#include "utilities/aligned/unordered_map.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace wayverb {
+namespace core {
+
+namespace {
+
+/// Used to decide whether a quantity is 'zero', relative to the size of the
+/// things being compared.
+constexpr auto relative_epsilon = 1.0e-6f;
+
+struct cell_hash final {
+    size_t operator()(const glm::ivec3& i) const {
+        return (i.x * 73856093u) ^ (i.y * 19349663u) ^ (i.z * 83492791u);
+    }
+};
+
+/// Maps each vertex to the first vertex within `tolerance` of it.
+util::aligned::vector<cl_uint> weld_vertices(
+        const util::aligned::vector<glm::vec3>& vertices, float tolerance) {
+    //  Bucket the vertices so that each vertex only has to be compared
+    //  against the vertices in neighbouring cells.
+    const auto cell_size = 0 < tolerance ? tolerance : 1.0f;
+    util::aligned::unordered_map<glm::ivec3,
+                                 util::aligned::vector<cl_uint>,
+                                 cell_hash>
+            cells;
+
+    util::aligned::vector<cl_uint> ret(vertices.size());
+    for (auto i = 0u; i != vertices.size(); ++i) {
+        const auto& v = vertices[i];
+        const glm::ivec3 cell{glm::floor(v / cell_size)};
+
+        ret[i] = i;
+        auto found = false;
+        for (auto x = -1; x <= 1 && !found; ++x) {
+            for (auto y = -1; y <= 1 && !found; ++y) {
+                for (auto z = -1; z <= 1 && !found; ++z) {
+                    const auto it = cells.find(cell + glm::ivec3{x, y, z});
+                    if (it == cells.end()) {
+                        continue;
+                    }
+                    for (const auto j : it->second) {
+                        if (glm::distance(v, vertices[j]) <= tolerance) {
+                            ret[i] = j;
+                            found = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (!found) {
+            cells[cell].emplace_back(i);
+        }
+    }
+    return ret;
+}
+
+glm::vec3 unnormalised_normal(const util::aligned::vector<glm::vec3>& v,
+                              const triangle& t) {
+    return glm::cross(v[t.v1] - v[t.v0], v[t.v2] - v[t.v0]);
+}
+
+bool is_degenerate(const util::aligned::vector<glm::vec3>& v,
+                   const triangle& t) {
+    if (t.v0 == t.v1 || t.v1 == t.v2 || t.v2 == t.v0) {
+        return true;
+    }
+    const auto longest = std::max({glm::distance(v[t.v0], v[t.v1]),
+                                   glm::distance(v[t.v1], v[t.v2]),
+                                   glm::distance(v[t.v2], v[t.v0])});
+    return glm::length(unnormalised_normal(v, t)) <=
+           relative_epsilon * longest * longest;
+}
+
+float cross_2d(const glm::vec2& a, const glm::vec2& b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+/// Removes vertices from flat regions, one at a time, by deleting the
+/// triangles which use the vertex and retriangulating the hole which is
+/// left.
+class vertex_remover final {
+public:
+    vertex_remover(const util::aligned::vector<glm::vec3>& vertices,
+                   util::aligned::vector<triangle> triangles,
+                   float tolerance)
+            : vertices_{vertices}
+            , tolerance_{tolerance}
+            , triangles_{std::move(triangles)}
+            , alive_(triangles_.size(), true)
+            , incident_(vertices.size()) {
+        for (auto i = 0u; i != triangles_.size(); ++i) {
+            add_incident(i);
+        }
+    }
+
+    util::aligned::vector<triangle> run() {
+        //  Removing a vertex changes the neighbourhoods of the vertices
+        //  around it, so keep going until nothing changes.
+        for (auto changed = true; changed;) {
+            changed = false;
+            for (auto i = 0u; i != vertices_.size(); ++i) {
+                changed = try_remove(i) || changed;
+            }
+        }
+
+        util::aligned::vector<triangle> ret;
+        for (auto i = 0u; i != triangles_.size(); ++i) {
+            if (alive_[i]) {
+                ret.emplace_back(triangles_[i]);
+            }
+        }
+        return ret;
+    }
+
+private:
+    /// A triangle touching the vertex being removed, as the edge opposite
+    /// that vertex.
+    struct fan_edge final {
+        cl_uint a;
+        cl_uint b;
+    };
+
+    /// A set of coplanar triangles with the same surface, all touching the
+    /// vertex being removed.
+    struct region final {
+        cl_uint surface;
+        glm::vec3 normal;
+        util::aligned::vector<fan_edge> fan;
+    };
+
+    void add_incident(size_t index) {
+        const auto& t = triangles_[index];
+        for (const auto v : {t.v0, t.v1, t.v2}) {
+            incident_[v].emplace_back(index);
+        }
+    }
+
+    float tolerance_for(float length) const {
+        return std::max(tolerance_, relative_epsilon * length);
+    }
+
+    bool is_in_plane(cl_uint centre,
+                     const glm::vec3& normal,
+                     cl_uint point) const {
+        const auto d = vertices_[point] - vertices_[centre];
+        return std::abs(glm::dot(normal, d)) <= tolerance_for(glm::length(d));
+    }
+
+    /// True if `point` lies within the segment from `a` to `b`.
+    bool is_on_segment(cl_uint point, cl_uint a, cl_uint b) const {
+        const auto d = vertices_[b] - vertices_[a];
+        const auto length_squared = glm::dot(d, d);
+        const auto t =
+                glm::dot(vertices_[point] - vertices_[a], d) / length_squared;
+        return 0 < t && t < 1 &&
+               glm::distance(vertices_[point], vertices_[a] + t * d) <=
+                       tolerance_for(std::sqrt(length_squared));
+    }
+
+    /// Finds the outline of a fan of triangles, in order.
+    /// If the fan goes all the way around the centre vertex, `closed` is set
+    /// and the first vertex is not repeated at the end.
+    /// Returns false if the fan is not a single connected strip.
+    static bool find_outline(const util::aligned::vector<fan_edge>& fan,
+                             util::aligned::vector<cl_uint>& outline,
+                             bool& closed) {
+        const auto find_from = [&](cl_uint a) {
+            return std::find_if(begin(fan), end(fan), [&](const auto& e) {
+                return e.a == a;
+            });
+        };
+
+        //  Each vertex must start at most one edge.
+        for (auto i = begin(fan); i != end(fan); ++i) {
+            if (std::find_if(begin(fan), i, [&](const auto& e) {
+                    return e.a == i->a;
+                }) != i) {
+                return false;
+            }
+        }
+
+        //  An open strip starts at the only vertex which doesn't end an edge.
+        auto start = fan.front().a;
+        auto starts = 0u;
+        for (const auto& e : fan) {
+            if (std::none_of(begin(fan), end(fan), [&](const auto& f) {
+                    return f.b == e.a;
+                })) {
+                start = e.a;
+                starts += 1;
+            }
+        }
+        if (1 < starts) {
+            return false;
+        }
+        closed = starts == 0;
+
+        outline.clear();
+        outline.emplace_back(start);
+        for (auto i = 0u; i != fan.size(); ++i) {
+            const auto next = find_from(outline.back());
+            if (next == end(fan)) {
+                return false;
+            }
+            outline.emplace_back(next->b);
+        }
+
+        if (closed) {
+            if (outline.back() != outline.front()) {
+                return false;
+            }
+            outline.pop_back();
+        }
+        return true;
+    }
+
+    /// Ear-clipping triangulation of a simple polygon, wound anticlockwise
+    /// around `normal`.
+    /// Returns false if the polygon couldn't be triangulated without
+    /// creating degenerate triangles.
+    bool triangulate(const util::aligned::vector<cl_uint>& polygon,
+                     const glm::vec3& normal,
+                     cl_uint surface,
+                     util::aligned::vector<triangle>& output) const {
+        //  Project into the plane of the polygon.
+        const auto u = glm::normalize(
+                std::abs(normal.x) < 0.9f
+                        ? glm::cross(normal, glm::vec3{1, 0, 0})
+                        : glm::cross(normal, glm::vec3{0, 1, 0}));
+        const auto w = glm::cross(normal, u);
+
+        struct point final {
+            cl_uint index;
+            glm::vec2 position;
+        };
+
+        auto remaining = util::map_to_vector(
+                begin(polygon), end(polygon), [&](auto i) {
+                    const auto& v = vertices_[i];
+                    return point{i, glm::vec2{glm::dot(v, u), glm::dot(v, w)}};
+                });
+
+        const auto is_convex = [](const auto& a, const auto& b, const auto& c) {
+            const auto ab = b.position - a.position;
+            const auto bc = c.position - b.position;
+            return relative_epsilon * glm::length(ab) * glm::length(bc) <
+                   cross_2d(ab, bc);
+        };
+
+        //  Points on the boundary count as inside, so that no vertex is
+        //  left in the middle of a new edge.
+        const auto is_inside = [](const auto& p,
+                                  const auto& a,
+                                  const auto& b,
+                                  const auto& c) {
+            const auto side = [&](const auto& x, const auto& y) {
+                const auto xy = y.position - x.position;
+                const auto xp = p.position - x.position;
+                return -relative_epsilon * glm::length(xy) * glm::length(xp) <=
+                       cross_2d(xy, xp);
+            };
+            return side(a, b) && side(b, c) && side(c, a);
+        };
+
+        while (3 < remaining.size()) {
+            const auto size = remaining.size();
+            auto clipped = false;
+            for (auto i = 0u; i != size && !clipped; ++i) {
+                const auto& a = remaining[(i + size - 1) % size];
+                const auto& b = remaining[i];
+                const auto& c = remaining[(i + 1) % size];
+
+                if (!is_convex(a, b, c) ||
+                    std::any_of(begin(remaining),
+                                end(remaining),
+                                [&](const auto& p) {
+                                    return p.index != a.index &&
+                                           p.index != b.index &&
+                                           p.index != c.index &&
+                                           is_inside(p, a, b, c);
+                                })) {
+                    continue;
+                }
+
+                output.emplace_back(
+                        triangle{surface, a.index, b.index, c.index});
+                remaining.erase(begin(remaining) + i);
+                clipped = true;
+            }
+
+            if (!clipped) {
+                return false;
+            }
+        }
+
+        if (!is_convex(remaining[0], remaining[1], remaining[2])) {
+            return false;
+        }
+        output.emplace_back(triangle{surface,
+                                     remaining[0].index,
+                                     remaining[1].index,
+                                     remaining[2].index});
+        return true;
+    }
+
+    /// Returns true if the vertex was removed.
+    bool try_remove(cl_uint centre) {
+        auto& incident = incident_[centre];
+        incident.erase(std::remove_if(begin(incident),
+                                      end(incident),
+                                      [&](auto i) { return !alive_[i]; }),
+                       end(incident));
+        if (incident.empty()) {
+            return false;
+        }
+
+        //  Sort the surrounding triangles into flat regions.
+        //  Only vertices inside a single region, or on a straight edge
+        //  between two regions, can be removed.
+        util::aligned::vector<region> regions;
+        for (const auto i : incident) {
+            const auto& t = triangles_[i];
+            const auto edge =
+                    t.v0 == centre
+                            ? fan_edge{t.v1, t.v2}
+                            : t.v1 == centre ? fan_edge{t.v2, t.v0}
+                                             : fan_edge{t.v0, t.v1};
+            const auto normal =
+                    glm::normalize(unnormalised_normal(vertices_, t));
+
+            const auto it =
+                    std::find_if(begin(regions), end(regions), [&](auto& r) {
+                        return r.surface == t.surface &&
+                               0 < glm::dot(r.normal, normal) &&
+                               is_in_plane(centre, r.normal, edge.a) &&
+                               is_in_plane(centre, r.normal, edge.b);
+                    });
+
+            if (it != end(regions)) {
+                it->fan.emplace_back(edge);
+            } else if (regions.size() < 2) {
+                regions.emplace_back(region{t.surface, normal, {edge}});
+            } else {
+                return false;
+            }
+        }
+
+        util::aligned::vector<util::aligned::vector<cl_uint>> outlines(
+                regions.size());
+        util::aligned::vector<bool> closed(regions.size());
+        for (auto i = 0u; i != regions.size(); ++i) {
+            auto c = false;
+            if (!find_outline(regions[i].fan, outlines[i], c)) {
+                return false;
+            }
+            closed[i] = c;
+        }
+
+        //  If a region doesn't go all the way around the vertex, the vertex
+        //  is on its edge, and can only be removed if that edge is straight.
+        const auto is_removable = [&] {
+            if (regions.size() == 1) {
+                return closed[0] ||
+                       is_on_segment(centre,
+                                     outlines[0].back(),
+                                     outlines[0].front());
+            }
+            return !closed[0] && !closed[1] &&
+                   outlines[0].back() == outlines[1].front() &&
+                   outlines[1].back() == outlines[0].front() &&
+                   is_on_segment(
+                           centre, outlines[0].back(), outlines[0].front());
+        };
+
+        if (!is_removable()) {
+            return false;
+        }
+
+        util::aligned::vector<triangle> replacements;
+        for (auto i = 0u; i != regions.size(); ++i) {
+            if (!triangulate(outlines[i],
+                             regions[i].normal,
+                             regions[i].surface,
+                             replacements)) {
+                return false;
+            }
+        }
+
+        for (const auto i : incident) {
+            alive_[i] = false;
+        }
+        incident.clear();
+
+        for (const auto& t : replacements) {
+            triangles_.emplace_back(t);
+            alive_.emplace_back(true);
+            add_incident(triangles_.size() - 1);
+        }
+
+        return true;
+    }
+
+    const util::aligned::vector<glm::vec3>& vertices_;
+    float tolerance_;
+
+    util::aligned::vector<triangle> triangles_;
+    util::aligned::vector<bool> alive_;
+
+    /// The triangles touching each vertex.
+    /// Dead triangles are removed lazily.
+    util::aligned::vector<util::aligned::vector<size_t>> incident_;
+};
+
+}  // namespace
+
+util::aligned::vector<triangle> simplify_triangles(
+        const util::aligned::vector<glm::vec3>& vertices,
+        const util::aligned::vector<triangle>& triangles,
+        float tolerance) {
+    const auto welded = weld_vertices(vertices, tolerance);
+
+    util::aligned::vector<triangle> remapped;
+    remapped.reserve(triangles.size());
+    for (const auto& t : triangles) {
+        const triangle w{t.surface, welded[t.v0], welded[t.v1], welded[t.v2]};
+        if (!is_degenerate(vertices, w)) {
+            remapped.emplace_back(w);
+        }
+    }
+
+    return vertex_remover{vertices, std::move(remapped), tolerance}.run();
+}
+
+}  // namespace core
+}  // namespace wayverb
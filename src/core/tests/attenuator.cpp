@@ -173,3 +173,26 @@ TEST(attenuator, hrtf_ear_position) {
          attenuator::hrtf::channel::right,
          glm::vec3{0, 0, -radius});
 }
+
+TEST(attenuator, microphone_components) {
+    const glm::vec3 directions[]{{1, 0, 0},
+                                 {0, -2, 0},
+                                 {0.3f, 0.4f, -0.5f},
+                                 {-1, -1, 1},
+                                 {0, 0, 0}};
+
+    for (const auto shape : {0.0f, 0.25f, 0.5f, 0.75f, 1.0f}) {
+        const attenuator::microphone mic{orientation{{1, 2, -1}}, shape};
+        const auto weights = component_weights(mic);
+
+        for (const auto& direction : directions) {
+            auto mixed = 0.0f;
+            for (auto axis = 0ul; axis != weights.size(); ++axis) {
+                mixed += weights[axis] *
+                         attenuation(attenuator::microphone_component{axis},
+                                     direction);
+            }
+            ASSERT_NEAR(mixed, attenuation(mic, direction), 0.00001);
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include "core/biquad_bank.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <random>
+
+using namespace wayverb::core;
+
+namespace {
+
+constexpr auto sample_rate = 44100.0;
+constexpr auto lanes = simulation_bands;
+
+auto white_noise(size_t frames) {
+    std::default_random_engine engine{std::random_device{}()};
+    std::uniform_real_distribution<float> distribution(-1, 1);
+    util::aligned::vector<float> ret(frames * lanes);
+    for (auto& i : ret) {
+        i = distribution(engine);
+    }
+    return ret;
+}
+
+/// A two-stage bandpass in each lane, with a different band per lane.
+auto compute_coefficients() {
+    std::array<std::array<filter::biquad::coefficients, lanes>, 2> ret;
+    for (auto i = 0ul; i != lanes; ++i) {
+        const auto lo = 40.0 * std::pow(2.0, i);
+        ret[0][i] = filter::compute_linkwitz_riley_hipass_coefficients(
+                lo, sample_rate);
+        ret[1][i] = filter::compute_linkwitz_riley_lopass_coefficients(
+                lo * 2, sample_rate);
+    }
+    return ret;
+}
+
+/// The same filtering, one lane at a time, with scalar double-precision
+/// biquads.
+template <typename Pass>
+auto reference(const util::aligned::vector<float>& interleaved,
+               const Pass& pass) {
+    const auto coefficients = compute_coefficients();
+    const auto frames = interleaved.size() / lanes;
+    auto ret = interleaved;
+    for (auto i = 0ul; i != lanes; ++i) {
+        util::aligned::vector<float> lane(frames);
+        for (auto j = 0ul; j != frames; ++j) {
+            lane[j] = interleaved[j * lanes + i];
+        }
+        auto filt = filter::make_series_biquads(
+                std::array<filter::biquad::coefficients, 2>{
+                        {coefficients[0][i], coefficients[1][i]}});
+        pass(filt, lane.begin(), lane.end());
+        for (auto j = 0ul; j != frames; ++j) {
+            ret[j * lanes + i] = lane[j];
+        }
+    }
+    return ret;
+}
+
+}  // namespace
+
+TEST(biquad_bank, one_pass) {
+    const auto noise = white_noise(10000);
+    const auto expected = reference(noise, [](auto& f, auto b, auto e) {
+        filter::run_one_pass(f, b, e);
+    });
+
+    auto bank = filter::biquad_bank<2>{compute_coefficients()};
+    auto interleaved = noise;
+    filter::run_one_pass(bank, interleaved.data(), interleaved.size() / lanes);
+
+    for (auto i = 0ul; i != expected.size(); ++i) {
+        ASSERT_NEAR(interleaved[i], expected[i], 1.0e-4);
+    }
+}
+
+TEST(biquad_bank, two_pass) {
+    const auto noise = white_noise(10000);
+    const auto expected = reference(noise, [](auto& f, auto b, auto e) {
+        filter::run_two_pass(f, b, e);
+    });
+
+    auto bank = filter::biquad_bank<2>{compute_coefficients()};
+    auto interleaved = noise;
+    filter::run_two_pass(bank, interleaved.data(), interleaved.size() / lanes);
+
+    for (auto i = 0ul; i != expected.size(); ++i) {
+        ASSERT_NEAR(interleaved[i], expected[i], 1.0e-4);
+    }
+
+    //  The generic iterator version works with bands_type frames.
+    util::aligned::vector<bands_type> frames(noise.size() / lanes);
+    for (auto i = 0ul; i != frames.size(); ++i) {
+        std::copy(noise.begin() + i * lanes,
+                  noise.begin() + (i + 1) * lanes,
+                  frames[i].s);
+    }
+    filter::run_two_pass(bank, frames.begin(), frames.end());
+    for (auto i = 0ul; i != frames.size(); ++i) {
+        for (auto j = 0ul; j != lanes; ++j) {
+            ASSERT_EQ(frames[i].s[j], interleaved[i * lanes + j]);
+        }
+    }
+}
+
+TEST(biquad_bank, benchmark) {
+    const auto noise = white_noise(sample_rate * 10);
+
+    const auto time = [](const auto& callback) {
+        const auto start = std::chrono::steady_clock::now();
+        callback();
+        return std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                .count();
+    };
+
+    const auto scalar = time([&] {
+        reference(noise, [](auto& f, auto b, auto e) {
+            filter::run_two_pass(f, b, e);
+        });
+    });
+
+    auto interleaved = noise;
+    const auto bank_time = time([&] {
+        auto bank = filter::biquad_bank<2>{compute_coefficients()};
+        filter::run_two_pass(
+                bank, interleaved.data(), interleaved.size() / lanes);
+    });
+
+    std::cout << "scalar: " << scalar << " s, bank: " << bank_time << " s\n";
+}
@@ -11,6 +11,7 @@
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <chrono>
 #include <random>
 
 using namespace wayverb::core;
@@ -366,3 +367,115 @@ TEST(dc_blocker, increasing_offset) {
         }
     }
 }
+
+namespace {
+
+template <typename Blocker, typename Block>
+void test_block_equivalence(const Block& block) {
+    constexpr auto channels = 3;
+    const auto d = 100;
+    const auto noise = generate_noise(10000 * channels, 1.0f);
+
+    auto interleaved = noise;
+    block(interleaved.data(), noise.size() / channels, channels, d);
+
+    for (auto channel = 0; channel != channels; ++channel) {
+        Blocker blocker{d};
+        for (auto i = 0ul + channel; i < noise.size(); i += channels) {
+            ASSERT_EQ(interleaved[i],
+                      static_cast<float>(blocker.filter(noise[i])));
+        }
+    }
+}
+
+}  // namespace
+
+TEST(dc_blocker, block_linear) {
+    test_block_equivalence<filter::linear_dc_blocker>(
+            [](auto... params) { filter::run_linear_dc_blocker(params...); });
+}
+
+TEST(dc_blocker, block_extra_linear) {
+    test_block_equivalence<filter::extra_linear_dc_blocker>([](auto... params) {
+        filter::run_extra_linear_dc_blocker(params...);
+    });
+}
+
+TEST(dc_blocker, block_zero_phase) {
+    const auto d = 16;
+    for (const auto& pair :
+         {std::make_pair(filter::run_linear_dc_blocker_zero_phase, d - 1),
+          std::make_pair(filter::run_extra_linear_dc_blocker_zero_phase,
+                         2 * (d - 1))}) {
+        //  The impulse response is symmetric about the impulse.
+        auto impulse = generate_impulse(1001);
+        pair.first(impulse.data(), impulse.size(), 1, d);
+
+        const auto centre = impulse.size() / 2;
+        for (auto i = 1; i != pair.second * 2; ++i) {
+            ASSERT_NEAR(impulse[centre - i], impulse[centre + i], 1.0e-7);
+        }
+        ASSERT_LT(0, impulse[centre]);
+
+        //  Dc is removed.
+        util::aligned::vector<float> offset(1000, 1.0f);
+        pair.first(offset.data(), offset.size(), 1, d);
+        for (auto i = 2ul * pair.second; i != offset.size() - 2 * pair.second;
+             ++i) {
+            ASSERT_NEAR(offset[i], 0, 1.0e-6);
+        }
+    }
+}
+
+TEST(dc_blocker, block_bands) {
+    const auto noise = generate_noise(10000);
+
+    util::aligned::vector<bands_type> bands(noise.size());
+    for (auto i = 0ul; i != noise.size(); ++i) {
+        bands[i] = make_bands_type(noise[i]);
+    }
+    filter::run_per_band(bands, filter::run_linear_dc_blocker);
+
+    filter::linear_dc_blocker blocker;
+    for (auto i = 0ul; i != noise.size(); ++i) {
+        const auto expected = static_cast<float>(blocker.filter(noise[i]));
+        for (auto band = 0; band != simulation_bands; ++band) {
+            ASSERT_EQ(bands[i].s[band], expected);
+        }
+    }
+}
+
+TEST(dc_blocker, block_benchmark) {
+    const auto sample_rate = 44100;
+
+    const auto time = [](const auto& callback) {
+        const auto start = std::chrono::steady_clock::now();
+        callback();
+        return std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                .count();
+    };
+
+    for (const auto channels : {1, simulation_bands}) {
+        const auto noise = generate_noise(sample_rate * 10 * channels);
+
+        const auto per_sample = time([&] {
+            for (auto c = 0; c != channels; ++c) {
+                filter::extra_linear_dc_blocker blocker;
+                for (auto i = 0ul + c; i < noise.size(); i += channels) {
+                    blocker.filter(noise[i]);
+                }
+            }
+        });
+
+        auto block_input = noise;
+        const auto block = time([&] {
+            filter::run_extra_linear_dc_blocker(block_input.data(),
+                                                block_input.size() / channels,
+                                                channels);
+        });
+
+        std::cout << channels << " channels: per-sample: " << per_sample
+                  << " s, block: " << block << " s\n";
+    }
+}
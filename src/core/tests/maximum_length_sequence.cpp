@@ -2,7 +2,10 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <array>
+#include <numeric>
+#include <random>
 
 using namespace wayverb::core;
 
@@ -22,3 +25,90 @@ TEST(mls, order_4) {
         ASSERT_EQ(value, seq[step]) << step;
     });
 }
+
+TEST(mls, bulk) {
+    for (auto order : {2u, 3u, 8u, 16u}) {
+        const auto bulk = generate_bipolar_maximum_length_sequence(order);
+        ASSERT_EQ(bulk.size(), (1u << order) - 1);
+        generate_maximum_length_sequence<uint32_t>(
+                order, [&](auto value, auto step) {
+                    ASSERT_EQ(bulk[step], value ? -1.0f : 1.0f) << step;
+                });
+    }
+}
+
+TEST(mls, balanced) {
+    //  Every nonzero state is visited once per period, so an mls of order n
+    //  has exactly 2 ^ (n - 1) set bits.
+    for (auto order = 2u; order <= 22u; ++order) {
+        const auto bulk = generate_bipolar_maximum_length_sequence(order);
+        ASSERT_EQ(std::count(bulk.begin(), bulk.end(), -1.0f),
+                  1 << (order - 1))
+                << order;
+    }
+}
+
+namespace {
+
+/// Periodic excitation of a system, one period of output.
+auto excite(const util::aligned::vector<float>& sequence,
+            const util::aligned::vector<float>& ir) {
+    const auto length = sequence.size();
+    util::aligned::vector<float> ret(length, 0);
+    for (auto n = 0ul; n != length; ++n) {
+        double sum = 0;
+        for (auto j = 0ul; j != ir.size(); ++j) {
+            sum += ir[j] * sequence[(n + length - j % length) % length];
+        }
+        ret[n] = sum;
+    }
+    return ret;
+}
+
+auto random_ir(size_t length) {
+    std::default_random_engine engine{std::random_device{}()};
+    std::uniform_real_distribution<float> dist{-1, 1};
+    util::aligned::vector<float> ret(length);
+    auto envelope = 1.0f;
+    for (auto& i : ret) {
+        i = dist(engine) * envelope;
+        envelope *= 0.99f;
+    }
+    return ret;
+}
+
+}  // namespace
+
+TEST(mls, direct_correlation) {
+    for (auto order : {2u, 5u, 10u}) {
+        const mls_correlator correlator{order};
+        const auto& sequence = correlator.get_sequence();
+        const auto length = sequence.size();
+
+        const auto response = excite(sequence, random_ir(length));
+        const auto fast = correlator.correlate(response);
+
+        for (auto lag = 0ul; lag != length; ++lag) {
+            double direct = 0;
+            for (auto n = 0ul; n != length; ++n) {
+                direct += response[n] * sequence[(n + length - lag) % length];
+            }
+            direct /= length + 1;
+            ASSERT_NEAR(fast[lag], direct, 1.0e-4) << order << ", " << lag;
+        }
+    }
+}
+
+TEST(mls, recover_impulse_response) {
+    const mls_correlator correlator{16};
+    const auto ir = random_ir(500);
+    const auto response = excite(correlator.get_sequence(), ir);
+    const auto recovered = correlator.correlate(response);
+
+    const auto offset = std::accumulate(ir.begin(), ir.end(), 0.0) /
+                        (correlator.size() + 1);
+    for (auto i = 0ul; i != recovered.size(); ++i) {
+        const auto expected = i < ir.size() ? ir[i] : 0.0f;
+        ASSERT_NEAR(recovered[i], expected - offset, 1.0e-5) << i;
+    }
+}
@@ -141,3 +141,56 @@ TEST(reverb_time, sabine) {
         ASSERT_TRUE(all(t3 < t2));
     }
 }
+
+TEST(reverb_time, analytics) {
+    const auto check_geometry = [](const auto& scene) {
+        const auto geometry = compute_geometry_analytics(scene);
+        const auto total_area = area(scene);
+        ASSERT_NEAR(geometry.total_area, total_area, total_area * 0.0001);
+        ASSERT_NEAR(geometry.volume,
+                    estimate_room_volume(scene),
+                    geometry.volume * 0.0001);
+
+        ASSERT_EQ(geometry.surface_areas.size(), scene.get_surfaces().size());
+        for (auto i = 0u; i != scene.get_surfaces().size(); ++i) {
+            ASSERT_NEAR(geometry.surface_areas[i],
+                        area(scene, i),
+                        total_area * 0.0001);
+        }
+    };
+
+    for (const auto& box : test_boxes) {
+        check_geometry(geo::get_scene_data(box, 0));
+    }
+
+    for (const auto& fname : test_scenes) {
+        const scene_data_loader loader{fname};
+        check_geometry(*loader.get_scene_data());
+    }
+
+    const geo::box box{glm::vec3{0, 0, 0}, glm::vec3{5.56, 3.97, 2.81}};
+    auto scene = geo::get_scene_data(box, make_surface<1>(0.1, 0));
+    auto analytics = make_scene_analytics(scene);
+
+    const auto check_absorption = [&] {
+        const auto expected = absorption_area(scene, 0);
+        ASSERT_NEAR(analytics.get_equivalent_absorption_area().s[0],
+                    expected.s[0],
+                    0.0001);
+        ASSERT_NEAR(sabine_reverb_time(analytics, 0.0).s[0],
+                    sabine_reverb_time(scene, 0.0).s[0],
+                    0.0001);
+        ASSERT_NEAR(eyring_reverb_time(analytics, 0.0).s[0],
+                    eyring_reverb_time(scene, 0.0).s[0],
+                    0.0001);
+    };
+
+    check_absorption();
+
+    //  Changing the surfaces should only change the absorption.
+    scene.set_surfaces(make_surface<1>(0.5, 0));
+    analytics.set_surfaces(scene.get_surfaces());
+    check_absorption();
+
+    ASSERT_THROW(analytics.set_surfaces({}), std::runtime_error);
+}
@@ -0,0 +1,155 @@
+#include "core/scene_cache.h"
+#include "core/scene_data_loader.h"
+
+#include "utilities/string_builder.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <sstream>
+
+#ifndef TEST_MODELS
+#define TEST_MODELS ""
+#endif
+
+#ifndef SCRATCH_PATH
+#define SCRATCH_PATH ""
+#endif
+
+using namespace wayverb::core;
+
+namespace {
+
+/// CMake passes the test models as a single '|'-separated list.
+util::aligned::vector<std::string> get_test_models() {
+    util::aligned::vector<std::string> ret;
+    std::istringstream stream{TEST_MODELS};
+    for (std::string fpath; std::getline(stream, fpath, '|');) {
+        if (!fpath.empty()) {
+            ret.emplace_back(fpath);
+        }
+    }
+    return ret;
+}
+
+void check_equal(const named_scene_data& a, const named_scene_data& b) {
+    ASSERT_EQ(a.get_triangles().size(), b.get_triangles().size());
+    for (auto i = 0u; i != a.get_triangles().size(); ++i) {
+        const auto& x = a.get_triangles()[i];
+        const auto& y = b.get_triangles()[i];
+        ASSERT_EQ(x.surface, y.surface);
+        ASSERT_EQ(x.v0, y.v0);
+        ASSERT_EQ(x.v1, y.v1);
+        ASSERT_EQ(x.v2, y.v2);
+    }
+
+    ASSERT_EQ(a.get_vertices().size(), b.get_vertices().size());
+    for (auto i = 0u; i != a.get_vertices().size(); ++i) {
+        const auto& x = a.get_vertices()[i];
+        const auto& y = b.get_vertices()[i];
+        ASSERT_EQ(x.s[0], y.s[0]);
+        ASSERT_EQ(x.s[1], y.s[1]);
+        ASSERT_EQ(x.s[2], y.s[2]);
+    }
+
+    ASSERT_EQ(a.get_surfaces(), b.get_surfaces());
+}
+
+}  // namespace
+
+TEST(scene_cache, round_trip) {
+    const auto models = get_test_models();
+    ASSERT_FALSE(models.empty());
+
+    const auto previous_directory = get_scene_cache_directory();
+    const auto directory = util::build_string(SCRATCH_PATH, "/scene_cache");
+    set_scene_cache_directory(directory);
+
+    for (const auto& fpath : models) {
+        SCOPED_TRACE(fpath);
+
+        //  Remove any entry left by an earlier run, so that the first load
+        //  really imports the model.
+        const auto hash = compute_scene_file_hash(fpath);
+        const auto cache = compute_scene_cache_path(directory, fpath, hash);
+        std::remove(cache.c_str());
+
+        const scene_data_loader imported{fpath};
+        ASSERT_TRUE(imported.get_scene_data());
+        const auto& scene = *imported.get_scene_data();
+
+        //  The import should have been written to the cache.
+        const auto read = read_scene_cache(cache, hash);
+        ASSERT_TRUE(read);
+        check_equal(scene, *read);
+
+        //  The loader should produce the same scene from the cache.
+        const scene_data_loader reloaded{fpath};
+        ASSERT_TRUE(reloaded.get_scene_data());
+        check_equal(scene, *reloaded.get_scene_data());
+
+        std::remove(cache.c_str());
+    }
+
+    set_scene_cache_directory(previous_directory);
+}
+
+TEST(scene_cache, stale_entries) {
+    const auto cache = util::build_string(SCRATCH_PATH, "/scene_cache.bin");
+
+    const auto scene = make_scene_data(
+            util::aligned::vector<triangle>{{0, 0, 1, 2}},
+            util::aligned::vector<cl_float3>{
+                    {{0, 0, 0}}, {{1, 0, 0}}, {{0, 1, 0}}},
+            util::aligned::vector<std::string>{"surface"});
+
+    write_scene_cache(cache, scene, 1);
+    ASSERT_TRUE(read_scene_cache(cache, 1));
+    ASSERT_FALSE(read_scene_cache(cache, 2));
+
+    std::remove(cache.c_str());
+    ASSERT_FALSE(read_scene_cache(cache, 1));
+}
+
+TEST(scene_cache, cache_path) {
+    const auto path = compute_scene_cache_path("/cache", "/a/b/model.obj", 1);
+    ASSERT_EQ(path.compare(0, 7, "/cache/"), 0);
+
+    //  Models with the same name in different folders.
+    ASSERT_NE(path, compute_scene_cache_path("/cache", "/a/c/model.obj", 1));
+    ASSERT_NE(path, compute_scene_cache_path("/cache", "/a/b/model.dae", 1));
+
+    //  Different contents of the same model.
+    ASSERT_NE(path, compute_scene_cache_path("/cache", "/a/b/model.obj", 2));
+}
+
+TEST(scene_cache, remove_stale_entries) {
+    const auto directory =
+            util::build_string(SCRATCH_PATH, "/scene_cache_stale");
+
+    const auto scene = make_scene_data(
+            util::aligned::vector<triangle>{{0, 0, 1, 2}},
+            util::aligned::vector<cl_float3>{
+                    {{0, 0, 0}}, {{1, 0, 0}}, {{0, 1, 0}}},
+            util::aligned::vector<std::string>{"surface"});
+
+    const auto old_entry =
+            compute_scene_cache_path(directory, "/a/model.obj", 1);
+    const auto new_entry =
+            compute_scene_cache_path(directory, "/a/model.obj", 2);
+    const auto other_entry =
+            compute_scene_cache_path(directory, "/a/other.obj", 1);
+
+    write_scene_cache(old_entry, scene, 1);
+    write_scene_cache(new_entry, scene, 2);
+    write_scene_cache(other_entry, scene, 1);
+
+    remove_stale_scene_cache_entries(directory, "/a/model.obj", 2);
+
+    ASSERT_FALSE(read_scene_cache(old_entry, 1));
+    ASSERT_TRUE(read_scene_cache(new_entry, 2));
+    ASSERT_TRUE(read_scene_cache(other_entry, 1));
+
+    std::remove(new_entry.c_str());
+    std::remove(other_entry.c_str());
+}
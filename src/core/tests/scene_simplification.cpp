@@ -0,0 +1,158 @@
+#include "core/reverb_time.h"
+#include "core/scene_data_loader.h"
+#include "core/scene_simplification.h"
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+#ifndef TEST_MODELS
+#define TEST_MODELS ""
+#endif
+
+using namespace wayverb::core;
+
+namespace {
+
+/// A box where every face is split into a grid of quads, and every face has
+/// its own copy of the vertices along its edges, as exported by many CAD
+/// packages.
+auto make_subdivided_box(const glm::vec3& size, size_t divisions) {
+    util::aligned::vector<glm::vec3> vertices;
+    util::aligned::vector<triangle> triangles;
+
+    //  Each face is given by a corner and two edges, ordered so that the
+    //  normal points outwards.
+    const std::array<std::array<glm::vec3, 3>, 6> faces{{
+            {{glm::vec3{0, 0, 0}, glm::vec3{0, 1, 0}, glm::vec3{1, 0, 0}}},
+            {{glm::vec3{0, 0, 1}, glm::vec3{1, 0, 0}, glm::vec3{0, 1, 0}}},
+            {{glm::vec3{0, 0, 0}, glm::vec3{1, 0, 0}, glm::vec3{0, 0, 1}}},
+            {{glm::vec3{0, 1, 0}, glm::vec3{0, 0, 1}, glm::vec3{1, 0, 0}}},
+            {{glm::vec3{0, 0, 0}, glm::vec3{0, 0, 1}, glm::vec3{0, 1, 0}}},
+            {{glm::vec3{1, 0, 0}, glm::vec3{0, 1, 0}, glm::vec3{0, 0, 1}}},
+    }};
+
+    for (auto face = 0u; face != faces.size(); ++face) {
+        const auto& f = faces[face];
+        const auto base = vertices.size();
+        for (auto i = 0u; i <= divisions; ++i) {
+            for (auto j = 0u; j <= divisions; ++j) {
+                const auto u = i / static_cast<float>(divisions);
+                const auto v = j / static_cast<float>(divisions);
+                vertices.emplace_back((f[0] + u * f[1] + v * f[2]) * size);
+            }
+        }
+
+        const auto index = [&](auto i, auto j) {
+            return static_cast<cl_uint>(base + i * (divisions + 1) + j);
+        };
+
+        //  The last face has its own surface.
+        const auto surface = face == faces.size() - 1 ? 1u : 0u;
+        for (auto i = 0u; i != divisions; ++i) {
+            for (auto j = 0u; j != divisions; ++j) {
+                triangles.emplace_back(triangle{
+                        surface, index(i, j), index(i + 1, j), index(i, j + 1)});
+                triangles.emplace_back(triangle{surface,
+                                                index(i + 1, j),
+                                                index(i + 1, j + 1),
+                                                index(i, j + 1)});
+            }
+        }
+    }
+
+    return make_scene_data(std::move(triangles),
+                           std::move(vertices),
+                           util::aligned::vector<int>{0, 1});
+}
+
+util::aligned::vector<std::string> get_test_models() {
+    util::aligned::vector<std::string> ret;
+    std::istringstream stream{TEST_MODELS};
+    for (std::string fpath; std::getline(stream, fpath, '|');) {
+        if (!fpath.empty()) {
+            ret.emplace_back(fpath);
+        }
+    }
+    return ret;
+}
+
+}  // namespace
+
+TEST(scene_simplification, subdivided_box) {
+    const auto box = make_subdivided_box(glm::vec3{2, 3, 4}, 5);
+    ASSERT_EQ(box.get_triangles().size(), 6 * 5 * 5 * 2);
+
+    const auto simplified = simplify_scene(box);
+    ASSERT_EQ(simplified.get_triangles().size(), 12);
+    ASSERT_EQ(simplified.get_vertices().size(), 8);
+    ASSERT_EQ(simplified.get_surfaces(), box.get_surfaces());
+
+    ASSERT_TRUE(triangles_are_oriented(begin(simplified.get_triangles()),
+                                       end(simplified.get_triangles())));
+
+    ASSERT_NEAR(area(simplified), area(box), 0.0001);
+    ASSERT_NEAR(area(simplified, 1), area(box, 1), 0.0001);
+    ASSERT_NEAR(estimate_room_volume(simplified), 24, 0.0001);
+}
+
+TEST(scene_simplification, welding) {
+    //  Two triangles which should share an edge, but don't quite.
+    const auto scene = make_scene_data(
+            util::aligned::vector<triangle>{{0, 0, 1, 2}, {0, 3, 4, 5}},
+            util::aligned::vector<glm::vec3>{{0, 0, 0},
+                                             {1, 0, 0},
+                                             {0, 1, 0},
+                                             {1.00001f, 0, 0},
+                                             {1, 1, 0},
+                                             {0, 1.00001f, 0}},
+            util::aligned::vector<int>{0});
+
+    const auto simplified = simplify_scene(scene, 0.001f);
+    ASSERT_EQ(simplified.get_triangles().size(), 2);
+    ASSERT_EQ(simplified.get_vertices().size(), 4);
+}
+
+TEST(scene_simplification, degenerate_triangles) {
+    const auto scene = make_scene_data(
+            util::aligned::vector<triangle>{
+                    {0, 0, 1, 2}, {0, 0, 1, 1}, {0, 0, 1, 3}},
+            util::aligned::vector<glm::vec3>{
+                    {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {2, 0, 0}},
+            util::aligned::vector<int>{0});
+
+    const auto simplified = simplify_scene(scene);
+    ASSERT_EQ(simplified.get_triangles().size(), 1);
+    ASSERT_EQ(simplified.get_vertices().size(), 3);
+}
+
+TEST(scene_simplification, test_models) {
+    const auto models = get_test_models();
+    ASSERT_FALSE(models.empty());
+
+    for (const auto& fpath : models) {
+        SCOPED_TRACE(fpath);
+
+        const scene_data_loader loader{fpath};
+        ASSERT_TRUE(loader.get_scene_data());
+        const auto& scene = *loader.get_scene_data();
+
+        const auto simplified = simplify_scene(scene);
+        ASSERT_LE(simplified.get_triangles().size(),
+                  scene.get_triangles().size());
+
+        const auto original_area = area(scene);
+        ASSERT_NEAR(area(simplified), original_area, original_area * 0.001);
+
+        const auto original_volume = estimate_room_volume(scene);
+        ASSERT_NEAR(estimate_room_volume(simplified),
+                    original_volume,
+                    original_volume * 0.001);
+
+        for (auto i = 0u; i != scene.get_surfaces().size(); ++i) {
+            ASSERT_NEAR(area(simplified, i),
+                        area(scene, i),
+                        original_area * 0.001);
+        }
+    }
+}
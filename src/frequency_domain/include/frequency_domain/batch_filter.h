@@ -0,0 +1,96 @@
+#pragma once
+
+#include "frequency_domain/buffer.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace frequency_domain {
+
+/// Filters several channels at once, each with its own real magnitude
+/// response.
+/// The forward and inverse transforms for all channels are each run as a
+/// single batched plan.
+/// Like filter, all fftw linkage is kept internal.
+class batch_filter final {
+public:
+    batch_filter(size_t signal_length, size_t channels);
+
+    batch_filter(const batch_filter&) = delete;
+    batch_filter& operator=(const batch_filter&) = delete;
+    batch_filter(batch_filter&&) = delete;
+    batch_filter& operator=(batch_filter&&) = delete;
+
+    ~batch_filter() noexcept;
+
+    size_t get_signal_length() const;
+    size_t get_channels() const;
+
+    /// The number of frequency bins per channel.
+    size_t get_bins() const;
+
+    /// Load a channel of input, which will be zero-padded to the signal
+    /// length.
+    template <typename In>
+    void set_channel(size_t channel, In begin, In end) {
+        const auto dist = std::distance(begin, end);
+        if (get_signal_length() < static_cast<size_t>(dist)) {
+            throw std::runtime_error{"Filter input signal is too long."};
+        }
+        const auto b = channel_begin(channel);
+        const auto e = std::copy(begin, end, b);
+        std::fill(e, b + get_signal_length(), 0.0f);
+    }
+
+    /// Transform all channels, multiply each spectrum by its magnitude
+    /// response, and transform back.
+    /// `masks` holds get_bins() magnitudes for each channel, contiguously.
+    /// Returns the sum of squared magnitudes of each filtered spectrum.
+    std::vector<double> run(const float* masks);
+
+    /// Copy the first `length` samples of filtered output for a channel.
+    template <typename Out>
+    void get_channel(size_t channel, Out output_it, size_t length) const {
+        const auto b = channel_begin(channel);
+        std::copy(b, b + length, output_it);
+    }
+
+private:
+    float* channel_begin(size_t channel);
+    const float* channel_begin(size_t channel) const;
+
+    size_t signal_length_;
+    size_t channels_;
+    rbuf rbuf_;
+
+    class impl;
+    std::unique_ptr<impl> pimpl_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Magnitude responses for a bank of band-pass filters, sampled at each bin
+/// of a real transform.
+struct band_masks final {
+    size_t bins;
+
+    /// `bins` magnitudes for each band, stored contiguously.
+    std::vector<float> magnitudes;
+
+    /// The area under each mask.
+    std::vector<double> integrated;
+};
+
+/// Find the band masks for a transform length and set of band parameters.
+/// Masks are cached, so repeated calls with the same parameters are cheap.
+/// Safe to call from multiple threads.
+std::shared_ptr<const band_masks> get_band_masks(size_t transform_length,
+                                                 const double* edges,
+                                                 size_t bands,
+                                                 double width_factor,
+                                                 size_t l);
+
+}  // namespace frequency_domain
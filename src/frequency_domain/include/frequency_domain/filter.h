@@ -2,8 +2,10 @@
 
 #include "frequency_domain/buffer.h"
 
+#include <algorithm>
 #include <complex>
 #include <functional>
+#include <iterator>
 #include <stdexcept>
 
 namespace frequency_domain {
@@ -53,10 +55,41 @@ public:
         }
     }
 
+    /// Transform an input signal and keep its spectrum, so that it can be
+    /// filtered several times with different callbacks by run_stored.
+    /// This is cheaper than calling run repeatedly with the same input,
+    /// because the forward transform only happens once.
+    template <typename In>
+    void store(In begin, In end) {
+        const auto dist = std::distance(begin, end);
+
+        if (dist > rbuf_.size()) {
+            throw std::runtime_error{"Filter input signal is too long."};
+        }
+
+        rbuf_.zero();
+        std::copy(begin, end, rbuf_.begin());
+        stored_size_ = dist;
+        store_impl();
+    }
+
+    /// Filter the signal most recently passed to store.
+    /// The output range should be as big as the stored input range.
+    template <typename Out>
+    void run_stored(Out output_it, const callback& callback) {
+        if (stored_size_ > 0) {
+            run_stored_impl(callback);
+            std::copy(rbuf_.begin(), rbuf_.begin() + stored_size_, output_it);
+        }
+    }
+
 private:
     void filter_impl(const callback& callback);
+    void store_impl();
+    void run_stored_impl(const callback& callback);
 
     rbuf rbuf_;
+    std::ptrdiff_t stored_size_{0};
 
     class impl;
     std::unique_ptr<impl> pimpl_;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "frequency_domain/batch_filter.h"
 #include "frequency_domain/envelope.h"
 #include "frequency_domain/filter.h"
 
@@ -52,36 +53,36 @@ auto multiband_filter(It b,
                       size_t l = 0) {
     constexpr auto bands = bands_plus_one - 1;
 
+    const auto signal_length = std::distance(b, e);
+    std::array<double, bands> normalized_rms{};
+    if (!signal_length) {
+        return normalized_rms;
+    }
+
     //  A bit of extra padding here so that discontinuities at the end get
     //  truncated away.
-    const auto bins = best_fft_length(std::distance(b, e)) << 2;
-    filter filt{bins};
+    const auto bins = best_fft_length(signal_length) << 2;
 
-    //  Will store the area under each frequency-domain window.
-    std::array<double, bands> summed_squared{};
-    std::array<double, bands> integrated_envelopes{};
+    //  The band masks only depend on the transform length and band
+    //  parameters, so they are shared between calls.
+    const auto masks = get_band_masks(
+            bins, params.edges.data(), bands, params.width_factor, l);
 
+    //  All bands are transformed together, with one forward and one inverse
+    //  plan.
+    batch_filter filt{bins, bands};
     for (auto i = 0ul; i != bands; ++i) {
-        const auto mapping_b = callback(b, i);
-        const auto mapping_e = callback(e, i);
-        filt.run(mapping_b, mapping_e, mapping_b, [&](auto cplx, auto freq) {
-            const auto amp = compute_bandpass_magnitude(
-                    freq,
-                    util::make_range(params.edges[i + 0], params.edges[i + 1]),
-                    params.width_factor,
-                    l);
-            integrated_envelopes[i] += amp;
-            const auto ret = cplx * static_cast<float>(amp);
-            const auto abs_ret = std::abs(ret);
-            summed_squared[i] += abs_ret * abs_ret;
-            return ret;
-        });
+        filt.set_channel(i, callback(b, i), callback(e, i));
     }
 
-    std::array<double, bands> normalized_rms{};
-    for (auto i = 0; i != bands; ++i) {
-        normalized_rms[i] = integrated_envelopes[i] ? 
-                std::sqrt(summed_squared[i] / integrated_envelopes[i]) : 0;
+    const auto summed_squared = filt.run(masks->magnitudes.data());
+
+    for (auto i = 0ul; i != bands; ++i) {
+        filt.get_channel(i, callback(b, i), signal_length);
+        normalized_rms[i] =
+                masks->integrated[i]
+                        ? std::sqrt(summed_squared[i] / masks->integrated[i])
+                        : 0;
     }
 
     return normalized_rms;
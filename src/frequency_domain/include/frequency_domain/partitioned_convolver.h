@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace frequency_domain {
+
+/// Streaming convolution with long impulse responses, using uniformly
+/// partitioned overlap-save.
+/// Each impulse response is split into block-sized partitions, which are
+/// transformed once on construction.
+/// Input spectra are kept in a frequency-domain delay line, so each block of
+/// input costs one forward and one inverse transform of twice the block
+/// size, regardless of the length of the impulse response.
+/// Memory use is bounded by the impulse response length, not the signal
+/// length.
+///
+/// Each channel has its own impulse response and its own state.
+/// Channels are independent, but a single convolver must not be used from
+/// several threads at once.
+class partitioned_convolver final {
+public:
+    /// Each element of `impulse_responses` gives the impulse response for a
+    /// channel.
+    partitioned_convolver(
+            size_t block_size,
+            const std::vector<std::vector<float>>& impulse_responses);
+
+    partitioned_convolver(const partitioned_convolver&) = delete;
+    partitioned_convolver& operator=(const partitioned_convolver&) = delete;
+    partitioned_convolver(partitioned_convolver&&) = delete;
+    partitioned_convolver& operator=(partitioned_convolver&&) = delete;
+
+    ~partitioned_convolver() noexcept;
+
+    size_t get_block_size() const;
+    size_t get_channels() const;
+    size_t get_partitions() const;
+
+    /// The length of the longest impulse response.
+    size_t get_impulse_response_length() const;
+
+    /// The length of the impulse response for a channel.
+    size_t get_impulse_response_length(size_t channel) const;
+
+    /// Consume one block of input and produce one block of output for a
+    /// channel.
+    /// Both `input` and `output` must point to get_block_size() samples.
+    void process(size_t channel, const float* input, float* output);
+
+    /// Clear all delay lines, as if no input had been processed.
+    void reset();
+
+    /// The total number of samples processed (summed over channels) divided
+    /// by the total time spent in process().
+    double get_throughput() const;
+
+private:
+    class impl;
+    std::unique_ptr<impl> pimpl_;
+};
+
+/// Convolve a whole signal with the impulse response of a channel.
+/// The output has length (signal length + impulse response length - 1).
+/// The channel is reset before and after.
+template <typename It>
+std::vector<float> convolve(partitioned_convolver& convolver,
+                            size_t channel,
+                            It begin,
+                            It end) {
+    const auto block_size = convolver.get_block_size();
+    const size_t input_length = std::distance(begin, end);
+    const auto output_length =
+            input_length + convolver.get_impulse_response_length(channel) - 1;
+
+    convolver.reset();
+
+    std::vector<float> ret(output_length);
+    std::vector<float> in(block_size);
+    std::vector<float> out(block_size);
+    for (auto written = 0ul; written < output_length;
+         written += block_size) {
+        //  Copy in the next block of input, padding with zeros once the input
+        //  is exhausted.
+        const auto to_read = std::min(
+                block_size,
+                static_cast<size_t>(std::distance(begin, end)));
+        const auto next = std::next(begin, to_read);
+        std::fill(std::copy(begin, next, in.begin()), in.end(), 0.0f);
+        begin = next;
+
+        convolver.process(channel, in.data(), out.data());
+
+        const auto to_write = std::min(block_size, output_length - written);
+        std::copy(out.begin(), out.begin() + to_write, ret.begin() + written);
+    }
+
+    convolver.reset();
+    return ret;
+}
+
+}  // namespace frequency_domain
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+
+namespace frequency_domain {
+
+/// How much effort to spend finding fast transform plans.
+/// Measured plans are faster to execute but slow to create, unless wisdom
+/// for the transform sizes in use has already been loaded.
+enum class planning_rigour { estimate, measure };
+
+/// Applies to plans created after the call.
+/// Plans which already exist are kept, and will continue to be used.
+void set_planning_rigour(planning_rigour rigour);
+planning_rigour get_planning_rigour();
+
+/// Load previously-saved planner wisdom.
+/// Returns false if the file could not be read.
+bool import_wisdom(const std::string& path);
+
+/// Save accumulated planner wisdom, so that it can be loaded next time.
+/// Returns false if the file could not be written.
+bool export_wisdom(const std::string& path);
+
+/// Loads wisdom from a file and switches to measured planning for the
+/// lifetime of the object, then saves the accumulated wisdom back to the same
+/// file.
+/// A missing file is not an error, so the first run creates it.
+/// Does nothing if the path is empty.
+class scoped_wisdom final {
+public:
+    explicit scoped_wisdom(std::string path);
+
+    scoped_wisdom(const scoped_wisdom&) = delete;
+    scoped_wisdom& operator=(const scoped_wisdom&) = delete;
+
+    ~scoped_wisdom() noexcept;
+
+private:
+    std::string path_;
+    planning_rigour previous_rigour_;
+};
+
+/// The number of distinct plans held in the process-wide plan cache.
+size_t cached_plan_count();
+
+}  // namespace frequency_domain
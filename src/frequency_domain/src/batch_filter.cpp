@@ -0,0 +1,182 @@
+#include "frequency_domain/batch_filter.h"
+#include "frequency_domain/envelope.h"
+
+#include "plan_cache.h"
+
+#include <cmath>
+#include <complex>
+#include <mutex>
+
+namespace frequency_domain {
+
+class batch_filter::impl final {
+public:
+    using cbuf = buffer<fftwf_complex>;
+
+    impl(rbuf& rbuf, size_t signal_length, size_t channels)
+            : rbuf_{rbuf}
+            , signal_length_{signal_length}
+            , bins_{signal_length / 2 + 1}
+            , channels_{channels}
+            , cbuf_{bins_ * channels}
+            , fft_{get_r2c_plan(
+                      signal_length, channels, rbuf.data(), cbuf_.data())}
+            , ifft_{get_c2r_plan(
+                      signal_length, channels, cbuf_.data(), rbuf.data())} {}
+
+    size_t get_bins() const { return bins_; }
+
+    std::vector<double> run(const float* masks) {
+        fftwf_execute_dft_r2c(fft_, rbuf_.data(), cbuf_.data());
+
+        std::vector<double> summed_squared(channels_, 0.0);
+        for (auto channel = 0ul; channel != channels_; ++channel) {
+            const auto spectrum = cbuf_.data() + channel * bins_;
+            const auto mask = masks + channel * bins_;
+            auto& sum = summed_squared[channel];
+            for (auto i = 0ul; i != bins_; ++i) {
+                auto& re{spectrum[i][0]};
+                auto& im{spectrum[i][1]};
+                const auto filtered = std::complex<float>{re, im} * mask[i];
+                const auto abs_filtered = std::abs(filtered);
+                sum += abs_filtered * abs_filtered;
+                re = filtered.real();
+                im = filtered.imag();
+            }
+        }
+
+        fftwf_execute_dft_c2r(ifft_, cbuf_.data(), rbuf_.data());
+
+        //  Normalize the filter output.
+        for (auto& i : rbuf_) {
+            i /= signal_length_;
+        }
+
+        return summed_squared;
+    }
+
+private:
+    rbuf& rbuf_;
+    size_t signal_length_;
+    size_t bins_;
+    size_t channels_;
+    cbuf cbuf_;
+    fftwf_plan fft_;
+    fftwf_plan ifft_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+batch_filter::batch_filter(size_t signal_length, size_t channels)
+        : signal_length_{signal_length}
+        , channels_{channels}
+        , rbuf_{signal_length * channels}
+        , pimpl_{std::make_unique<impl>(rbuf_, signal_length, channels)} {}
+
+batch_filter::~batch_filter() noexcept = default;
+
+size_t batch_filter::get_signal_length() const { return signal_length_; }
+size_t batch_filter::get_channels() const { return channels_; }
+size_t batch_filter::get_bins() const { return pimpl_->get_bins(); }
+
+std::vector<double> batch_filter::run(const float* masks) {
+    return pimpl_->run(masks);
+}
+
+float* batch_filter::channel_begin(size_t channel) {
+    return rbuf_.data() + channel * signal_length_;
+}
+
+const float* batch_filter::channel_begin(size_t channel) const {
+    return rbuf_.data() + channel * signal_length_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct band_masks_key final {
+    size_t transform_length;
+    std::vector<double> edges;
+    double width_factor;
+    size_t l;
+};
+
+bool operator==(const band_masks_key& a, const band_masks_key& b) {
+    return a.transform_length == b.transform_length && a.edges == b.edges &&
+           a.width_factor == b.width_factor && a.l == b.l;
+}
+
+band_masks compute_band_masks(const band_masks_key& key) {
+    const auto bands = key.edges.size() - 1;
+    const auto bins = key.transform_length / 2 + 1;
+
+    band_masks ret{bins,
+                   std::vector<float>(bins * bands),
+                   std::vector<double>(bands, 0.0)};
+
+    for (auto band = 0ul; band != bands; ++band) {
+        const auto range = util::make_range(key.edges[band + 0],
+                                            key.edges[band + 1]);
+        for (auto i = 0ul; i != bins; ++i) {
+            //  Same arithmetic as filter, so that results are unchanged.
+            const auto normalised_frequency =
+                    i / static_cast<float>(key.transform_length);
+            const auto amp = compute_bandpass_magnitude(
+                    normalised_frequency, range, key.width_factor, key.l);
+            ret.integrated[band] += amp;
+            ret.magnitudes[band * bins + i] = static_cast<float>(amp);
+        }
+    }
+
+    return ret;
+}
+
+}  // namespace
+
+std::shared_ptr<const band_masks> get_band_masks(size_t transform_length,
+                                                 const double* edges,
+                                                 size_t bands,
+                                                 double width_factor,
+                                                 size_t l) {
+    //  Masks can be large, so only the most recently used few are kept.
+    constexpr auto max_cached = 4;
+
+    struct entry final {
+        band_masks_key key;
+        std::shared_ptr<const band_masks> masks;
+    };
+
+    static std::mutex mutex;
+    static std::vector<entry> cache;
+
+    band_masks_key key{transform_length,
+                       std::vector<double>(edges, edges + bands + 1),
+                       width_factor,
+                       l};
+
+    {
+        const std::lock_guard<std::mutex> lock{mutex};
+        const auto it = std::find_if(
+                begin(cache), end(cache), [&](const auto& i) {
+                    return i.key == key;
+                });
+        if (it != end(cache)) {
+            //  Move to the back, so it will be evicted last.
+            std::rotate(it, it + 1, end(cache));
+            return cache.back().masks;
+        }
+    }
+
+    //  Computed without the lock held, so that other threads aren't blocked.
+    auto masks = std::make_shared<const band_masks>(compute_band_masks(key));
+
+    const std::lock_guard<std::mutex> lock{mutex};
+    if (max_cached <= cache.size()) {
+        cache.erase(begin(cache));
+    }
+    cache.emplace_back(entry{std::move(key), masks});
+    return masks;
+}
+
+}  // namespace frequency_domain
@@ -1,6 +1,6 @@
 #include "frequency_domain/convolver.h"
 
-#include "plan.h"
+#include "plan_cache.h"
 
 namespace frequency_domain {
 
@@ -10,31 +10,28 @@ public:
     using cbuf = buffer<fftwf_complex>;
 
     explicit impl(convolver& owner, size_t fft_length)
-            : fft_length_{fft_length}
+            : owner_{owner}
+            , fft_length_{fft_length}
             , cplx_length_{fft_length / 2 + 1}
             , r2c_o_{cplx_length_}
             , c2r_i_{cplx_length_}
             , c2r_o_{fft_length_}
             , acplx_{cplx_length_}
             , bcplx_{cplx_length_}
-            , r2c_{fftwf_plan_dft_r2c_1d(fft_length,
-                                         owner.r2c_i_.data(),
-                                         r2c_o_.data(),
-                                         FFTW_ESTIMATE)}
-            , c2r_{fftwf_plan_dft_c2r_1d(fft_length,
-                                         c2r_i_.data(),
-                                         c2r_o_.data(),
-                                         FFTW_ESTIMATE)} {}
+            , r2c_{get_r2c_plan(
+                      fft_length, 1, owner.r2c_i_.data(), r2c_o_.data())}
+            , c2r_{get_c2r_plan(
+                      fft_length, 1, c2r_i_.data(), c2r_o_.data())} {}
 
     size_t get_fft_length() const { return fft_length_; }
 
     void forward_fft_a() {
-        fftwf_execute(r2c_);
+        forward_fft();
         acplx_ = r2c_o_;
     }
 
     void forward_fft_b() {
-        fftwf_execute(r2c_);
+        forward_fft();
         bcplx_ = r2c_o_;
     }
 
@@ -55,7 +52,7 @@ public:
             (*z)[1] += (*x)[0] * (*y)[1] + (*x)[1] * (*y)[0];
         }
 
-        fftwf_execute(c2r_);
+        fftwf_execute_dft_c2r(c2r_, c2r_i_.data(), c2r_o_.data());
 
         std::vector<float> ret(c2r_o_.begin(), c2r_o_.end());
 
@@ -67,6 +64,11 @@ public:
     }
 
 private:
+    void forward_fft() {
+        fftwf_execute_dft_r2c(r2c_, owner_.r2c_i_.data(), r2c_o_.data());
+    }
+
+    convolver& owner_;
     const size_t fft_length_;
     const size_t cplx_length_;
 
@@ -76,8 +78,8 @@ private:
     cbuf acplx_;
     cbuf bcplx_;
 
-    plan r2c_;
-    plan c2r_;
+    fftwf_plan r2c_;
+    fftwf_plan c2r_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1,7 +1,7 @@
 #include "frequency_domain/fft.h"
 #include "frequency_domain/buffer.h"
 
-#include "plan.h"
+#include "plan_cache.h"
 
 #include "fftw3.h"
 
@@ -29,11 +29,10 @@ public:
     impl(dft_1d::direction dir, size_t size)
             : i_buf_{size}
             , o_buf_{size}
-            , plan_{fftwf_plan_dft_1d(size,
-                                      i_buf_.data(),
-                                      o_buf_.data(),
-                                      dir == direction::forwards ? 1 : -1,
-                                      FFTW_ESTIMATE)} {}
+            , plan_{get_c2c_plan(size,
+                                 dir == direction::forwards ? 1 : -1,
+                                 i_buf_.data(),
+                                 o_buf_.data())} {}
 
     impl(const impl&) = delete;
     impl(impl&&) = delete;
@@ -45,7 +44,7 @@ public:
     auto run(It begin, It end) {
         i_buf_.zero();
         copy_to_buffer(begin, end, i_buf_.begin());
-        fftwf_execute(plan_);
+        fftwf_execute_dft(plan_, i_buf_.data(), o_buf_.data());
         std::vector<std::complex<float>> ret(i_buf_.size(), 0);
         copy_to_vector(o_buf_.begin(), o_buf_.end(), ret.begin());
         return ret;
@@ -54,7 +53,7 @@ public:
 private:
     cbuf i_buf_;
     cbuf o_buf_;
-    plan plan_;
+    fftwf_plan plan_;
 };
 
 dft_1d::dft_1d(direction dir, size_t size)
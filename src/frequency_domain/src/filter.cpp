@@ -1,8 +1,9 @@
 #include "frequency_domain/filter.h"
 
-#include "plan.h"
+#include "plan_cache.h"
 
 #include <cmath>
+#include <cstring>
 #include <iostream>
 
 namespace frequency_domain {
@@ -14,15 +15,32 @@ public:
     explicit impl(rbuf& rbuf)
             : rbuf_{rbuf}
             , cbuf_{rbuf.size() / 2 + 1}
-            , fft_{fftwf_plan_dft_r2c_1d(
-                      rbuf.size(), rbuf.data(), cbuf_.data(), FFTW_ESTIMATE)}
-            , ifft_{fftwf_plan_dft_c2r_1d(
-                      rbuf.size(), cbuf_.data(), rbuf.data(), FFTW_ESTIMATE)} {}
+            , fft_{get_r2c_plan(rbuf.size(), 1, rbuf.data(), cbuf_.data())}
+            , ifft_{get_c2r_plan(rbuf.size(), 1, cbuf_.data(), rbuf.data())} {}
 
     void filter_impl(const filter::callback& callback) {
         //  Run forward fft, placing fft output into cbuf_.
-        fftwf_execute(fft_);
+        forward();
+        modify_and_invert(callback);
+    }
+
+    void store_impl() {
+        forward();
+        stored_ = cbuf_;
+    }
 
+    void run_stored_impl(const filter::callback& callback) {
+        //  The inverse transform overwrites its input, so work on a copy.
+        memcpy(cbuf_.data(),
+               stored_.data(),
+               cbuf_.size() * sizeof(fftwf_complex));
+        modify_and_invert(callback);
+    }
+
+private:
+    void forward() { fftwf_execute_dft_r2c(fft_, rbuf_.data(), cbuf_.data()); }
+
+    void modify_and_invert(const filter::callback& callback) {
         const auto rbuf_size = rbuf_.size();
         //  Modify magnitudes in the frequency domain.
         for (auto i = 0ul, end = cbuf_.size(); i != end; ++i) {
@@ -37,7 +55,7 @@ public:
         }
 
         //  Run inverse fft, placing ifft output back into owner.rbuf_.
-        fftwf_execute(ifft_);
+        fftwf_execute_dft_c2r(ifft_, cbuf_.data(), rbuf_.data());
 
         //  Normalize the filter output.
         for (auto& i : rbuf_) {
@@ -45,11 +63,11 @@ public:
         }
     }
 
-private:
     rbuf& rbuf_;
     cbuf cbuf_;
-    plan fft_;
-    plan ifft_;
+    cbuf stored_;
+    fftwf_plan fft_;
+    fftwf_plan ifft_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -64,4 +82,10 @@ void filter::filter_impl(const callback& callback) {
     pimpl_->filter_impl(callback);
 }
 
+void filter::store_impl() { pimpl_->store_impl(); }
+
+void filter::run_stored_impl(const callback& callback) {
+    pimpl_->run_stored_impl(callback);
+}
+
 }  // namespace frequency_domain
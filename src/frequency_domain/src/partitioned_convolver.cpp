@@ -0,0 +1,234 @@
+#include "frequency_domain/partitioned_convolver.h"
+#include "frequency_domain/buffer.h"
+
+#include "plan_cache.h"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace frequency_domain {
+
+class partitioned_convolver::impl final {
+public:
+    using cbuf = buffer<fftwf_complex>;
+
+    impl(size_t block_size,
+         const std::vector<std::vector<float>>& impulse_responses)
+            : block_size_{block_size}
+            , fft_length_{block_size * 2}
+            , bins_{block_size + 1}
+            , ir_length_{max_length(impulse_responses)}
+            , partitions_{count_partitions(block_size, ir_length_)}
+            , time_{fft_length_}
+            , spectrum_{bins_}
+            , accumulator_{bins_}
+            , r2c_{get_r2c_plan(fft_length_, 1, time_.data(), spectrum_.data())}
+            , c2r_{get_c2r_plan(
+                      fft_length_, 1, accumulator_.data(), time_.data())} {
+        for (const auto& ir : impulse_responses) {
+            channels_.emplace_back(make_channel(ir));
+        }
+    }
+
+    size_t get_block_size() const { return block_size_; }
+    size_t get_channels() const { return channels_.size(); }
+    size_t get_partitions() const { return partitions_; }
+    size_t get_impulse_response_length() const { return ir_length_; }
+    size_t get_impulse_response_length(size_t channel) const {
+        return channels_.at(channel).ir_length;
+    }
+
+    void process(size_t channel_index, const float* input, float* output) {
+        const auto start = std::chrono::steady_clock::now();
+
+        auto& channel = channels_.at(channel_index);
+
+        //  Slide the input window along by one block.
+        std::copy(channel.input.begin() + block_size_,
+                  channel.input.end(),
+                  channel.input.begin());
+        std::copy(input,
+                  input + block_size_,
+                  channel.input.begin() + block_size_);
+
+        //  Transform the window into the newest slot of the delay line.
+        std::copy(channel.input.begin(), channel.input.end(), time_.begin());
+        fftwf_execute_dft_r2c(r2c_, time_.data(), spectrum_.data());
+        channel.head = channel.head ? channel.head - 1 : partitions_ - 1;
+        copy_spectrum(spectrum_.data(),
+                      channel.delay_line.data() + channel.head * bins_);
+
+        //  Multiply each delayed input spectrum by the matching partition of
+        //  the impulse response, and sum.
+        accumulator_.zero();
+        for (auto partition = 0ul; partition != partitions_; ++partition) {
+            const auto slot = (channel.head + partition) % partitions_;
+            multiply_accumulate(channel.delay_line.data() + slot * bins_,
+                                channel.partitions.data() + partition * bins_,
+                                accumulator_.data());
+        }
+
+        //  The last block of the inverse transform is free of circular
+        //  aliasing.
+        fftwf_execute_dft_c2r(c2r_, accumulator_.data(), time_.data());
+        std::copy(time_.begin() + block_size_, time_.end(), output);
+
+        samples_processed_ += block_size_;
+        time_processing_ += std::chrono::steady_clock::now() - start;
+    }
+
+    void reset() {
+        for (auto& channel : channels_) {
+            channel.input.zero();
+            channel.delay_line.zero();
+            channel.head = 0;
+        }
+    }
+
+    double get_throughput() const {
+        const auto seconds = time_processing_.count();
+        return seconds ? samples_processed_ / seconds : 0.0;
+    }
+
+private:
+    struct channel final {
+        /// Frequency-domain partitions of the impulse response.
+        cbuf partitions;
+        /// Spectra of recent input windows, newest at `head`.
+        cbuf delay_line;
+        /// The two most recent blocks of input.
+        rbuf input;
+        size_t head;
+        size_t ir_length;
+    };
+
+    static size_t max_length(const std::vector<std::vector<float>>& irs) {
+        size_t ret = 0;
+        for (const auto& i : irs) {
+            ret = std::max(ret, i.size());
+        }
+        return ret;
+    }
+
+    static size_t count_partitions(size_t block_size, size_t ir_length) {
+        if (!block_size) {
+            throw std::runtime_error{"Block size must be greater than zero."};
+        }
+        if (!ir_length) {
+            throw std::runtime_error{"Impulse responses must not be empty."};
+        }
+        return (ir_length + block_size - 1) / block_size;
+    }
+
+    void copy_spectrum(const fftwf_complex* from, fftwf_complex* to) const {
+        memcpy(to, from, bins_ * sizeof(fftwf_complex));
+    }
+
+    static void multiply_accumulate(const fftwf_complex* a,
+                                    const fftwf_complex* b,
+                                    fftwf_complex* out,
+                                    size_t bins) {
+        for (auto i = 0ul; i != bins; ++i) {
+            out[i][0] += a[i][0] * b[i][0] - a[i][1] * b[i][1];
+            out[i][1] += a[i][0] * b[i][1] + a[i][1] * b[i][0];
+        }
+    }
+
+    void multiply_accumulate(const fftwf_complex* a,
+                             const fftwf_complex* b,
+                             fftwf_complex* out) const {
+        multiply_accumulate(a, b, out, bins_);
+    }
+
+    channel make_channel(const std::vector<float>& ir) {
+        channel ret{cbuf{partitions_ * bins_},
+                    cbuf{partitions_ * bins_},
+                    rbuf{fft_length_},
+                    0,
+                    ir.size()};
+        ret.delay_line.zero();
+        ret.input.zero();
+
+        //  Each partition is zero-padded to the transform length.
+        //  The inverse transform is unnormalised, so the scale is folded in
+        //  here.
+        const auto scale = 1.0f / fft_length_;
+        for (auto partition = 0ul; partition != partitions_; ++partition) {
+            time_.zero();
+            const auto b = std::min(ir.size(), partition * block_size_);
+            const auto e = std::min(ir.size(), b + block_size_);
+            std::transform(ir.begin() + b,
+                           ir.begin() + e,
+                           time_.begin(),
+                           [&](auto i) { return i * scale; });
+            fftwf_execute_dft_r2c(r2c_, time_.data(), spectrum_.data());
+            copy_spectrum(spectrum_.data(),
+                          ret.partitions.data() + partition * bins_);
+        }
+
+        return ret;
+    }
+
+    size_t block_size_;
+    size_t fft_length_;
+    size_t bins_;
+    size_t ir_length_;
+    size_t partitions_;
+
+    rbuf time_;
+    cbuf spectrum_;
+    cbuf accumulator_;
+
+    fftwf_plan r2c_;
+    fftwf_plan c2r_;
+
+    std::vector<channel> channels_;
+
+    size_t samples_processed_{0};
+    std::chrono::duration<double> time_processing_{0};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+partitioned_convolver::partitioned_convolver(
+        size_t block_size,
+        const std::vector<std::vector<float>>& impulse_responses)
+        : pimpl_{std::make_unique<impl>(block_size, impulse_responses)} {}
+
+partitioned_convolver::~partitioned_convolver() noexcept = default;
+
+size_t partitioned_convolver::get_block_size() const {
+    return pimpl_->get_block_size();
+}
+
+size_t partitioned_convolver::get_channels() const {
+    return pimpl_->get_channels();
+}
+
+size_t partitioned_convolver::get_partitions() const {
+    return pimpl_->get_partitions();
+}
+
+size_t partitioned_convolver::get_impulse_response_length() const {
+    return pimpl_->get_impulse_response_length();
+}
+
+size_t partitioned_convolver::get_impulse_response_length(
+        size_t channel) const {
+    return pimpl_->get_impulse_response_length(channel);
+}
+
+void partitioned_convolver::process(size_t channel,
+                                    const float* input,
+                                    float* output) {
+    pimpl_->process(channel, input, output);
+}
+
+void partitioned_convolver::reset() { pimpl_->reset(); }
+
+double partitioned_convolver::get_throughput() const {
+    return pimpl_->get_throughput();
+}
+
+}  // namespace frequency_domain
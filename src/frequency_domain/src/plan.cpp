@@ -2,10 +2,16 @@
 
 namespace frequency_domain {
 
+std::mutex& planner_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
 plan::plan(const fftwf_plan& p)
         : p(p) {}
 
 plan::~plan() noexcept {
+    const std::lock_guard<std::mutex> lock{planner_mutex()};
     fftwf_destroy_plan(p);
 }
 
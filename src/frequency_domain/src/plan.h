@@ -2,13 +2,22 @@
 
 #include "fftw3.h"
 
+#include <mutex>
+
 namespace frequency_domain {
 
+/// Everything in fftw except execution is thread-unsafe, so plan creation
+/// and destruction, and wisdom loading and saving, must hold this lock.
+std::mutex& planner_mutex();
+
 class plan final {
 public:
     plan(const fftwf_plan& p);
     ~plan() noexcept;
 
+    plan(const plan&) = delete;
+    plan& operator=(const plan&) = delete;
+
     operator const fftwf_plan&() const;
 
 private:
@@ -0,0 +1,217 @@
+#include "plan_cache.h"
+#include "plan.h"
+
+#include "frequency_domain/buffer.h"
+#include "frequency_domain/wisdom.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace frequency_domain {
+
+namespace {
+
+enum class transform_kind { r2c, c2r, c2c_forward, c2c_backward };
+
+struct plan_key final {
+    transform_kind kind;
+    size_t size;
+    size_t howmany;
+    int in_alignment;
+    int out_alignment;
+    planning_rigour rigour;
+};
+
+bool operator<(const plan_key& a, const plan_key& b) {
+    const auto tie = [](const auto& i) {
+        return std::tie(i.kind,
+                        i.size,
+                        i.howmany,
+                        i.in_alignment,
+                        i.out_alignment,
+                        i.rigour);
+    };
+    return tie(a) < tie(b);
+}
+
+std::atomic<planning_rigour> current_rigour{planning_rigour::estimate};
+
+unsigned planner_flags(planning_rigour rigour) {
+    switch (rigour) {
+        case planning_rigour::estimate: return FFTW_ESTIMATE;
+        case planning_rigour::measure: return FFTW_MEASURE;
+    }
+    return FFTW_ESTIMATE;
+}
+
+/// Planning with a measuring planner overwrites the arrays, so plans are
+/// always made with scratch storage, offset to match the caller's alignment.
+template <typename T>
+T* offset_pointer(buffer<float>& storage, int alignment) {
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(storage.data()) +
+                                alignment);
+}
+
+class plan_cache final {
+public:
+    template <typename Make>
+    fftwf_plan get(const plan_key& key, const Make& make) {
+        //  Lookup and creation share one lock, so concurrent requests for the
+        //  same plan create it only once.
+        const std::lock_guard<std::mutex> lock{planner_mutex()};
+        const auto it = plans_.find(key);
+        if (it != plans_.end()) {
+            return *it->second;
+        }
+
+        const auto p = make(planner_flags(key.rigour));
+        if (p == nullptr) {
+            throw std::runtime_error{"Failed to create fft plan."};
+        }
+        return *plans_.emplace(key, std::make_unique<plan>(p))
+                        .first->second;
+    }
+
+    size_t size() const {
+        const std::lock_guard<std::mutex> lock{planner_mutex()};
+        return plans_.size();
+    }
+
+private:
+    std::map<plan_key, std::unique_ptr<plan>> plans_;
+};
+
+plan_cache& get_plan_cache() {
+    //  Intentionally leaked, so that plans remain valid during static
+    //  destruction.
+    static auto& cache = *new plan_cache{};
+    return cache;
+}
+
+}  // namespace
+
+fftwf_plan get_r2c_plan(size_t size,
+                        size_t howmany,
+                        float* in,
+                        fftwf_complex* out) {
+    const auto bins = size / 2 + 1;
+    const plan_key key{transform_kind::r2c,
+                       size,
+                       howmany,
+                       fftwf_alignment_of(in),
+                       fftwf_alignment_of(reinterpret_cast<float*>(out)),
+                       current_rigour};
+    return get_plan_cache().get(key, [&](auto flags) {
+        buffer<float> i{size * howmany + 4};
+        buffer<float> o{bins * howmany * 2 + 4};
+        const int n = size;
+        return fftwf_plan_many_dft_r2c(
+                1,
+                &n,
+                howmany,
+                offset_pointer<float>(i, key.in_alignment),
+                nullptr,
+                1,
+                size,
+                offset_pointer<fftwf_complex>(o, key.out_alignment),
+                nullptr,
+                1,
+                bins,
+                flags);
+    });
+}
+
+fftwf_plan get_c2r_plan(size_t size,
+                        size_t howmany,
+                        fftwf_complex* in,
+                        float* out) {
+    const auto bins = size / 2 + 1;
+    const plan_key key{transform_kind::c2r,
+                       size,
+                       howmany,
+                       fftwf_alignment_of(reinterpret_cast<float*>(in)),
+                       fftwf_alignment_of(out),
+                       current_rigour};
+    return get_plan_cache().get(key, [&](auto flags) {
+        buffer<float> i{bins * howmany * 2 + 4};
+        buffer<float> o{size * howmany + 4};
+        const int n = size;
+        return fftwf_plan_many_dft_c2r(
+                1,
+                &n,
+                howmany,
+                offset_pointer<fftwf_complex>(i, key.in_alignment),
+                nullptr,
+                1,
+                bins,
+                offset_pointer<float>(o, key.out_alignment),
+                nullptr,
+                1,
+                size,
+                flags);
+    });
+}
+
+fftwf_plan get_c2c_plan(size_t size,
+                        int sign,
+                        fftwf_complex* in,
+                        fftwf_complex* out) {
+    const plan_key key{
+            sign == FFTW_FORWARD ? transform_kind::c2c_forward
+                                 : transform_kind::c2c_backward,
+            size,
+            1,
+            fftwf_alignment_of(reinterpret_cast<float*>(in)),
+            fftwf_alignment_of(reinterpret_cast<float*>(out)),
+            current_rigour};
+    return get_plan_cache().get(key, [&](auto flags) {
+        buffer<float> i{size * 2 + 4};
+        buffer<float> o{size * 2 + 4};
+        return fftwf_plan_dft_1d(
+                size,
+                offset_pointer<fftwf_complex>(i, key.in_alignment),
+                offset_pointer<fftwf_complex>(o, key.out_alignment),
+                sign,
+                flags);
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void set_planning_rigour(planning_rigour rigour) { current_rigour = rigour; }
+planning_rigour get_planning_rigour() { return current_rigour; }
+
+bool import_wisdom(const std::string& path) {
+    const std::lock_guard<std::mutex> lock{planner_mutex()};
+    return fftwf_import_wisdom_from_filename(path.c_str());
+}
+
+bool export_wisdom(const std::string& path) {
+    const std::lock_guard<std::mutex> lock{planner_mutex()};
+    return fftwf_export_wisdom_to_filename(path.c_str());
+}
+
+scoped_wisdom::scoped_wisdom(std::string path)
+        : path_{std::move(path)}
+        , previous_rigour_{get_planning_rigour()} {
+    if (!path_.empty()) {
+        import_wisdom(path_);
+        set_planning_rigour(planning_rigour::measure);
+    }
+}
+
+scoped_wisdom::~scoped_wisdom() noexcept {
+    if (!path_.empty()) {
+        export_wisdom(path_);
+        set_planning_rigour(previous_rigour_);
+    }
+}
+
+size_t cached_plan_count() { return get_plan_cache().size(); }
+
+}  // namespace frequency_domain
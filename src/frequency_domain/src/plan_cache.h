@@ -0,0 +1,36 @@
+#pragma once
+
+#include "fftw3.h"
+
+namespace frequency_domain {
+
+/// All of these functions look up a plan in a process-wide cache, creating
+/// and storing a new plan if there isn't already a suitable one.
+/// Plans are keyed by transform kind, size, batch count and the alignment
+/// of the input and output arrays.
+/// Cached plans live until the process exits, so the returned handles may be
+/// stored freely.
+/// They must be executed using the new-array execute functions
+/// (fftwf_execute_dft_r2c etc.), with out-of-place arrays that have the same
+/// alignment as those passed here.
+/// Safe to call from multiple threads.
+
+/// `howmany` contiguous real-to-complex transforms of length `size`.
+fftwf_plan get_r2c_plan(size_t size,
+                        size_t howmany,
+                        float* in,
+                        fftwf_complex* out);
+
+/// `howmany` contiguous complex-to-real transforms of length `size`.
+fftwf_plan get_c2r_plan(size_t size,
+                        size_t howmany,
+                        fftwf_complex* in,
+                        float* out);
+
+/// A single complex-to-complex transform.
+fftwf_plan get_c2c_plan(size_t size,
+                        int sign,
+                        fftwf_complex* in,
+                        fftwf_complex* out);
+
+}  // namespace frequency_domain
@@ -1,7 +1,10 @@
 #include "frequency_domain/convolver.h"
+#include "frequency_domain/partitioned_convolver.h"
 
 #include "gtest/gtest.h"
 
+#include <random>
+
 TEST(convolution, convolution) {
     std::vector<float> a{1, 0, 0, 0, 0};
     std::vector<float> b{1, 2, 3, 4, 3, 2, 1, 0, 0};
@@ -14,3 +17,45 @@ TEST(convolution, convolution) {
         ASSERT_NEAR(convolved[i], desired[i], 0.0001);
     }
 }
+
+TEST(convolution, partitioned) {
+    auto engine = std::default_random_engine{std::random_device{}()};
+    auto dist = std::uniform_real_distribution<float>{-1, 1};
+    const auto noise = [&](size_t length) {
+        std::vector<float> ret(length);
+        for (auto& i : ret) {
+            i = dist(engine);
+        }
+        return ret;
+    };
+
+    const auto signal = noise(10000);
+    const std::vector<std::vector<float>> irs{
+            noise(1), noise(100), noise(1024), noise(5000)};
+
+    for (const auto block_size : {1ul, 64ul, 1000ul, 4096ul}) {
+        frequency_domain::partitioned_convolver pc{block_size, irs};
+        ASSERT_EQ(pc.get_channels(), irs.size());
+
+        for (auto channel = 0ul; channel != irs.size(); ++channel) {
+            const auto& ir = irs[channel];
+
+            frequency_domain::convolver fc{signal.size() + ir.size() - 1};
+            const auto expected = fc.convolve(signal, ir);
+
+            const auto convolved = frequency_domain::convolve(
+                    pc, channel, begin(signal), end(signal));
+            ASSERT_EQ(convolved.size(), expected.size());
+            for (auto i = 0ul; i != expected.size(); ++i) {
+                ASSERT_NEAR(convolved[i], expected[i], 0.0001);
+            }
+
+            //  Results are reproducible.
+            ASSERT_EQ(convolved,
+                      frequency_domain::convolve(
+                              pc, channel, begin(signal), end(signal)));
+        }
+
+        ASSERT_LT(0, pc.get_throughput());
+    }
+}
@@ -34,3 +34,68 @@ TEST(multiband, noise) {
         ASSERT_NEAR(std::abs(mean - i) / mean, 0.0, 0.2);
     }
 }
+
+TEST(multiband, matches_per_band_filter) {
+    auto engine = std::default_random_engine{std::random_device{}()};
+    auto dist = std::uniform_real_distribution<float>{-1, 1};
+
+    constexpr auto bands = 8;
+    const auto params = frequency_domain::compute_multiband_params<bands>(
+            util::range<double>{20, 20000} / 44100.0, 1);
+
+    for (const auto length : {1ul, 100ul, 1000ul, 4321ul}) {
+        util::aligned::vector<std::array<float, bands>> input(length);
+        for (auto& i : input) {
+            for (auto& j : i) {
+                j = dist(engine);
+            }
+        }
+
+        //  Reference: filter each band separately.
+        auto reference = input;
+        std::array<double, bands> reference_rms{};
+        {
+            frequency_domain::filter filt{
+                    frequency_domain::best_fft_length(length) << 2};
+            for (auto band = 0ul; band != bands; ++band) {
+                double summed_squared = 0;
+                double integrated = 0;
+                const auto b = frequency_domain::make_indexer_iterator{}(
+                        begin(reference), band);
+                const auto e = frequency_domain::make_indexer_iterator{}(
+                        end(reference), band);
+                filt.run(b, e, b, [&](auto cplx, auto freq) {
+                    using frequency_domain::compute_bandpass_magnitude;
+                    const auto amp = compute_bandpass_magnitude(
+                            freq,
+                            util::make_range(params.edges[band + 0],
+                                             params.edges[band + 1]),
+                            params.width_factor,
+                            0);
+                    integrated += amp;
+                    const auto ret = cplx * static_cast<float>(amp);
+                    const auto abs_ret = std::abs(ret);
+                    summed_squared += abs_ret * abs_ret;
+                    return ret;
+                });
+                reference_rms[band] = std::sqrt(summed_squared / integrated);
+            }
+        }
+
+        auto batched = input;
+        const auto batched_rms = frequency_domain::multiband_filter(
+                begin(batched),
+                end(batched),
+                params,
+                frequency_domain::make_indexer_iterator{});
+
+        for (auto band = 0ul; band != bands; ++band) {
+            ASSERT_NEAR(batched_rms[band],
+                        reference_rms[band],
+                        1.0e-5 * reference_rms[band]);
+            for (auto i = 0ul; i != length; ++i) {
+                ASSERT_NEAR(batched[i][band], reference[i][band], 1.0e-5);
+            }
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "frequency_domain/filter.h"
+#include "frequency_domain/wisdom.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <future>
+#include <random>
+
+namespace {
+
+auto make_noise(size_t length) {
+    auto engine = std::default_random_engine{std::random_device{}()};
+    auto dist = std::uniform_real_distribution<float>{-1, 1};
+    std::vector<float> ret(length);
+    for (auto& i : ret) {
+        i = dist(engine);
+    }
+    return ret;
+}
+
+auto lowpass(std::vector<float> signal) {
+    frequency_domain::filter filt{signal.size() * 2};
+    filt.run(begin(signal), end(signal), begin(signal), [](auto cplx, auto f) {
+        return cplx * (f < 0.1f ? 1.0f : 0.0f);
+    });
+    return signal;
+}
+
+}  // namespace
+
+TEST(plan_cache, reuse) {
+    frequency_domain::filter{12345};
+    const auto count = frequency_domain::cached_plan_count();
+
+    //  Filters of the same size share plans.
+    for (auto i = 0; i != 10; ++i) {
+        frequency_domain::filter{12345};
+    }
+    ASSERT_EQ(frequency_domain::cached_plan_count(), count);
+
+    //  A new size needs new plans.
+    frequency_domain::filter{12346};
+    ASSERT_LT(count, frequency_domain::cached_plan_count());
+}
+
+TEST(plan_cache, concurrent) {
+    const auto signal = make_noise(1000);
+    const auto expected = lowpass(signal);
+
+    std::vector<std::future<std::vector<float>>> futures;
+    for (auto i = 0; i != 16; ++i) {
+        futures.emplace_back(std::async(std::launch::async,
+                                        [&] { return lowpass(signal); }));
+    }
+
+    for (auto& i : futures) {
+        const auto result = i.get();
+        ASSERT_EQ(result.size(), expected.size());
+        for (auto j = 0ul; j != result.size(); ++j) {
+            ASSERT_EQ(result[j], expected[j]);
+        }
+    }
+}
+
+TEST(plan_cache, wisdom) {
+    const auto signal = make_noise(1000);
+    const auto expected = lowpass(signal);
+
+    frequency_domain::set_planning_rigour(
+            frequency_domain::planning_rigour::measure);
+    const auto measured = lowpass(signal);
+    frequency_domain::set_planning_rigour(
+            frequency_domain::planning_rigour::estimate);
+
+    //  Different plans may round differently.
+    for (auto i = 0ul; i != expected.size(); ++i) {
+        ASSERT_NEAR(measured[i], expected[i], 1.0e-5);
+    }
+
+    const std::string path{"plan_cache_test.wisdom"};
+    ASSERT_TRUE(frequency_domain::export_wisdom(path));
+    ASSERT_TRUE(frequency_domain::import_wisdom(path));
+    std::remove(path.c_str());
+
+    ASSERT_FALSE(frequency_domain::import_wisdom("nonexistent.wisdom"));
+}
+
+TEST(plan_cache, scoped_wisdom) {
+    const std::string path{"plan_cache_test_scoped.wisdom"};
+    std::remove(path.c_str());
+
+    {
+        const frequency_domain::scoped_wisdom wisdom{path};
+        ASSERT_EQ(frequency_domain::get_planning_rigour(),
+                  frequency_domain::planning_rigour::measure);
+        lowpass(make_noise(1000));
+    }
+
+    ASSERT_EQ(frequency_domain::get_planning_rigour(),
+              frequency_domain::planning_rigour::estimate);
+    ASSERT_TRUE(frequency_domain::import_wisdom(path));
+    std::remove(path.c_str());
+}
@@ -33,6 +33,16 @@ auto attenuate(const core::attenuator::microphone& mic,
     return make_attenuated_impulse(i.volume * att, i.distance);
 }
 
+/// Components are attenuated in the same way as microphones.
+template <size_t channels>
+auto attenuate(const core::attenuator::microphone_component& component,
+               const glm::vec3& position,
+               const impulse<channels>& i) {
+    const auto dir = core::to_vec3{}(i.position) - position;
+    const auto att = attenuation(component, dir);
+    return make_attenuated_impulse(i.volume * att, i.distance);
+}
+
 /// For the hrtf, we adjust the receiver positions a tiny bit depending on
 /// whether the channel is left or right, which should introduce some reasonably
 /// convincing interchannel time difference.
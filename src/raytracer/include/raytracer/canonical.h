@@ -74,5 +74,93 @@ auto canonical(
                : std::nullopt;
 }
 
+/// Image-source paths depend only on the scene geometry and the source and
+/// receiver positions, so they can be kept between runs in which only the
+/// surfaces change.
+/// If `paths` is empty, the paths are found while tracing and stored there.
+/// Otherwise, only the stochastic part of the simulation is traced, and the
+/// stored paths are re-evaluated with the scene's current surfaces.
+template <typename Callback>
+auto canonical(
+        const core::compute_context& cc,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+                scene,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::environment& environment,
+        const simulation_parameters& sim_params,
+        size_t visual_items,
+        const std::atomic_bool& keep_going,
+        Callback&& callback,
+        std::optional<util::aligned::vector<image_source::image_source_path>>&
+                paths) {
+    std::default_random_engine engine{std::random_device{}()};
+
+    const auto make_histogram = [&] {
+        return reflection_processor::make_directional_histogram{
+                sim_params.rays,
+                sim_params.maximum_image_source_order + 1,
+                static_cast<float>(sim_params.receiver_radius),
+                static_cast<float>(sim_params.histogram_sample_rate)};
+    };
+
+    const auto trace = [&](auto callbacks) {
+        return run(make_random_direction_generator_iterator(0, engine),
+                   make_random_direction_generator_iterator(sim_params.rays,
+                                                            engine),
+                   cc,
+                   scene,
+                   source,
+                   receiver,
+                   environment,
+                   keep_going,
+                   std::forward<Callback>(callback),
+                   std::move(callbacks));
+    };
+
+    using histogram_type = decltype(
+            make_histogram()
+                    .get_processor(cc, source, receiver, environment, scene)
+                    .get_results());
+    using return_type = std::optional<canonical_results<histogram_type>>;
+
+    const auto make_results = [&](auto stochastic, auto visual) {
+        return return_type{make_canonical_results(
+                make_simulation_results(
+                        image_source::compute_image_source_impulses(
+                                *paths,
+                                scene.get_scene_data().get_surfaces(),
+                                receiver,
+                                environment,
+                                false),
+                        std::move(stochastic)),
+                std::move(visual))};
+    };
+
+    if (!paths) {
+        auto tup = trace(std::make_tuple(
+                reflection_processor::make_image_source_paths{
+                        sim_params.maximum_image_source_order},
+                make_histogram(),
+                reflection_processor::make_visual{visual_items}));
+        if (!tup) {
+            return return_type{};
+        }
+        paths = std::move(std::get<0>(*tup));
+        return make_results(std::move(std::get<1>(*tup)),
+                            std::move(std::get<2>(*tup)));
+    }
+
+    auto tup = trace(std::make_tuple(
+            make_histogram(),
+            reflection_processor::make_visual{visual_items}));
+    if (!tup) {
+        return return_type{};
+    }
+    return make_results(std::move(std::get<0>(*tup)),
+                        std::move(std::get<1>(*tup)));
+}
+
 }  // namespace raytracer
 }  // namespace wayverb
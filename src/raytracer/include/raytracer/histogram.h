@@ -5,6 +5,8 @@
 #include "utilities/aligned/vector.h"
 #include "utilities/mapping_iterator_adapter.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 namespace wayverb {
@@ -133,6 +135,93 @@ struct sinc_sum_functor final {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/// Raised-cosine-windowed sinc kernels, as used by sinc_sum_functor,
+/// tabulated at a fixed number of fractional-sample offsets (phases).
+/// Kernels for offsets between phases are found by linear interpolation, so
+/// the error is bounded by roughly pi^2 / (24 * phases^2) per unit volume.
+class sinc_table final {
+public:
+    /// width: impulse width in samples, which must be even.
+    /// phases: number of tabulated offsets per sample.
+    explicit sinc_table(size_t width = 400, size_t phases = 256);
+
+    size_t get_width() const;
+    size_t get_phases() const;
+
+    /// The number of taps in each kernel.
+    /// Tap k of the kernel for an impulse centred at sample (i + fraction)
+    /// belongs in output sample (i - width / 2 + k).
+    size_t get_taps() const;
+
+    /// The kernel for an offset of (phase / phases) samples.
+    /// phase may be in the range [0, phases], inclusive.
+    const float* get_kernel(size_t phase) const;
+
+private:
+    size_t width_;
+    size_t phases_;
+
+    /// phases + 1 kernels of get_taps() values, stored contiguously.
+    util::aligned::vector<float> table_;
+};
+
+/// A table with the default width and resolution, shared by all callers.
+const sinc_table& get_default_sinc_table();
+
+/// Produces the same output as sinc_sum_functor (to within the error bound
+/// of the table), but avoids evaluating trig functions for every sample.
+/// The inner loops are branch-free over contiguous memory so that they can
+/// be vectorised.
+class sinc_table_sum_functor final {
+public:
+    explicit sinc_table_sum_functor(
+            const sinc_table& table = get_default_sinc_table())
+            : table_{&table} {}
+
+    template <typename T, typename Ret>
+    void operator()(const T& item, double sample_rate, Ret& ret) const {
+        const ptrdiff_t half_width = table_->get_width() / 2;
+        const ptrdiff_t taps = table_->get_taps();
+
+        const auto centre_sample = time(item) * sample_rate;
+        const auto integral = std::floor(centre_sample);
+
+        //  Find the pair of phases which bracket the fractional offset.
+        const auto scaled_phase =
+                (centre_sample - integral) * table_->get_phases();
+        const auto phase = std::min(static_cast<size_t>(scaled_phase),
+                                    table_->get_phases() - 1);
+        const auto mix = static_cast<float>(scaled_phase - phase);
+
+        const ptrdiff_t ideal_begin = integral - half_width;
+        const ptrdiff_t ideal_end = std::ceil(centre_sample + half_width);
+        ret.resize(std::max(ret.size(), static_cast<size_t>(ideal_end)));
+
+        const auto begin_samp =
+                std::max(static_cast<ptrdiff_t>(0), ideal_begin);
+        const auto end_samp = std::min(
+                {static_cast<ptrdiff_t>(ret.size()),
+                 ideal_end,
+                 ideal_begin + taps});
+
+        const auto offset = begin_samp - ideal_begin;
+        const auto lower = table_->get_kernel(phase) + offset;
+        const auto upper = table_->get_kernel(phase + 1) + offset;
+        const auto vol = volume(item);
+        const auto out = ret.data() + begin_samp;
+
+        for (ptrdiff_t i = 0, samples = end_samp - begin_samp; i < samples;
+             ++i) {
+            out[i] += vol * (lower[i] + mix * (upper[i] - lower[i]));
+        }
+    }
+
+private:
+    const sinc_table* table_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 /// These functions are for volume/distance pairs rather than volume/time.
 
 template <typename T>
@@ -34,7 +34,7 @@ auto postprocess(InputIt b,
     auto hist = histogram(make_iterator(b),
                           make_iterator(e),
                           sample_rate,
-                          sinc_sum_functor{});
+                          sinc_table_sum_functor{});
     return core::multiband_filter_and_mixdown(
             begin(hist), end(hist), sample_rate, [](auto it, auto index) {
                 return core::make_cl_type_iterator(std::move(it), index);
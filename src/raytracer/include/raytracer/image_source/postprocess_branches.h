@@ -4,9 +4,11 @@
 #include "raytracer/image_source/tree.h"
 
 #include "core/callback_accumulator.h"
+#include "core/environment.h"
 #include "core/spatial_division/voxelised_scene_data.h"
 
 #include "utilities/aligned/vector.h"
+#include "utilities/map_to_vector.h"
 
 #include <future>
 
@@ -15,7 +17,7 @@ namespace raytracer {
 namespace image_source {
 
 util::aligned::vector<impulse<core::simulation_bands>> postprocess_branches(
-        const multitree<path_element>& tree,
+        const multitree<path_element>::node_type& tree,
         const glm::vec3& source,
         const glm::vec3& receiver,
         const core::voxelised_scene_data<cl_float3,
@@ -35,7 +37,9 @@ auto postprocess_branches(
         bool flip_phase) {
     auto futures = util::map_to_vector(
             b_branches, e_branches, [&](const auto& branch) {
-                return std::async(std::launch::async, [&] {
+                //  Branches are lightweight views, so they are captured by
+                //  value.
+                return std::async(std::launch::async, [&, branch] {
                     return postprocess_branches(
                             branch, source, receiver, voxelised, flip_phase);
                 });
@@ -54,6 +58,75 @@ auto postprocess_branches(
     return ret;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+/// A valid image-source path, stored without any surface information.
+/// Paths depend only on the scene geometry and the source and receiver
+/// positions, so they can be re-evaluated cheaply if the surfaces change.
+struct image_source_path final {
+    glm::vec3 image_source;
+    util::aligned::vector<reflection_metadata> reflections;
+};
+
+/// Find all the valid image-source paths for a receiver, including the
+/// line-of-sight path (which has no reflections).
+util::aligned::vector<image_source_path> compute_image_source_paths(
+        const tree& tree,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+                voxelised);
+
+/// Compute the impulse contributed by each path, using the given surfaces,
+/// with volumes corrected for distance travelled.
+util::aligned::vector<impulse<core::simulation_bands>>
+compute_image_source_impulses(
+        const util::aligned::vector<image_source_path>& paths,
+        const util::aligned::vector<core::surface<core::simulation_bands>>&
+                surfaces,
+        const glm::vec3& receiver,
+        const core::environment& environment,
+        bool flip_phase);
+
+/// Find all the image-source impulses for a receiver, including the
+/// line-of-sight contribution, with volumes corrected for distance travelled.
+util::aligned::vector<impulse<core::simulation_bands>> postprocess_tree(
+        const tree& tree,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::environment& environment,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+                voxelised,
+        bool flip_phase);
+
+/// Evaluate a single tree for a collection of receivers.
+/// The tree must have been built without receiver visibility information
+/// (see make_image_source_tree), or paths may be missed.
+/// Returns one collection of impulses per receiver, in order.
+template <typename It>
+auto postprocess_tree(
+        const tree& tree,
+        const glm::vec3& source,
+        It b_receivers,
+        It e_receivers,
+        const core::environment& environment,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+                voxelised,
+        bool flip_phase) {
+    return util::map_to_vector(
+            b_receivers, e_receivers, [&](const glm::vec3& receiver) {
+                return postprocess_tree(tree,
+                                        source,
+                                        receiver,
+                                        environment,
+                                        voxelised,
+                                        flip_phase);
+            });
+}
+
 }  // namespace image_source
 }  // namespace raytracer
 }  // namespace wayverb
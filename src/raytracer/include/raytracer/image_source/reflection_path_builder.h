@@ -9,16 +9,22 @@ namespace image_source {
 
 class reflection_path_builder final {
 public:
-    reflection_path_builder(size_t rays)
-            : reflection_path_builder_{rays} {}
+    /// If use_receiver_visibility is false, every path element is marked
+    /// visible, so that the resulting paths can be checked against any
+    /// receiver, rather than just the one used during raytracing.
+    reflection_path_builder(size_t rays, bool use_receiver_visibility = true)
+            : reflection_path_builder_{rays}
+            , use_receiver_visibility_{use_receiver_visibility} {}
 
     template <typename It>
     void push(It b, It e) {
-        reflection_path_builder_.push(b, e, [](const reflection& i) {
+        reflection_path_builder_.push(b, e, [&](const reflection& i) {
             return i.keep_going
                            ? std::make_optional(path_element{
                                      i.triangle,
-                                     static_cast<bool>(i.receiver_visible)})
+                                     !use_receiver_visibility_ ||
+                                             static_cast<bool>(
+                                                     i.receiver_visible)})
                            : std::nullopt;
         });
     }
@@ -28,6 +34,7 @@ public:
 
 private:
     iterative_builder<path_element> reflection_path_builder_;
+    bool use_receiver_visibility_;
 };
 
 }  // namespace image_source
@@ -44,6 +44,57 @@ auto run(
     return std::move(std::get<0>(*results));
 }
 
+/// Find image-source impulses for several receivers.
+/// The rays are traced and the image-source tree is built once, and then
+/// the tree is evaluated for each receiver in turn.
+/// Returns one collection of impulses per receiver.
+template <typename It, typename Jt>
+auto run(
+        It b,  /// Iterators over ray directions.
+        It e,
+        const core::compute_context& cc,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+                voxelised,
+        const glm::vec3& source,
+        Jt b_receivers,  /// Iterators over receiver positions.
+        Jt e_receivers,
+        const core::environment& environment) {
+    util::aligned::vector<util::aligned::vector<impulse<8>>> ret;
+    if (b_receivers == e_receivers) {
+        return ret;
+    }
+
+    const auto callbacks = std::make_tuple(
+            raytracer::reflection_processor::make_image_source_tree{
+                    std::numeric_limits<size_t>::max()});
+
+    //  The tree doesn't depend on the receiver, but the raytracer needs one
+    //  anyway, so we just use the first.
+    auto results = raytracer::run(b,
+                                  e,
+                                  cc,
+                                  voxelised,
+                                  source,
+                                  *b_receivers,
+                                  environment,
+                                  true,
+                                  [](auto /*i*/, auto /*steps*/) {},
+                                  callbacks);
+
+    if (!results) {
+        throw std::runtime_error{"Raytracer failed to generate results."};
+    }
+
+    return postprocess_tree(std::get<0>(*results),
+                            source,
+                            b_receivers,
+                            e_receivers,
+                            environment,
+                            voxelised,
+                            false);
+}
+
 }  // namespace image_source
 }  // namespace raytracer
 }  // namespace wayverb
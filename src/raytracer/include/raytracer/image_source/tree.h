@@ -41,8 +41,16 @@ constexpr bool operator<(const path_element& a, const path_element& b) {
 
 class tree final {
 public:
-    void push(const util::aligned::vector<path_element>& path);
-    const multitree<path_element>::branches_type& get_branches() const;
+    /// Adds a batch of paths.
+    /// The tree is stored flat, so every call rebuilds it: collect as many
+    /// paths as possible before pushing them.
+    /// It is an iterator over ranges of path_element.
+    template <typename It>
+    void push(It b, It e) {
+        root_.insert(b, e);
+    }
+
+    multitree<path_element>::branches_type get_branches() const;
 
 private:
     multitree<path_element> root_{path_element{}};
@@ -53,14 +61,30 @@ using postprocessor = std::function<void(
         util::aligned::vector<reflection_metadata>::const_iterator,
         util::aligned::vector<reflection_metadata>::const_iterator)>;
 
-void find_valid_paths(
-        const multitree<path_element>& tree,
+/// Counts of the nodes considered during a call to find_valid_paths.
+struct traversal_statistics final {
+    /// Nodes for which an image source was computed.
+    size_t visited{0};
+    /// Nodes which were found to be unreachable, and whose subtrees were
+    /// skipped.
+    size_t pruned{0};
+};
+
+/// Call `callback` for each valid image-source path below (and including)
+/// `tree`.
+/// If `prune` is true, subtrees are skipped when their reflecting triangle
+/// definitely can't be hit from the previous image source through the
+/// previous triangle.
+/// The test is conservative, so the paths found are the same either way.
+traversal_statistics find_valid_paths(
+        const multitree<path_element>::node_type& tree,
         const glm::vec3& source,
         const glm::vec3& receiver,
         const core::voxelised_scene_data<cl_float3,
                                          core::surface<core::simulation_bands>>&
                 voxelised,
-        const postprocessor& callback);
+        const postprocessor& callback,
+        bool prune = true);
 
 }  // namespace image_source
 }  // namespace raytracer
@@ -1,56 +1,328 @@
 #pragma once
 
-#include "core/recursive_vector.h"
+#include "utilities/aligned/vector.h"
 
-#include <set>
+#include <algorithm>
+#include <iterator>
+#include <limits>
 
 namespace wayverb {
 namespace raytracer {
 
-/// A tree node holds a single item, and optionally a collection of
-/// following items.
 template <typename T>
-struct multitree final {
-    explicit multitree(T item = T{})
-            : item(std::move(item)) {}
+class multitree;
+
+template <typename T>
+class multitree_branches;
+
+/// A lightweight view of a single node in a multitree.
+/// A node holds a single item, and optionally a collection of following
+/// items.
+template <typename T>
+class multitree_node final {
+public:
+    multitree_node(const multitree<T>& tree, size_t index);
+
+    const T& item;
+    multitree_branches<T> branches;
+};
+
+/// A view of the (sorted, contiguous) children of a multitree node.
+template <typename T>
+class multitree_branches final {
+public:
+    class const_iterator final {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = multitree_node<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = multitree_node<T>;
+
+        /// Allows `it->item` even though nodes are returned by value.
+        struct arrow_proxy final {
+            multitree_node<T> node;
+            const multitree_node<T>* operator->() const { return &node; }
+        };
+
+        constexpr const_iterator(const multitree<T>& tree, size_t index)
+                : tree_{&tree}
+                , index_{index} {}
+
+        multitree_node<T> operator*() const { return {*tree_, index_}; }
+        arrow_proxy operator->() const { return {**this}; }
+
+        constexpr const_iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+
+        constexpr const_iterator operator++(int) {
+            auto ret = *this;
+            ++index_;
+            return ret;
+        }
+
+        constexpr difference_type operator-(const const_iterator& rhs) const {
+            return index_ - rhs.index_;
+        }
+
+        constexpr bool operator==(const const_iterator& rhs) const {
+            return index_ == rhs.index_;
+        }
 
-    T item;
-    using branches_type = core::recursive_vector_backed_set<multitree<T>>;
-    branches_type branches;
+        constexpr bool operator!=(const const_iterator& rhs) const {
+            return !operator==(rhs);
+        }
+
+    private:
+        const multitree<T>* tree_;
+        size_t index_;
+    };
+
+    constexpr multitree_branches(const multitree<T>& tree,
+                                 size_t begin,
+                                 size_t end)
+            : tree_{&tree}
+            , begin_{begin}
+            , end_{end} {}
+
+    const_iterator begin() const { return {*tree_, begin_}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator end() const { return {*tree_, end_}; }
+    const_iterator cend() const { return end(); }
+
+    constexpr size_t size() const { return end_ - begin_; }
+    constexpr bool empty() const { return begin_ == end_; }
+
+private:
+    const multitree<T>* tree_;
+    size_t begin_;
+    size_t end_;
 };
 
 template <typename T>
-constexpr bool operator<(const multitree<T>& a, const multitree<T>& b) {
-    return a.item < b.item;
+auto begin(const multitree_branches<T>& b) {
+    return b.begin();
+}
+
+template <typename T>
+auto end(const multitree_branches<T>& b) {
+    return b.end();
 }
 
-template <typename T, typename It>
-void add_path(multitree<T>& tree, It begin, It end) {
-    if (begin != end) {
-        const auto it = tree.branches.insert(multitree<T>{*begin}).first;
-        add_path(*it, std::next(begin), end);
+/// A prefix tree of paths.
+/// Nodes are stored in a single flat array in breadth-first order, so the
+/// children of each node occupy a contiguous span, sorted by item.
+/// Paths are added in bulk, which keeps allocations to a minimum and gives
+/// good locality during traversal.
+template <typename T>
+class multitree final {
+public:
+    using node_type = multitree_node<T>;
+    using branches_type = multitree_branches<T>;
+
+    explicit multitree(T item = T{})
+            : nodes_{node{std::move(item), 1, 1}} {}
+
+    node_type root() const { return {*this, 0}; }
+    branches_type get_branches() const { return root().branches; }
+
+    /// The number of nodes in the tree, not counting the root.
+    size_t size() const { return nodes_.size() - 1; }
+
+    /// Merge a collection of paths into the tree.
+    /// It is an iterator over ranges of T.
+    /// The paths are sorted, and then merged breadth-first with the existing
+    /// nodes, so the cost is linear in the size of the tree plus the size of
+    /// the input.
+    /// Where two items compare equivalent, the one which was added first is
+    /// kept, so the result is the same as adding each path in turn.
+    template <typename It>
+    void insert(It b, It e) {
+        using path_type = std::decay_t<decltype(*b)>;
+
+        struct sortable_path final {
+            const path_type* path;
+            size_t order;
+        };
+
+        util::aligned::vector<sortable_path> paths;
+        for (size_t order = 0; b != e; ++b, ++order) {
+            if (std::begin(*b) != std::end(*b)) {
+                paths.emplace_back(sortable_path{&*b, order});
+            }
+        }
+
+        if (paths.empty()) {
+            return;
+        }
+
+        std::stable_sort(
+                paths.begin(),
+                paths.end(),
+                [](const auto& x, const auto& y) {
+                    return std::lexicographical_compare(std::begin(*x.path),
+                                                        std::end(*x.path),
+                                                        std::begin(*y.path),
+                                                        std::end(*y.path));
+                });
+
+        const auto path_size = [&](size_t i) -> size_t {
+            return std::distance(std::begin(*paths[i].path),
+                                 std::end(*paths[i].path));
+        };
+
+        const auto element = [&](size_t i, size_t depth) -> const T& {
+            return *std::next(std::begin(*paths[i].path), depth);
+        };
+
+        constexpr auto none = std::numeric_limits<size_t>::max();
+
+        /// For each new node, where its children should come from.
+        /// Work items are stored in the same order as the new nodes, so
+        /// processing them in order builds the tree breadth-first.
+        struct work_item final {
+            size_t existing;
+            size_t paths_begin;
+            size_t paths_end;
+            size_t depth;
+        };
+
+        util::aligned::vector<node> new_nodes{nodes_.front()};
+        util::aligned::vector<work_item> work{
+                work_item{0, 0, paths.size(), 0}};
+        new_nodes.reserve(nodes_.size() + paths.size());
+        work.reserve(nodes_.size() + paths.size());
+
+        const auto add_child = [&](const T& item, work_item w) {
+            new_nodes.emplace_back(node{item, 0, 0});
+            work.emplace_back(w);
+        };
+
+        for (size_t current = 0; current != new_nodes.size(); ++current) {
+            const auto w = work[current];
+
+            auto i = w.existing == none ? 0 : nodes_[w.existing].branches_begin;
+            const auto i_end =
+                    w.existing == none ? 0 : nodes_[w.existing].branches_end;
+
+            //  Paths which end at this node sort first, and have no
+            //  children.
+            auto j = w.paths_begin;
+            while (j != w.paths_end && path_size(j) <= w.depth) {
+                ++j;
+            }
+
+            const auto children_begin = new_nodes.size();
+
+            while (i != i_end || j != w.paths_end) {
+                //  Find the run of paths which share an item at this depth.
+                auto group_end = j;
+                if (j != w.paths_end) {
+                    while (group_end != w.paths_end &&
+                           !(element(j, w.depth) <
+                             element(group_end, w.depth))) {
+                        ++group_end;
+                    }
+                }
+
+                const auto take_existing =
+                        i != i_end &&
+                        (j == w.paths_end ||
+                         !(element(j, w.depth) < nodes_[i].item));
+                const auto take_new =
+                        j != w.paths_end &&
+                        (i == i_end || !(nodes_[i].item < element(j, w.depth)));
+
+                if (take_existing) {
+                    //  Existing items always win, because they were added
+                    //  first.
+                    add_child(nodes_[i].item,
+                              take_new ? work_item{i, j, group_end, w.depth + 1}
+                                       : work_item{i, j, j, w.depth + 1});
+                    ++i;
+                } else {
+                    //  Use the item from the earliest-added path in the
+                    //  group.
+                    auto earliest = j;
+                    for (auto k = j; k != group_end; ++k) {
+                        if (paths[k].order < paths[earliest].order) {
+                            earliest = k;
+                        }
+                    }
+                    add_child(element(earliest, w.depth),
+                              work_item{none, j, group_end, w.depth + 1});
+                }
+
+                if (take_new) {
+                    j = group_end;
+                }
+            }
+
+            new_nodes[current].branches_begin = children_begin;
+            new_nodes[current].branches_end = new_nodes.size();
+        }
+
+        nodes_ = std::move(new_nodes);
     }
+
+private:
+    friend class multitree_node<T>;
+
+    struct node final {
+        T item;
+        size_t branches_begin;
+        size_t branches_end;
+    };
+
+    util::aligned::vector<node> nodes_;
+};
+
+template <typename T>
+multitree_node<T>::multitree_node(const multitree<T>& tree, size_t index)
+        : item{tree.nodes_[index].item}
+        , branches{tree,
+                   tree.nodes_[index].branches_begin,
+                   tree.nodes_[index].branches_end} {}
+
+/// Callbacks may provide an overload of this function (found by ADL) to stop
+/// the traversal from descending into the branches of the current node.
+template <typename Callback>
+constexpr bool should_descend(const Callback&) {
+    return true;
 }
 
 namespace detail {
 
 /// The trick here is that the callback can be a stateful object...
 template <typename T, typename Callback>
-void traverse_multitree(const multitree<T>& tree, const Callback& callback) {
-    const auto next = callback(tree.item);
-    for (const auto& i : tree.branches) {
+void traverse_multitree(const multitree_node<T>& node,
+                        const Callback& callback) {
+    const auto next = callback(node.item);
+    if (!should_descend(next)) {
+        return;
+    }
+    for (const auto& i : node.branches) {
         detail::traverse_multitree(i, next);
     }
 }
 
 }  // namespace detail
 
+/// Traverse all the branches below a node, but not the node itself.
 template <typename T, typename Callback>
-void traverse_multitree(const multitree<T>& tree, const Callback& callback) {
-    for (const auto& i : tree.branches) {
+void traverse_multitree(const multitree_node<T>& node,
+                        const Callback& callback) {
+    for (const auto& i : node.branches) {
         detail::traverse_multitree(i, callback);
     }
 }
 
+template <typename T, typename Callback>
+void traverse_multitree(const multitree<T>& tree, const Callback& callback) {
+    traverse_multitree(tree.root(), callback);
+}
+
 }  // namespace raytracer
 }  // namespace wayverb
@@ -33,5 +33,42 @@ auto postprocess(const simulation_results<Histogram>& input,
     return core::sum_vectors(head, tail);
 }
 
+/// Postprocess for several receivers at the same position, such as the
+/// capsules of a multi-capsule microphone.
+/// It is an iterator over attenuation methods.
+/// Returns one signal per method.
+template <typename Histogram, typename It>
+auto postprocess(const simulation_results<Histogram>& input,
+                 It b_methods,
+                 It e_methods,
+                 const glm::vec3& position,
+                 double room_volume,
+                 const core::environment& environment,
+                 double output_sample_rate) {
+    const auto tails = raytracer::stochastic::postprocess(input.stochastic,
+                                                          b_methods,
+                                                          e_methods,
+                                                          room_volume,
+                                                          environment,
+                                                          output_sample_rate);
+
+    util::aligned::vector<util::aligned::vector<float>> ret;
+    ret.reserve(tails.size());
+
+    auto tail = begin(tails);
+    for (auto method = b_methods; method != e_methods; ++method, ++tail) {
+        const auto head = raytracer::image_source::postprocess(
+                begin(input.image_source),
+                end(input.image_source),
+                *method,
+                position,
+                environment.speed_of_sound,
+                output_sample_rate);
+        ret.emplace_back(core::sum_vectors(head, *tail));
+    }
+
+    return ret;
+}
+
 }  // namesapce raytracer
 }  // namespace wayverb
@@ -18,9 +18,11 @@
 
 #include "utilities/apply.h"
 #include "utilities/map.h"
+#include "utilities/trace.h"
 
-#include <optional>
+#include <future>
 #include <iostream>
+#include <optional>
 
 namespace wayverb {
 namespace raytracer {
@@ -199,6 +201,7 @@ auto run(
         const std::atomic_bool& keep_going,
         PerStepCallback&& per_step_callback,
         Callbacks&& callbacks) {
+    const util::trace::scope scope{"raytracer"};
     const core::scene_buffers buffers{cc.context, voxelised};
 
     const auto make_ray_iterator = [&](auto it) {
@@ -220,9 +223,17 @@ auto run(
     const auto reflection_depth =
             compute_optimum_reflection_number(voxelised.get_scene_data());
 
-    const auto run_segment = [&](auto b, auto e) {
+    //  Each segment owns a reflector and a set of group processors, each of
+    //  which has its own command queue.
+    //  This means that the device work for one segment can run on a worker
+    //  thread while the host accumulates the results of the previous
+    //  segment into the processors.
+    const auto start_segment = [&](auto b, auto e) {
         const auto num_directions = std::distance(b, e);
 
+        //  The reflector and group processors are constructed here, on the
+        //  calling thread, because reading from the direction iterators
+        //  might not be thread-safe.
         reflector ref{cc, receiver, make_ray_iterator(b), make_ray_iterator(e)};
 
         auto group_processors = util::apply_each(
@@ -230,35 +241,72 @@ auto run(
                           processors),
                 std::make_tuple(num_directions));
 
-        for (auto i = 0ul; i != reflection_depth; ++i) {
-            const auto reflections = ref.run_step(buffers);
-            const auto b = begin(reflections);
-            const auto e = end(reflections);
-            util::call_each(
-                    util::map(make_process_functor_adapter{}, group_processors),
-                    std::tie(b, e, buffers, i, reflection_depth));
-        }
-
-        zip_apply(util::map(make_accumulate_functor_adapter{}, processors),
-                  group_processors);
+        return std::async(
+                std::launch::async,
+                [&buffers,
+                 reflection_depth,
+                 num_directions,
+                 ref = std::move(ref),
+                 group_processors = std::move(group_processors)]() mutable {
+                    const util::trace::scope scope{"raytracer segment",
+                                                   "segment"};
+                    for (auto i = 0ul; i != reflection_depth; ++i) {
+                        const auto reflections = ref.run_step(buffers);
+                        const auto b = begin(reflections);
+                        const auto e = end(reflections);
+                        util::call_each(
+                                util::map(make_process_functor_adapter{},
+                                          group_processors),
+                                std::tie(b, e, buffers, i, reflection_depth));
+                    }
+                    util::trace::count("raytracer", "rays", num_directions);
+                    util::trace::count("raytracer",
+                                       "ray bounces",
+                                       static_cast<double>(num_directions) *
+                                               reflection_depth);
+                    return std::move(group_processors);
+                });
     };
 
-    const auto groups = std::distance(b_direction, e_direction) / segment_size;
+    const std::ptrdiff_t total_directions =
+            std::distance(b_direction, e_direction);
+    const auto groups = total_directions / segment_size;
+    const auto segments = groups + (total_directions % segment_size ? 1 : 0);
+
+    const auto segment_begin = [&](std::ptrdiff_t segment) {
+        return b_direction +
+               std::min(segment * segment_size, total_directions);
+    };
 
-    auto it = b_direction;
-    for (auto group = 0; it + segment_size <= e_direction;
-         it += segment_size, ++group) {
-        run_segment(it, it + segment_size);
+    //  Keep at most two segments in flight: the one being accumulated on this
+    //  thread, and the one being traced on the device.
+    decltype(start_segment(b_direction, e_direction)) in_flight;
+    if (segments) {
+        in_flight = start_segment(segment_begin(0), segment_begin(1));
+    }
 
-        per_step_callback(group, groups);
+    for (std::ptrdiff_t segment = 0; segment != segments; ++segment) {
+        const auto group_processors = in_flight.get();
 
-        if (!keep_going) {
-            return std::optional<return_type>{};
+        if (segment + 1 != segments && keep_going) {
+            in_flight = start_segment(segment_begin(segment + 1),
+                                      segment_begin(segment + 2));
         }
-    }
 
-    if (it != e_direction) {
-        run_segment(it, e_direction);
+        //  Segments are accumulated in order, so results match a sequential
+        //  run exactly.
+        const util::trace::scope accumulate_scope{"raytracer accumulate",
+                                                  "segment"};
+        zip_apply(util::map(make_accumulate_functor_adapter{}, processors),
+                  group_processors);
+
+        if (segment < groups) {
+            per_step_callback(segment, groups);
+
+            if (!keep_going) {
+                return std::optional<return_type>{};
+            }
+        }
     }
 
     return std::make_optional(util::apply_each(
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "raytracer/image_source/postprocess_branches.h"
 #include "raytracer/image_source/reflection_path_builder.h"
 
 #include "core/cl/common.h"
@@ -12,7 +13,9 @@ namespace reflection_processor {
 
 class image_source_group_processor final {
 public:
-    image_source_group_processor(size_t max_order, size_t items);
+    image_source_group_processor(size_t max_order,
+                                 size_t items,
+                                 bool use_receiver_visibility = true);
 
     template <typename It>
     void process(It b,
@@ -68,6 +71,60 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/// Finds the valid image-source paths for a receiver, but doesn't evaluate
+/// them, so that they can be reused if the surfaces change.
+class image_source_paths_processor final {
+public:
+    image_source_paths_processor(
+            const glm::vec3& source,
+            const glm::vec3& receiver,
+            const core::voxelised_scene_data<
+                    cl_float3,
+                    core::surface<core::simulation_bands>>& voxelised,
+            size_t max_order);
+
+    image_source_group_processor get_group_processor(
+            size_t num_directions) const;
+    void accumulate(const image_source_group_processor& processor);
+
+    util::aligned::vector<raytracer::image_source::image_source_path>
+    get_results() const;
+
+private:
+    glm::vec3 source_;
+    glm::vec3 receiver_;
+    const core::voxelised_scene_data<cl_float3,
+                                     core::surface<core::simulation_bands>>&
+            voxelised_;
+
+    size_t max_order_;
+
+    raytracer::image_source::tree tree_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Builds an image-source tree which depends only on the source and scene.
+/// The tree can then be evaluated for any number of receivers, so that
+/// multi-receiver simulations only need to raytrace once per source.
+class image_source_tree_processor final {
+public:
+    explicit image_source_tree_processor(size_t max_order);
+
+    image_source_group_processor get_group_processor(
+            size_t num_directions) const;
+    void accumulate(const image_source_group_processor& processor);
+
+    raytracer::image_source::tree get_results() const;
+
+private:
+    size_t max_order_;
+
+    raytracer::image_source::tree tree_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 class make_image_source final {
 public:
     make_image_source(size_t max_order);
@@ -85,6 +142,44 @@ private:
     size_t max_order_;
 };
 
+////////////////////////////////////////////////////////////////////////////////
+
+class make_image_source_paths final {
+public:
+    explicit make_image_source_paths(size_t max_order);
+
+    image_source_paths_processor get_processor(
+            const core::compute_context& cc,
+            const glm::vec3& source,
+            const glm::vec3& receiver,
+            const core::environment& environment,
+            const core::voxelised_scene_data<
+                    cl_float3,
+                    core::surface<core::simulation_bands>>& voxelised) const;
+
+private:
+    size_t max_order_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class make_image_source_tree final {
+public:
+    explicit make_image_source_tree(size_t max_order);
+
+    image_source_tree_processor get_processor(
+            const core::compute_context& cc,
+            const glm::vec3& source,
+            const glm::vec3& receiver,
+            const core::environment& environment,
+            const core::voxelised_scene_data<
+                    cl_float3,
+                    core::surface<core::simulation_bands>>& voxelised) const;
+
+private:
+    size_t max_order_;
+};
+
 }  // namespace reflection_processor
 }  // namespace raytracer
 }  // namespace wayverb
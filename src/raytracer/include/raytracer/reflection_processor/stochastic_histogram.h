@@ -2,6 +2,7 @@
 
 #include "raytracer/histogram.h"
 #include "raytracer/simulation_parameters.h"
+#include "raytracer/stochastic/device_histogram.h"
 #include "raytracer/stochastic/finder.h"
 #include "raytracer/stochastic/postprocessing.h"
 
@@ -21,13 +22,11 @@ void energy_histogram_sum(const T& item,
     ret[time(item) * sample_rate] += volume(item);
 }
 
-template <typename T, typename U, typename Alloc, size_t Az, size_t El>
-void energy_histogram_sum(
-        const T& item,
-        double sample_rate,
-        core::vector_look_up_table<std::vector<U, Alloc>, Az, El>& ret) {
-    using table = std::decay_t<decltype(ret)>;
-    ret.at(table::index(item.pointing))[time(item) * sample_rate] +=
+template <typename T, size_t Az, size_t El>
+void energy_histogram_sum(const T& item,
+                          double sample_rate,
+                          stochastic::directional_histogram<Az, El>& ret) {
+    ret.at(ret.index(item.pointing), time(item) * sample_rate) +=
             volume(item);
 }
 
@@ -62,61 +61,41 @@ public:
                       receiver_radius,
                       stochastic::compute_ray_energy(
                               total_rays, source, receiver, receiver_radius))
-            , receiver_{receiver}
-            , environment_{environment}
             , max_image_source_order_{max_image_source_order}
+            , device_histogram_{
+                      cc,
+                      environment.speed_of_sound,
+                      histogram_sample_rate,
+                      stochastic::histogram_divisions<Histogram>::azimuth,
+                      stochastic::histogram_divisions<Histogram>::elevation}
             , histogram_{histogram_sample_rate} {}
 
+    /// Energy is binned on the device, and the histogram is only read back
+    /// once the final step of the segment has been processed.
     template <typename It>
     void process(It b,
                  It e,
                  const core::scene_buffers& buffers,
                  size_t step,
-                 size_t /*total*/) {
-        const auto output = finder_.process(b, e, buffers);
-
-        struct intermediate_impulse final {
-            core::bands_type volume;
-            double time;
-            glm::vec3 pointing;
-        };
-
-        const auto intermediate = [&] {
-            util::aligned::vector<intermediate_impulse> ret;
-            ret.reserve(output.stochastic.size() + output.specular.size());
-
-            const auto push_vector = [&](const auto& vec) {
-                for (const auto& impulse : vec) {
-                    ret.emplace_back(intermediate_impulse{
-                            impulse.volume,
-                            impulse.distance / environment_.speed_of_sound,
-                            glm::normalize(core::to_vec3{}(impulse.position) -
-                                           receiver_)});
-                }
-            };
-
-            push_vector(output.stochastic);
-            if (max_image_source_order_ <= step) {
-                push_vector(output.specular);
-            }
-
-            return ret;
-        }();
-
-        incremental_histogram(histogram_.histogram,
-                              begin(intermediate),
-                              end(intermediate),
-                              histogram_.sample_rate,
-                              energy_histogram_sum_functor{});
+                 size_t total) {
+        finder_.process(b,
+                        e,
+                        buffers,
+                        device_histogram_,
+                        max_image_source_order_ <= step);
+
+        if (step + 1 == total) {
+            unpack_histogram(finder_.read_histogram(device_histogram_),
+                             histogram_);
+        }
     }
 
     Histogram get_results() const { return histogram_; }
 
 private:
     stochastic::finder finder_;
-    glm::vec3 receiver_;
-    core::environment environment_;
     size_t max_image_source_order_;
+    stochastic::device_histogram device_histogram_;
     Histogram histogram_;
 };
 
@@ -4,6 +4,7 @@
 
 #include "core/cl/geometry.h"
 #include "core/cl/include.h"
+#include "core/cl/trace.h"
 #include "core/geo/geometric.h"
 #include "core/spatial_division/scene_buffers.h"
 
@@ -30,7 +31,7 @@ public:
               It b,
               It e)
             : cc_{cc}
-            , queue_{cc.context, cc.device}
+            , queue_{cc.context, cc.device, core::get_queue_properties()}
             , kernel_{program{cc}.get_kernel()}
             , receiver_{core::to_cl_float3{}(receiver)}
             , rays_(std::distance(b, e))
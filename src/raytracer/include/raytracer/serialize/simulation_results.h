@@ -0,0 +1,28 @@
+#pragma once
+
+#include "raytracer/canonical.h"
+
+#include "core/serialize/cl.h"
+#include "core/serialize/surface.h"
+
+#include "cereal/types/vector.hpp"
+
+namespace cereal {
+
+template <typename Archive>
+void serialize(
+        Archive& archive,
+        wayverb::raytracer::impulse<wayverb::core::simulation_bands>& m) {
+    archive(make_nvp("volume", m.volume),
+            make_nvp("position", m.position),
+            make_nvp("distance", m.distance));
+}
+
+template <typename Archive, typename Histogram>
+void serialize(Archive& archive,
+               wayverb::raytracer::simulation_results<Histogram>& m) {
+    archive(make_nvp("image_source", m.image_source),
+            make_nvp("stochastic", m.stochastic));
+}
+
+}  // namespace cereal
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "raytracer/stochastic/postprocessing.h"
+
+#include "core/cl/common.h"
+#include "core/cl/scene_structs.h"
+
+#include "utilities/aligned/vector.h"
+
+namespace wayverb {
+namespace raytracer {
+namespace stochastic {
+
+/// A binned energy histogram which lives in device memory.
+/// Bins are stored time-major, so that all directions for a given time bin
+/// are contiguous: index = (time_bin * directions + direction).
+/// Each direction index is (azimuth_index * elevation_divisions +
+/// elevation_index), matching the layout of vector_look_up_table.
+/// A histogram with one azimuth and one elevation division is
+/// non-directional.
+class device_histogram final {
+public:
+    device_histogram(const core::compute_context& cc,
+                     double speed_of_sound,
+                     double sample_rate,
+                     size_t azimuth_divisions,
+                     size_t elevation_divisions);
+
+    /// Ensure that there is room for at least `bins` time bins, preserving
+    /// the current contents.
+    /// Storage grows geometrically, so repeated calls are amortised.
+    void reserve(cl::CommandQueue& queue, size_t bins);
+
+    /// Read back the used portion of the histogram.
+    util::aligned::vector<core::bands_type> read(
+            cl::CommandQueue& queue) const;
+
+    /// The number of time bins that have been written.
+    size_t get_bins() const;
+    void set_bins(size_t bins);
+
+    size_t get_directions() const;
+    size_t get_azimuth_divisions() const;
+    size_t get_elevation_divisions() const;
+    double get_sample_rate() const;
+
+    /// Multiply a distance by this to find its time bin.
+    cl_float get_bin_scale() const;
+
+    const cl::Buffer& get_histogram_buffer() const;
+    const cl::Buffer& get_extent_buffer() const;
+
+private:
+    cl::Context context_;
+    double sample_rate_;
+    cl_float bin_scale_;
+    size_t azimuth_divisions_;
+    size_t elevation_divisions_;
+
+    size_t bins_ = 0;
+    size_t capacity_ = 0;
+
+    cl::Buffer histogram_buffer_;
+
+    /// Single uint holding the one-past-the-end time bin seen so far.
+    cl::Buffer extent_buffer_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// The number of directional divisions required to fill a histogram type.
+template <typename Histogram>
+struct histogram_divisions;
+
+template <>
+struct histogram_divisions<energy_histogram> final {
+    static constexpr size_t azimuth = 1;
+    static constexpr size_t elevation = 1;
+};
+
+template <size_t Az, size_t El>
+struct histogram_divisions<directional_energy_histogram<Az, El>> final {
+    static constexpr size_t azimuth = Az;
+    static constexpr size_t elevation = El;
+};
+
+/// Convert a flat time-major histogram, as read back from a device_histogram,
+/// into a host histogram.
+void unpack_histogram(const util::aligned::vector<core::bands_type>& flat,
+                      energy_histogram& ret);
+
+template <size_t Az, size_t El>
+void unpack_histogram(const util::aligned::vector<core::bands_type>& flat,
+                      directional_energy_histogram<Az, El>& ret) {
+    //  The host histogram has the same layout as the device buffer.
+    ret.histogram = directional_histogram<Az, El>{flat};
+}
+
+}  // namespace stochastic
+}  // namespace raytracer
+}  // namespace wayverb
@@ -3,8 +3,10 @@
 #include "program.h"
 
 #include "raytracer/cl/structs.h"
+#include "raytracer/stochastic/device_histogram.h"
 
 #include "core/cl/common.h"
+#include "core/cl/trace.h"
 #include "core/conversions.h"
 #include "core/pressure_intensity.h"
 #include "core/spatial_division/scene_buffers.h"
@@ -47,20 +49,7 @@ public:
 
     template <typename It>
     auto process(It b, It e, const core::scene_buffers& scene_buffers) {
-        //  copy the current batch of reflections to the device
-        cl::copy(queue_, b, e, reflections_buffer_);
-
-        //  get the kernel and run it
-        kernel_(cl::EnqueueArgs(queue_, cl::NDRange(rays_)),
-                reflections_buffer_,
-                receiver_,
-                receiver_radius_,
-                scene_buffers.get_triangles_buffer(),
-                scene_buffers.get_vertices_buffer(),
-                scene_buffers.get_surfaces_buffer(),
-                stochastic_path_buffer_,
-                stochastic_output_buffer_,
-                specular_output_buffer_);
+        run_kernel(b, e, scene_buffers);
 
         const auto read_out_impulses = [&](const auto& buffer) {
             auto raw = core::read_from_buffer<impulse<core::simulation_bands>>(
@@ -78,12 +67,68 @@ public:
                        read_out_impulses(stochastic_output_buffer_)};
     }
 
+    /// Like process, but bins the found energy directly into a histogram in
+    /// device memory instead of reading the impulses back to the host.
+    /// Specular impulses are only added if include_specular is true.
+    template <typename It>
+    void process(It b,
+                 It e,
+                 const core::scene_buffers& scene_buffers,
+                 device_histogram& histogram,
+                 bool include_specular) {
+        run_kernel(b, e, scene_buffers);
+
+        accumulate(histogram, stochastic_output_buffer_);
+        if (include_specular) {
+            accumulate(histogram, specular_output_buffer_);
+        }
+    }
+
+    util::aligned::vector<core::bands_type> read_histogram(
+            const device_histogram& histogram);
+
 private:
+    finder(const program& prog,
+           const core::compute_context& cc,
+           size_t group_size,
+           const glm::vec3& source,
+           const glm::vec3& receiver,
+           float receiver_radius,
+           float starting_energy);
+
+    template <typename It>
+    void run_kernel(It b, It e, const core::scene_buffers& scene_buffers) {
+        //  copy the current batch of reflections to the device
+        cl::copy(queue_, b, e, reflections_buffer_);
+
+        //  get the kernel and run it
+        core::trace_kernel(
+                "stochastic",
+                kernel_(cl::EnqueueArgs(queue_, cl::NDRange(rays_)),
+                        reflections_buffer_,
+                        receiver_,
+                        receiver_radius_,
+                        scene_buffers.get_triangles_buffer(),
+                        scene_buffers.get_vertices_buffer(),
+                        scene_buffers.get_surfaces_buffer(),
+                        stochastic_path_buffer_,
+                        stochastic_output_buffer_,
+                        specular_output_buffer_));
+    }
+
+    void accumulate(device_histogram& histogram, const cl::Buffer& impulses);
+
     using kernel_t = decltype(std::declval<program>().get_kernel());
+    using histogram_extent_kernel_t =
+            decltype(std::declval<program>().get_histogram_extent_kernel());
+    using histogram_kernel_t =
+            decltype(std::declval<program>().get_histogram_kernel());
 
     core::compute_context cc_;
     cl::CommandQueue queue_;
     kernel_t kernel_;
+    histogram_extent_kernel_t histogram_extent_kernel_;
+    histogram_kernel_t histogram_kernel_;
     cl_float3 receiver_;
     cl_float receiver_radius_;
     size_t rays_;
@@ -6,38 +6,13 @@ namespace wayverb {
 namespace raytracer {
 namespace stochastic {
 
-struct size_functor final {
-    template <typename T>
-    auto operator()(const T& t) const {
-        return t.size();
-    }
-};
-
 template <size_t Az, size_t El, typename Method>
 auto postprocess(const directional_energy_histogram<Az, El>& histogram,
                  const Method& method,
                  double room_volume,
                  const core::environment& environment,
                  double sample_rate) {
-    const auto& table = histogram.histogram.table;
-
-    const auto max_size = std::accumulate(
-            std::begin(table),
-            std::end(table),
-            0ul,
-            [&](auto a, const auto& b) {
-                if (std::distance(std::begin(b), std::end(b)) == 0) {
-                    return a;
-                }
-                const auto make_size_iterator = [](auto it) {
-                    return util::make_mapping_iterator_adapter(std::move(it),
-                                                               size_functor{});
-                };
-                return std::max(
-                        a,
-                        *std::max_element(make_size_iterator(std::begin(b)),
-                                          make_size_iterator(std::end(b))));
-            });
+    const auto max_size = histogram.histogram.size();
 
     const auto max_seconds = max_size / histogram.sample_rate;
 
@@ -47,6 +22,29 @@ auto postprocess(const directional_energy_histogram<Az, El>& histogram,
             histogram, method, dirac_sequence, environment.acoustic_impedance);
 }
 
+/// Postprocess for several receivers at once.
+/// It is an iterator over attenuation methods.
+/// A single Dirac sequence is generated and split into bands, and is shared
+/// between all receivers, so each additional receiver only costs a weighting
+/// and mixdown.
+template <size_t Az, size_t El, typename It>
+auto postprocess(const directional_energy_histogram<Az, El>& histogram,
+                 It b_methods,
+                 It e_methods,
+                 double room_volume,
+                 const core::environment& environment,
+                 double sample_rate) {
+    const auto max_seconds = histogram.histogram.size() / histogram.sample_rate;
+
+    const auto dirac_sequence = generate_dirac_sequence(
+            environment.speed_of_sound, room_volume, sample_rate, max_seconds);
+    return postprocessing(histogram,
+                          b_methods,
+                          e_methods,
+                          dirac_sequence,
+                          environment.acoustic_impedance);
+}
+
 }  // namespace stochastic
 }  // namespace raytracer
 }  // namespace wayverb
@@ -9,10 +9,12 @@
 #include "hrtf/multiband.h"
 
 #include "utilities/aligned/vector.h"
+#include "utilities/map_to_vector.h"
 
 #include <array>
 #include <cmath>
 #include <random>
+#include <stdexcept>
 
 namespace wayverb {
 namespace raytracer {
@@ -58,6 +60,11 @@ dirac_sequence generate_dirac_sequence(double speed_of_sound,
 struct energy_histogram final {
     double sample_rate;
     util::aligned::vector<core::bands_type> histogram;
+
+    template <typename Archive>
+    void serialize(Archive& archive) {
+        archive(sample_rate, histogram);
+    }
 };
 
 template <typename T>
@@ -71,38 +78,126 @@ void sum_vectors(T& a, const T& b) {
 
 void sum_histograms(energy_histogram& a, const energy_histogram& b);
 
+/// Energy histograms for Az * El directions, stored in a single contiguous
+/// buffer.
+/// Storage is time-major with a fixed direction stride: the entry for time
+/// bin b in direction d is at (b * directions + d), where d is
+/// (azimuth_index * El + elevation_index).
+/// This matches the layout of device_histogram, and means that growing the
+/// histogram or summing two histograms are single linear sweeps.
+template <size_t Az, size_t El>
+class directional_histogram final {
+public:
+    using table_type = core::vector_look_up_table<core::bands_type, Az, El>;
+    using index_pair = typename table_type::index_pair;
+
+    static constexpr size_t directions = Az * El;
+
+    directional_histogram() = default;
+
+    /// Takes ownership of a flat, time-major buffer.
+    explicit directional_histogram(util::aligned::vector<core::bands_type> data)
+            : data_{std::move(data)} {
+        if (data_.size() % directions) {
+            throw std::runtime_error{
+                    "Histogram buffer size must be a multiple of the number "
+                    "of directions."};
+        }
+    }
+
+    static constexpr size_t direction(index_pair i) {
+        return i.azimuth * El + i.elevation;
+    }
+
+    static auto index(const glm::vec3& pointing) {
+        return table_type::index(pointing);
+    }
+
+    static auto pointing(index_pair i) { return table_type::pointing(i); }
+
+    /// The number of time bins.
+    size_t size() const { return data_.size() / directions; }
+
+    /// Ensure there are at least `bins` time bins.
+    /// New bins are zeroed.
+    /// Capacity grows geometrically, so repeated calls are amortised.
+    void resize_if_necessary(size_t bins) {
+        const auto required = bins * directions;
+        if (data_.size() < required) {
+            if (data_.capacity() < required) {
+                data_.reserve(std::max(required, data_.capacity() * 2));
+            }
+            data_.resize(required);
+        }
+    }
+
+    auto& at(index_pair i, size_t bin) {
+        return data_[bin * directions + direction(i)];
+    }
+    const auto& at(index_pair i, size_t bin) const {
+        return data_[bin * directions + direction(i)];
+    }
+
+    /// All directions for a single time bin, as a contiguous array of
+    /// `directions` elements.
+    auto bin(size_t bin) { return data_.data() + bin * directions; }
+    auto bin(size_t bin) const { return data_.data() + bin * directions; }
+
+    /// The whole flat buffer.
+    auto& data() { return data_; }
+    const auto& data() const { return data_; }
+
+    /// A copy of the histogram for a single direction.
+    util::aligned::vector<core::bands_type> get_direction(index_pair i) const {
+        util::aligned::vector<core::bands_type> ret(size());
+        for (auto b = 0ul, e = size(); b != e; ++b) {
+            ret[b] = at(i, b);
+        }
+        return ret;
+    }
+
+    template <typename Archive>
+    void serialize(Archive& archive) {
+        archive(data_);
+    }
+
+private:
+    util::aligned::vector<core::bands_type> data_;
+};
+
+template <size_t Az, size_t El>
+void resize_if_necessary(directional_histogram<Az, El>& hist,
+                         size_t new_size) {
+    hist.resize_if_necessary(new_size);
+}
+
 template <size_t Az, size_t El>
 struct directional_energy_histogram final {
     double sample_rate;
-    core::vector_look_up_table<util::aligned::vector<core::bands_type>, Az, El>
-            histogram;
+    directional_histogram<Az, El> histogram;
+
+    template <typename Archive>
+    void serialize(Archive& archive) {
+        archive(sample_rate, histogram);
+    }
 };
 
 template <size_t Az, size_t El>
 void sum_histograms(directional_energy_histogram<Az, El>& a,
                     const directional_energy_histogram<Az, El>& b) {
-    for (auto i = 0; i != Az; ++i) {
-        for (auto j = 0; j != El; ++j) {
-            sum_vectors(a.histogram.table[i][j], b.histogram.table[i][j]);
-        }
+    //  Both histograms share a layout, so b is the same shape as a prefix
+    //  of a.
+    a.histogram.resize_if_necessary(b.histogram.size());
+    auto i = a.histogram.data().data();
+    for (const auto& j : b.histogram.data()) {
+        *i++ += j;
     }
     a.sample_rate = b.sample_rate;
 }
 
 template <size_t Az, size_t El>
-auto max_size(const core::vector_look_up_table<
-              util::aligned::vector<core::bands_type>,
-              Az,
-              El>& hist) {
-    size_t ret = 0;
-
-    for (size_t a = 0; a != Az; ++a) {
-        for (size_t e = 0; e != El; ++e) {
-            ret = std::max(ret, hist.table[a][e].size());
-        }
-    }
-
-    return ret;
+auto max_size(const directional_histogram<Az, El>& hist) {
+    return hist.size();
 }
 
 template <size_t Az, size_t El>
@@ -110,22 +205,40 @@ auto max_time(const directional_energy_histogram<Az, El>& hist) {
     return max_size(hist.histogram) / hist.sample_rate;
 }
 
+/// Sum over all directions, with a per-direction gain.
+/// `factors` must have one entry per direction, in direction order.
+template <size_t Az, size_t El, typename T>
+auto weighted_sum_directional_histogram(
+        const directional_energy_histogram<Az, El>& histogram,
+        const T& factors) {
+    constexpr auto directions = directional_histogram<Az, El>::directions;
+    const auto bins = histogram.histogram.size();
+    util::aligned::vector<core::bands_type> ret(bins);
+    for (auto i = 0ul; i != bins; ++i) {
+        const auto bin = histogram.histogram.bin(i);
+        auto sum = core::bands_type{};
+        for (auto d = 0ul; d != directions; ++d) {
+            sum += bin[d] * factors[d];
+        }
+        ret[i] = sum;
+    }
+    return energy_histogram{histogram.sample_rate, ret};
+}
+
 template <size_t Az, size_t El>
 auto sum_directional_histogram(
         const directional_energy_histogram<Az, El>& histogram) {
-    util::aligned::vector<core::bands_type> ret;
-    for (auto azimuth_index = 0ul; azimuth_index != Az; ++azimuth_index) {
-        for (auto elevation_index = 0ul; elevation_index != El;
-             ++elevation_index) {
-            const auto& segment =
-                    histogram.histogram.table[azimuth_index][elevation_index];
-            ret.resize(std::max(ret.size(), segment.size()));
-            for (auto i = 0ul, end = segment.size(); i != end; ++i) {
-                ret[i] += segment[i];
-            }
+    constexpr auto directions = directional_histogram<Az, El>::directions;
+    const auto bins = histogram.histogram.size();
+    util::aligned::vector<core::bands_type> ret(bins);
+    for (auto i = 0ul; i != bins; ++i) {
+        const auto bin = histogram.histogram.bin(i);
+        auto sum = core::bands_type{};
+        for (auto d = 0ul; d != directions; ++d) {
+            sum += bin[d];
         }
+        ret[i] = sum;
     }
-
     return energy_histogram{histogram.sample_rate, ret};
 }
 
@@ -143,43 +256,82 @@ auto compute_summed_histogram(
     return sum_directional_histogram(histogram);
 }
 
+/// The squared directional response of a receiver, for each direction of a
+/// directional histogram.
+/// Factors have the same type as the attenuation of the method, so they are
+/// per-band for methods such as hrtf.
 template <size_t Az, size_t El, typename Method>
-auto compute_summed_histogram(
-        const directional_energy_histogram<Az, El>& histogram,
-        const Method& method) {
-    using hist = std::decay_t<decltype(histogram.histogram)>;
-
-    util::aligned::vector<core::bands_type> ret;
+auto compute_direction_factors(const Method& method) {
+    using hist = directional_histogram<Az, El>;
+    using attenuation_type = decltype(attenuation(method, glm::vec3{}));
+    using factor_type = decltype(std::declval<attenuation_type>() *
+                                 std::declval<attenuation_type>());
 
+    std::array<factor_type, hist::directions> ret;
     for (auto azimuth_index = 0ul; azimuth_index != Az; ++azimuth_index) {
         for (auto elevation_index = 0ul; elevation_index != El;
              ++elevation_index) {
+            const typename hist::index_pair index{azimuth_index,
+                                                  elevation_index};
+
             //  This is the direction that the histogram segment is pointing,
             //  in world space.
-            const auto pointing = hist::pointing(
-                    typename hist::index_pair{azimuth_index, elevation_index});
+            const auto pointing = hist::pointing(index);
 
             //  This is the attenuation of the receiver in that direction.
             //  We're dealing in energies, so we square the directional
             //  response.
             const auto att = attenuation(method, pointing);
-            const auto factor = att * att;
-
-            const auto& segment =
-                    histogram.histogram.table[azimuth_index][elevation_index];
+            ret[hist::direction(index)] = att * att;
+        }
+    }
+    return ret;
+}
 
-            //  Ensure that the return vector is large enough.
-            ret.resize(std::max(ret.size(), segment.size()));
+template <size_t Az, size_t El, typename Method>
+auto compute_summed_histogram(
+        const directional_energy_histogram<Az, El>& histogram,
+        const Method& method) {
+    return weighted_sum_directional_histogram(
+            histogram, compute_direction_factors<Az, El>(method));
+}
 
-            //  For each histogram bin in this segment, attenuate it
-            //  appropriately and add it to the return vector.
-            for (auto i = 0ul, end = segment.size(); i != end; ++i) {
-                ret[i] += segment[i] * factor;
+/// Attenuate a directional histogram for several receivers at once.
+/// A (receivers x directions) gain matrix is computed once, and then each
+/// time bin of the histogram is multiplied by the matrix in turn.
+/// It is an iterator over attenuation methods.
+/// Returns one energy_histogram per method.
+template <size_t Az, size_t El, typename It>
+auto compute_summed_histograms(
+        const directional_energy_histogram<Az, El>& histogram,
+        It b_methods,
+        It e_methods) {
+    constexpr auto directions = directional_histogram<Az, El>::directions;
+
+    const auto gains =
+            util::map_to_vector(b_methods, e_methods, [](const auto& method) {
+                return compute_direction_factors<Az, El>(method);
+            });
+
+    const auto bins = histogram.histogram.size();
+    util::aligned::vector<energy_histogram> ret(
+            gains.size(),
+            energy_histogram{histogram.sample_rate,
+                             util::aligned::vector<core::bands_type>(bins)});
+
+    for (auto i = 0ul; i != bins; ++i) {
+        const auto bin = histogram.histogram.bin(i);
+        for (auto capsule = 0ul; capsule != gains.size(); ++capsule) {
+            const auto& row = gains[capsule];
+            auto sum = core::bands_type{};
+            for (auto d = 0ul; d != directions; ++d) {
+                sum += bin[d] * row[d];
             }
+            ret[capsule].histogram[i] = sum;
         }
     }
 
-    return energy_histogram{histogram.sample_rate, ret};
+    return ret;
 }
 
 util::aligned::vector<core::bands_type> weight_sequence(
@@ -201,6 +353,44 @@ util::aligned::vector<float> postprocessing(
     return postprocessing(summed, sequence, acoustic_impedance);
 }
 
+/// A Dirac sequence, along with a copy which has been split into frequency
+/// bands, using the same filters as multiband_filter_and_mixdown.
+struct multiband_dirac_sequence final {
+    dirac_sequence sequence;
+    util::aligned::vector<core::bands_type> bands;
+};
+
+/// Uses a single forward transform, and one inverse transform per band.
+multiband_dirac_sequence split_dirac_sequence(const dirac_sequence& sequence);
+
+/// Weight each band of a pre-split Dirac sequence by the envelope given by a
+/// histogram, and mix down.
+/// This filters first and weights second (the order used by schroder2011),
+/// so the same split sequence can be shared between many histograms.
+util::aligned::vector<float> postprocessing(
+        const energy_histogram& histogram,
+        const multiband_dirac_sequence& sequence,
+        double acoustic_impedance);
+
+/// Postprocess a directional histogram for several receivers, sharing the
+/// attenuation, Dirac sequence and band-splitting work between them.
+/// It is an iterator over attenuation methods.
+/// Returns one signal per method.
+template <size_t Az, size_t El, typename It>
+auto postprocessing(const directional_energy_histogram<Az, El>& histogram,
+                    It b_methods,
+                    It e_methods,
+                    const dirac_sequence& sequence,
+                    double acoustic_impedance) {
+    const auto split = split_dirac_sequence(sequence);
+    const auto summed =
+            compute_summed_histograms(histogram, b_methods, e_methods);
+    return util::map_to_vector(
+            begin(summed), end(summed), [&](const auto& i) {
+                return postprocessing(i, split, acoustic_impedance);
+            });
+}
+
 }  // namespace stochastic
 }  // namespace raytracer
 }  // namespace wayverb
@@ -33,6 +33,23 @@ public:
                                            >("init_stochastic_path_info");
     }
 
+    auto get_histogram_extent_kernel() const {
+        return program_wrapper_.get_kernel<cl::Buffer,  // impulses
+                                           cl_float,    // bin scale
+                                           cl::Buffer   // extent
+                                           >("stochastic_histogram_extent");
+    }
+
+    auto get_histogram_kernel() const {
+        return program_wrapper_.get_kernel<cl::Buffer,  // impulses
+                                           cl_float3,   // receiver
+                                           cl_float,    // bin scale
+                                           cl_uint,     // azimuth divisions
+                                           cl_uint,     // elevation divisions
+                                           cl::Buffer   // histogram
+                                           >("stochastic_histogram");
+    }
+
 private:
     core::program_wrapper program_wrapper_;
 };
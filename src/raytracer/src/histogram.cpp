@@ -0,0 +1,49 @@
+#include "raytracer/histogram.h"
+
+#include <cmath>
+
+namespace wayverb {
+namespace raytracer {
+
+sinc_table::sinc_table(size_t width, size_t phases)
+        : width_{width}
+        , phases_{phases} {
+    if (width_ == 0 || width_ % 2) {
+        throw std::runtime_error{"Sinc table width must be even and nonzero."};
+    }
+    if (phases_ == 0) {
+        throw std::runtime_error{"Sinc table must have at least one phase."};
+    }
+
+    const auto taps = get_taps();
+    table_.resize((phases_ + 1) * taps);
+
+    for (auto phase = 0ul; phase != phases_ + 1; ++phase) {
+        const auto fraction = static_cast<double>(phase) / phases_;
+        for (auto tap = 0ul; tap != taps; ++tap) {
+            //  Same expression as in sinc_sum_functor.
+            const auto relative_sample =
+                    (static_cast<double>(tap) - width_ / 2) - fraction;
+            const auto envelope =
+                    0.5 * (1 + std::cos(2 * M_PI * relative_sample / width_));
+            table_[phase * taps + tap] =
+                    envelope * core::sinc(relative_sample);
+        }
+    }
+}
+
+size_t sinc_table::get_width() const { return width_; }
+size_t sinc_table::get_phases() const { return phases_; }
+size_t sinc_table::get_taps() const { return width_ + 1; }
+
+const float* sinc_table::get_kernel(size_t phase) const {
+    return table_.data() + phase * get_taps();
+}
+
+const sinc_table& get_default_sinc_table() {
+    static const sinc_table table{};
+    return table;
+}
+
+}  // namespace raytracer
+}  // namespace wayverb
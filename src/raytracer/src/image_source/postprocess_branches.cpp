@@ -1,12 +1,17 @@
 #include "raytracer/image_source/postprocess_branches.h"
 #include "raytracer/image_source/fast_pressure_calculator.h"
+#include "raytracer/image_source/get_direct.h"
+
+#include "core/pressure_intensity.h"
+
+#include "utilities/trace.h"
 
 namespace wayverb {
 namespace raytracer {
 namespace image_source {
 
 util::aligned::vector<impulse<core::simulation_bands>> postprocess_branches(
-        const multitree<path_element>& tree,
+        const multitree<path_element>::node_type& tree,
         const glm::vec3& source,
         const glm::vec3& receiver,
         const core::voxelised_scene_data<cl_float3,
@@ -28,6 +33,107 @@ util::aligned::vector<impulse<core::simulation_bands>> postprocess_branches(
     return callback.get_output();
 }
 
+namespace {
+
+util::aligned::vector<image_source_path> compute_branch_paths(
+        const multitree<path_element>::node_type& branch,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+                voxelised) {
+    util::aligned::vector<image_source_path> ret;
+    find_valid_paths(branch,
+                     source,
+                     receiver,
+                     voxelised,
+                     [&](const auto& img, auto begin, auto end) {
+                         ret.emplace_back(image_source_path{
+                                 img, {begin, end}});
+                     });
+    return ret;
+}
+
+}  // namespace
+
+util::aligned::vector<image_source_path> compute_image_source_paths(
+        const tree& tree,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+                voxelised) {
+    const util::trace::scope scope{"image-source paths"};
+    const auto branches = tree.get_branches();
+    auto futures = util::map_to_vector(
+            begin(branches), end(branches), [&](const auto& branch) {
+                return std::async(std::launch::async, [&, branch] {
+                    return compute_branch_paths(
+                            branch, source, receiver, voxelised);
+                });
+            });
+
+    util::aligned::vector<image_source_path> ret;
+    for (auto& fut : futures) {
+        auto thread_results = fut.get();
+        ret.insert(ret.end(),
+                   std::make_move_iterator(thread_results.begin()),
+                   std::make_move_iterator(thread_results.end()));
+    }
+
+    //  Add the line-of-sight contribution, which isn't directly detected by
+    //  the image-source machinery.
+    if (get_direct(source, receiver, voxelised)) {
+        ret.emplace_back(image_source_path{source, {}});
+    }
+
+    util::trace::count("image-source paths", "paths", ret.size());
+    return ret;
+}
+
+util::aligned::vector<impulse<core::simulation_bands>>
+compute_image_source_impulses(
+        const util::aligned::vector<image_source_path>& paths,
+        const util::aligned::vector<core::surface<core::simulation_bands>>&
+                surfaces,
+        const glm::vec3& receiver,
+        const core::environment& environment,
+        bool flip_phase) {
+    const util::trace::scope scope{"image-source impulses"};
+    util::trace::count("image-source impulses", "paths", paths.size());
+    const auto calculator = make_fast_pressure_calculator(
+            begin(surfaces), end(surfaces), receiver, flip_phase);
+
+    return util::map_to_vector(
+            begin(paths), end(paths), [&](const auto& path) {
+                auto ret = calculator(path.image_source,
+                                      begin(path.reflections),
+                                      end(path.reflections));
+
+                //  Correct for distance travelled.
+                ret.volume *= core::pressure_for_distance(
+                        ret.distance, environment.acoustic_impedance);
+                return ret;
+            });
+}
+
+util::aligned::vector<impulse<core::simulation_bands>> postprocess_tree(
+        const tree& tree,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::environment& environment,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+                voxelised,
+        bool flip_phase) {
+    return compute_image_source_impulses(
+            compute_image_source_paths(tree, source, receiver, voxelised),
+            voxelised.get_scene_data().get_surfaces(),
+            receiver,
+            environment,
+            flip_phase);
+}
+
 }  // namespace image_source
 }  // namespace raytracer
 }  // namespace wayverb
@@ -3,6 +3,8 @@
 #include "utilities/map_to_vector.h"
 #include "utilities/mapping_iterator_adapter.h"
 
+#include <algorithm>
+#include <array>
 #include <iostream>
 
 namespace wayverb {
@@ -36,15 +38,28 @@ public:
                        const vsd& voxelised,
                        const postprocessor& callback,
                        util::aligned::vector<state>& state,
+                       traversal_statistics& statistics,
+                       bool prune,
                        const path_element& element)
             : source_(source)
             , receiver_(receiver)
             , voxelised_(voxelised)
             , callback_(callback)
-            , state_(state) {
+            , state_(state)
+            , statistics_(statistics)
+            , prune_(prune) {
         //  Find the image source location and intersected triangle.
         state_.emplace_back(
                 path_element_to_state(source_, voxelised_, state_, element));
+        statistics_.visited += 1;
+
+        //  If this triangle can't be reached, then neither this path nor any
+        //  path which starts with it can be valid.
+        if (prune_ && !may_be_reachable(voxelised_, state_)) {
+            statistics_.pruned += 1;
+            descend_ = false;
+            return;
+        }
 
         //  Find whether this is a valid path, and if it is, call the callback.
         if (element.visible) {
@@ -60,8 +75,18 @@ public:
     ~traversal_callback() noexcept { state_.pop_back(); }
 
     traversal_callback operator()(const path_element& p) const {
-        return traversal_callback{
-                source_, receiver_, voxelised_, callback_, state_, p};
+        return traversal_callback{source_,
+                                  receiver_,
+                                  voxelised_,
+                                  callback_,
+                                  state_,
+                                  statistics_,
+                                  prune_,
+                                  p};
+    }
+
+    friend bool should_descend(const traversal_callback& c) {
+        return c.descend_;
     }
 
 private:
@@ -92,6 +117,117 @@ private:
                         p.index)};
     }
 
+    /// Returns false only if the most recent triangle in the path definitely
+    /// can't be part of a valid path.
+    ///
+    /// find_valid_path checks each segment by casting a ray from the
+    /// intersection on the current triangle towards the previous image
+    /// source, and requiring that it hits the previous triangle.
+    /// That can only happen if the current triangle overlaps the beam with
+    /// its apex at the previous image source, passing through the previous
+    /// triangle (the aperture).
+    /// The ray may also pass through the apex before hitting the aperture,
+    /// so the opposing beam behind the apex is considered too.
+    static bool may_be_reachable(const vsd& voxelised,
+                                 const util::aligned::vector<state>& state) {
+        if (state.size() < 2) {
+            return true;
+        }
+
+        const auto& current = state[state.size() - 1];
+        const auto& previous = state[state.size() - 2];
+
+        //  Intersection tests ignore the surface that the ray is leaving, so
+        //  consecutive reflections from the same triangle are never valid.
+        if (current.index == previous.index) {
+            return false;
+        }
+
+        //  Distances below this are treated as inconclusive.
+        constexpr auto epsilon = 1.0e-4f;
+
+        const auto aperture = get_triangle(voxelised, previous.index);
+        const auto target = get_triangle(voxelised, current.index);
+        const auto& apex = previous.image_source;
+
+        //  Plane of the aperture, oriented so that the apex is in front.
+        const auto aperture_cross =
+                glm::cross(aperture.s[1] - aperture.s[0],
+                           aperture.s[2] - aperture.s[0]);
+        const auto aperture_area = glm::length(aperture_cross);
+        if (aperture_area < epsilon * epsilon) {
+            return true;
+        }
+        auto aperture_normal = aperture_cross / aperture_area;
+        auto apex_height = glm::dot(aperture_normal, apex - aperture.s[0]);
+        if (std::abs(apex_height) < epsilon) {
+            return true;
+        }
+        if (apex_height < 0) {
+            aperture_normal = -aperture_normal;
+            apex_height = -apex_height;
+        }
+
+        const auto height = [&](const glm::vec3& v) {
+            return glm::dot(aperture_normal, v - aperture.s[0]);
+        };
+
+        const auto all_of_target = [&](const auto& predicate) {
+            return std::all_of(
+                    std::begin(target.s), std::end(target.s), predicate);
+        };
+
+        //  The beam is bounded by the three planes through the apex and each
+        //  edge of the aperture, with normals pointing inwards.
+        std::array<glm::vec3, 3> side_normals;
+        for (auto i = 0u; i != 3; ++i) {
+            const auto& a = aperture.s[i];
+            const auto& b = aperture.s[(i + 1) % 3];
+            const auto& opposite = aperture.s[(i + 2) % 3];
+            const auto n = glm::normalize(glm::cross(a - apex, b - apex));
+            side_normals[i] = glm::dot(n, opposite - apex) < 0 ? -n : n;
+        }
+
+        const auto misses_forward_beam = [&] {
+            //  Entirely in front of the aperture.
+            if (all_of_target(
+                        [&](const auto& v) { return epsilon < height(v); })) {
+                return true;
+            }
+            //  Entirely outside one of the sides.
+            return std::any_of(side_normals.begin(),
+                               side_normals.end(),
+                               [&](const auto& n) {
+                                   return all_of_target([&](const auto& v) {
+                                       return glm::dot(n, v - apex) < -epsilon;
+                                   });
+                               });
+        }();
+
+        if (!misses_forward_beam) {
+            return true;
+        }
+
+        const auto misses_backward_beam = [&] {
+            //  Entirely closer to the aperture than the apex.
+            if (all_of_target([&](const auto& v) {
+                    return height(v) < apex_height - epsilon;
+                })) {
+                return true;
+            }
+            //  The backward beam is the forward beam mirrored through the apex.
+            return std::any_of(side_normals.begin(),
+                               side_normals.end(),
+                               [&](const auto& n) {
+                                   return all_of_target([&](const auto& v) {
+                                       return epsilon < glm::dot(n, v - apex);
+                                   });
+                               });
+        }();
+
+        return !misses_backward_beam;
+    }
+
     struct valid_path final {
         glm::vec3 image_source;
         util::aligned::vector<reflection_metadata> intersections;
@@ -178,43 +314,42 @@ private:
 
     const postprocessor& callback_;
     util::aligned::vector<state>& state_;
+    traversal_statistics& statistics_;
+    bool prune_;
+    bool descend_{true};
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 
-multitree<path_element>::branches_type construct_image_source_tree(
-        const util::aligned::vector<util::aligned::vector<path_element>>&
-                paths) {
-    multitree<path_element> root{path_element{}};
-    for (const auto& i : paths) {
-        add_path(root, i.begin(), i.end());
-    }
-    return std::move(root.branches);
-}
-
-void tree::push(const util::aligned::vector<path_element>& path) {
-    add_path(root_, path.cbegin(), path.cend());
+multitree<path_element>::branches_type tree::get_branches() const {
+    return root_.get_branches();
 }
 
-const multitree<path_element>::branches_type& tree::get_branches() const {
-    return root_.branches;
-}
-
-void find_valid_paths(
-        const multitree<path_element>& tree,
+traversal_statistics find_valid_paths(
+        const multitree<path_element>::node_type& tree,
         const glm::vec3& source,
         const glm::vec3& receiver,
         const core::voxelised_scene_data<cl_float3,
                                          core::surface<core::simulation_bands>>&
                 voxelised,
-        const postprocessor& callback) {
+        const postprocessor& callback,
+        bool prune) {
     //  set up a state array
     util::aligned::vector<traversal_callback::state> state{};
+    traversal_statistics statistics{};
     //  traverse all paths on this branch
-    traverse_multitree(
-            tree,
-            traversal_callback{
-                    source, receiver, voxelised, callback, state, tree.item});
+    const traversal_callback root{source,
+                                  receiver,
+                                  voxelised,
+                                  callback,
+                                  state,
+                                  statistics,
+                                  prune,
+                                  tree.item};
+    if (should_descend(root)) {
+        traverse_multitree(tree, root);
+    }
+    return statistics;
 }
 
 }  // namespace image_source
@@ -1,17 +1,14 @@
 #include "raytracer/reflection_processor/image_source.h"
-#include "raytracer/image_source/get_direct.h"
 #include "raytracer/image_source/postprocess_branches.h"
 
-#include "core/pressure_intensity.h"
-
 namespace wayverb {
 namespace raytracer {
 namespace reflection_processor {
 
-image_source_group_processor::image_source_group_processor(size_t max_order,
-                                                           size_t items)
+image_source_group_processor::image_source_group_processor(
+        size_t max_order, size_t items, bool use_receiver_visibility)
         : max_image_source_order_{max_order}
-        , builder_{items} {}
+        , builder_{items, use_receiver_visibility} {}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -36,35 +33,65 @@ image_source_group_processor image_source_processor::get_group_processor(
 
 void image_source_processor::accumulate(
         const image_source_group_processor& processor) {
-    for (const auto& path : processor.get_results()) {
-        tree_.push(path);
-    }
+    const auto& paths = processor.get_results();
+    tree_.push(begin(paths), end(paths));
 }
 
 util::aligned::vector<impulse<8>> image_source_processor::get_results() const {
-    //  Fetch the image source results.
-    auto ret = raytracer::image_source::postprocess_branches(
-            begin(tree_.get_branches()),
-            end(tree_.get_branches()),
-            source_,
-            receiver_,
-            voxelised_,
-            false);
-
-    //  Add the line-of-sight contribution, which isn't directly detected by
-    //  the image-source machinery.
-    using namespace image_source;
-    if (const auto direct = get_direct(source_, receiver_, voxelised_)) {
-        ret.emplace_back(*direct);
-    }
-
-    //  Correct for distance travelled.
-    for (auto& imp : ret) {
-        imp.volume *= core::pressure_for_distance(
-                imp.distance, environment_.acoustic_impedance);
-    }
-
-    return ret;
+    return raytracer::image_source::postprocess_tree(
+            tree_, source_, receiver_, environment_, voxelised_, false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+image_source_paths_processor::image_source_paths_processor(
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+                voxelised,
+        size_t max_order)
+        : source_{source}
+        , receiver_{receiver}
+        , voxelised_{voxelised}
+        , max_order_{max_order} {}
+
+image_source_group_processor image_source_paths_processor::get_group_processor(
+        size_t num_directions) const {
+    return {max_order_, num_directions};
+}
+
+void image_source_paths_processor::accumulate(
+        const image_source_group_processor& processor) {
+    const auto& paths = processor.get_results();
+    tree_.push(begin(paths), end(paths));
+}
+
+util::aligned::vector<raytracer::image_source::image_source_path>
+image_source_paths_processor::get_results() const {
+    return raytracer::image_source::compute_image_source_paths(
+            tree_, source_, receiver_, voxelised_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+image_source_tree_processor::image_source_tree_processor(size_t max_order)
+        : max_order_{max_order} {}
+
+image_source_group_processor image_source_tree_processor::get_group_processor(
+        size_t num_directions) const {
+    return {max_order_, num_directions, false};
+}
+
+void image_source_tree_processor::accumulate(
+        const image_source_group_processor& processor) {
+    const auto& paths = processor.get_results();
+    tree_.push(begin(paths), end(paths));
+}
+
+raytracer::image_source::tree image_source_tree_processor::get_results()
+        const {
+    return tree_;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -83,6 +110,38 @@ image_source_processor make_image_source::get_processor(
     return {source, receiver, environment, voxelised, max_order_};
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+make_image_source_paths::make_image_source_paths(size_t max_order)
+        : max_order_{max_order} {}
+
+image_source_paths_processor make_image_source_paths::get_processor(
+        const core::compute_context& /*cc*/,
+        const glm::vec3& source,
+        const glm::vec3& receiver,
+        const core::environment& /*environment*/,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+                voxelised) const {
+    return {source, receiver, voxelised, max_order_};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+make_image_source_tree::make_image_source_tree(size_t max_order)
+        : max_order_{max_order} {}
+
+image_source_tree_processor make_image_source_tree::get_processor(
+        const core::compute_context& /*cc*/,
+        const glm::vec3& /*source*/,
+        const glm::vec3& /*receiver*/,
+        const core::environment& /*environment*/,
+        const core::voxelised_scene_data<cl_float3,
+                                         core::surface<core::simulation_bands>>&
+        /*voxelised*/) const {
+    return image_source_tree_processor{max_order_};
+}
+
 }  // namespace reflection_processor
 }  // namespace raytracer
 }  // namespace wayverb
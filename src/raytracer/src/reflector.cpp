@@ -1,6 +1,7 @@
 #include "raytracer/reflector.h"
 
 #include "core/azimuth_elevation.h"
+#include "core/cl/trace.h"
 #include "core/conversions.h"
 #include "core/spatial_division/scene_buffers.h"
 
@@ -35,17 +36,18 @@ util::aligned::vector<reflection> reflector::run_step(
     cl::copy(queue_, std::begin(rng), std::end(rng), rng_buffer_);
 
     //  get the kernel and run it
-    kernel_(cl::EnqueueArgs(queue_, cl::NDRange(rays_)),
-            ray_buffer_,
-            receiver_,
-            buffers.get_voxel_index_buffer(),
-            buffers.get_global_aabb(),
-            buffers.get_side(),
-            buffers.get_triangles_buffer(),
-            buffers.get_vertices_buffer(),
-            buffers.get_surfaces_buffer(),
-            rng_buffer_,
-            reflection_buffer_);
+    core::trace_kernel("reflections",
+                       kernel_(cl::EnqueueArgs(queue_, cl::NDRange(rays_)),
+                               ray_buffer_,
+                               receiver_,
+                               buffers.get_voxel_index_buffer(),
+                               buffers.get_global_aabb(),
+                               buffers.get_side(),
+                               buffers.get_triangles_buffer(),
+                               buffers.get_vertices_buffer(),
+                               buffers.get_surfaces_buffer(),
+                               rng_buffer_,
+                               reflection_buffer_));
 
     return core::read_from_buffer<reflection>(queue_, reflection_buffer_);
 }
@@ -0,0 +1,103 @@
+#include "raytracer/stochastic/device_histogram.h"
+
+#include <array>
+
+namespace wayverb {
+namespace raytracer {
+namespace stochastic {
+
+device_histogram::device_histogram(const core::compute_context& cc,
+                                   double speed_of_sound,
+                                   double sample_rate,
+                                   size_t azimuth_divisions,
+                                   size_t elevation_divisions)
+        : context_{cc.context}
+        , sample_rate_{sample_rate}
+        , bin_scale_{static_cast<cl_float>(sample_rate / speed_of_sound)}
+        , azimuth_divisions_{azimuth_divisions}
+        , elevation_divisions_{elevation_divisions}
+        , extent_buffer_{core::load_to_buffer(
+                  cc.context, std::array<cl_uint, 1>{{0}}, false)} {
+    if (!azimuth_divisions_ || !elevation_divisions_) {
+        throw std::runtime_error{
+                "Histogram must have at least one division in each axis."};
+    }
+}
+
+void device_histogram::reserve(cl::CommandQueue& queue, size_t bins) {
+    if (bins <= capacity_) {
+        return;
+    }
+
+    const auto new_capacity = std::max(bins, capacity_ * 2);
+
+    //  New storage is zeroed on creation.
+    const util::aligned::vector<core::bands_type> zeros(new_capacity *
+                                                        get_directions());
+    cl::Buffer new_buffer{context_, begin(zeros), end(zeros), false};
+
+    //  The copy is enqueued on the same in-order queue as any outstanding
+    //  accumulation, so it will see all previous writes.
+    if (capacity_) {
+        queue.enqueueCopyBuffer(histogram_buffer_,
+                                new_buffer,
+                                0,
+                                0,
+                                capacity_ * get_directions() *
+                                        sizeof(core::bands_type));
+    }
+
+    histogram_buffer_ = std::move(new_buffer);
+    capacity_ = new_capacity;
+}
+
+util::aligned::vector<core::bands_type> device_histogram::read(
+        cl::CommandQueue& queue) const {
+    util::aligned::vector<core::bands_type> ret(bins_ * get_directions());
+    if (!ret.empty()) {
+        queue.enqueueReadBuffer(histogram_buffer_,
+                                CL_TRUE,
+                                0,
+                                ret.size() * sizeof(core::bands_type),
+                                ret.data());
+    }
+    return ret;
+}
+
+size_t device_histogram::get_bins() const { return bins_; }
+void device_histogram::set_bins(size_t bins) { bins_ = bins; }
+
+size_t device_histogram::get_directions() const {
+    return azimuth_divisions_ * elevation_divisions_;
+}
+
+size_t device_histogram::get_azimuth_divisions() const {
+    return azimuth_divisions_;
+}
+
+size_t device_histogram::get_elevation_divisions() const {
+    return elevation_divisions_;
+}
+
+double device_histogram::get_sample_rate() const { return sample_rate_; }
+
+cl_float device_histogram::get_bin_scale() const { return bin_scale_; }
+
+const cl::Buffer& device_histogram::get_histogram_buffer() const {
+    return histogram_buffer_;
+}
+
+const cl::Buffer& device_histogram::get_extent_buffer() const {
+    return extent_buffer_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void unpack_histogram(const util::aligned::vector<core::bands_type>& flat,
+                      energy_histogram& ret) {
+    ret.histogram = flat;
+}
+
+}  // namespace stochastic
+}  // namespace raytracer
+}  // namespace wayverb
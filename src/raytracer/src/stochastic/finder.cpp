@@ -22,9 +22,26 @@ finder::finder(const core::compute_context& cc,
                const glm::vec3& receiver,
                float receiver_radius,
                float starting_energy)
+        : finder{program{cc},
+                 cc,
+                 group_size,
+                 source,
+                 receiver,
+                 receiver_radius,
+                 starting_energy} {}
+
+finder::finder(const program& prog,
+               const core::compute_context& cc,
+               size_t group_size,
+               const glm::vec3& source,
+               const glm::vec3& receiver,
+               float receiver_radius,
+               float starting_energy)
         : cc_{cc}
-        , queue_{cc.context, cc.device}
-        , kernel_{program{cc}.get_kernel()}
+        , queue_{cc.context, cc.device, core::get_queue_properties()}
+        , kernel_{prog.get_kernel()}
+        , histogram_extent_kernel_{prog.get_histogram_extent_kernel()}
+        , histogram_kernel_{prog.get_histogram_kernel()}
         , receiver_{core::to_cl_float3{}(receiver)}
         , receiver_radius_{receiver_radius}
         , rays_{group_size}
@@ -42,13 +59,51 @@ finder::finder(const core::compute_context& cc,
                   cc.context,
                   CL_MEM_READ_WRITE,
                   sizeof(impulse<core::simulation_bands>) * group_size} {
-    program{cc_}.get_init_stochastic_path_info_kernel()(
+    prog.get_init_stochastic_path_info_kernel()(
             cl::EnqueueArgs{queue_, cl::NDRange{rays_}},
             stochastic_path_buffer_,
             core::make_bands_type(starting_energy),
             core::to_cl_float3{}(source));
 }
 
+void finder::accumulate(device_histogram& histogram,
+                        const cl::Buffer& impulses) {
+    //  Find the last time bin touched so far, so that the histogram storage
+    //  can be grown before anything is written to it.
+    //  This is the only value read back per step.
+    core::trace_kernel(
+            "histogram_extent",
+            histogram_extent_kernel_(
+                    cl::EnqueueArgs(queue_, cl::NDRange(rays_)),
+                    impulses,
+                    histogram.get_bin_scale(),
+                    histogram.get_extent_buffer()));
+
+    const auto extent =
+            core::read_value<cl_uint>(queue_, histogram.get_extent_buffer(), 0);
+    if (!extent) {
+        return;
+    }
+
+    histogram.reserve(queue_, extent);
+    histogram.set_bins(std::max(histogram.get_bins(), size_t{extent}));
+
+    core::trace_kernel(
+            "histogram",
+            histogram_kernel_(cl::EnqueueArgs(queue_, cl::NDRange(rays_)),
+                              impulses,
+                              receiver_,
+                              histogram.get_bin_scale(),
+                              histogram.get_azimuth_divisions(),
+                              histogram.get_elevation_divisions(),
+                              histogram.get_histogram_buffer()));
+}
+
+util::aligned::vector<core::bands_type> finder::read_histogram(
+        const device_histogram& histogram) {
+    return histogram.read(queue_);
+}
+
 }  // namespace stochastic
 }  // namespace raytracer
 }  // namespace wayverb
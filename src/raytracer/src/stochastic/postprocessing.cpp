@@ -4,6 +4,8 @@
 #include "core/mixdown.h"
 #include "core/pressure_intensity.h"
 
+#include "frequency_domain/filter.h"
+
 #include "utilities/for_each.h"
 #include "utilities/map.h"
 
@@ -109,6 +111,75 @@ util::aligned::vector<float> postprocessing(const energy_histogram& histogram,
             });
 }
 
+multiband_dirac_sequence split_dirac_sequence(const dirac_sequence& sequence) {
+    const auto& input = sequence.sequence;
+    util::aligned::vector<core::bands_type> bands(input.size());
+
+    if (!input.empty()) {
+        const auto params = hrtf_data::hrtf_band_params(sequence.sample_rate);
+
+        //  Same padding as multiband_filter.
+        frequency_domain::filter filt{
+                frequency_domain::best_fft_length(input.size()) << 2};
+        filt.store(begin(input), end(input));
+
+        for (auto band = 0ul; band != core::simulation_bands; ++band) {
+            const auto range = util::make_range(params.edges[band + 0],
+                                                params.edges[band + 1]);
+            const auto magnitude = [&](auto freq) {
+                return static_cast<float>(
+                        frequency_domain::compute_bandpass_magnitude(
+                                freq, range, params.width_factor));
+            };
+            filt.run_stored(core::make_cl_type_iterator(begin(bands), band),
+                            [&](auto cplx, auto freq) {
+                                return cplx * magnitude(freq);
+                            });
+        }
+    }
+
+    return {sequence, std::move(bands)};
+}
+
+util::aligned::vector<float> postprocessing(
+        const energy_histogram& histogram,
+        const multiband_dirac_sequence& sequence,
+        double acoustic_impedance) {
+    const auto& dirac = sequence.sequence;
+
+    const auto convert_index = [&](auto ind) -> size_t {
+        return ind * dirac.sample_rate / histogram.sample_rate;
+    };
+
+    util::aligned::vector<float> ret(
+            std::min(sequence.bands.size(),
+                     convert_index(histogram.histogram.size())));
+
+    for (auto i = 0ul, e = histogram.histogram.size(); i != e; ++i) {
+        const auto get_sequence_index = [&](auto ind) {
+            return std::min(convert_index(ind), ret.size());
+        };
+
+        const auto beg = get_sequence_index(i);
+        const auto end = get_sequence_index(i + 1);
+
+        const auto squared_summed = frequency_domain::square_sum(
+                begin(dirac.sequence) + beg, begin(dirac.sequence) + end);
+        const auto scale_factor =
+                squared_summed != 0.0f
+                        ? core::intensity_to_pressure(
+                                  histogram.histogram[i] / squared_summed,
+                                  acoustic_impedance)
+                        : cl_double8{};
+
+        for (auto j = beg; j != end; ++j) {
+            ret[j] = core::sum(sequence.bands[j] * scale_factor);
+        }
+    }
+
+    return ret;
+}
+
 }  // namespace stochastic
 }  // namespace raytracer
 }  // namespace wayverb
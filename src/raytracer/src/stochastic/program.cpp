@@ -151,6 +151,107 @@ kernel void stochastic(const global reflection* reflections,
     }
 }
 
+//  Histogram accumulation  ////////////////////////////////////////////////////
+
+//  OpenCL 1.2 has no floating-point atomics, so we emulate them with a
+//  compare-and-swap loop on the bit pattern.
+void atomic_add_global_float(volatile global float* addr, float value);
+void atomic_add_global_float(volatile global float* addr, float value) {
+    union {
+        uint u;
+        float f;
+    } expected, desired;
+    do {
+        expected.f = *addr;
+        desired.f = expected.f + value;
+    } while (atomic_cmpxchg((volatile global uint*)addr,
+                            expected.u,
+                            desired.u) != expected.u);
+}
+
+//  These functions replicate vector_look_up_table::index.
+
+uint azimuth_to_index(float azimuth, uint divisions);
+uint azimuth_to_index(float azimuth, uint divisions) {
+    const float angle = 360.0f / divisions;
+    azimuth += angle / 2;
+    while (azimuth < 0) {
+        azimuth += 360;
+    }
+    return ((uint)(azimuth / angle)) % divisions;
+}
+
+uint elevation_to_index(float elevation, uint divisions);
+uint elevation_to_index(float elevation, uint divisions) {
+    const float angle = 180.0f / (divisions + 1);
+    elevation += 90 + (angle / 2);
+    while (elevation < 0) {
+        elevation += 360;
+    }
+    const uint adjusted =
+            ((uint)(elevation / angle)) % (2 * (divisions + 1));
+    return clamp(adjusted, (uint)1, divisions) - 1;
+}
+
+uint direction_index(float3 pointing,
+                     uint azimuth_divisions,
+                     uint elevation_divisions);
+uint direction_index(float3 pointing,
+                     uint azimuth_divisions,
+                     uint elevation_divisions) {
+    if (azimuth_divisions * elevation_divisions == 1) {
+        return 0;
+    }
+
+    const float elevation = asin(pointing.y);
+    const float azimuth = M_PI_2_F - fabs(elevation) < 1.0e-6f
+                                  ? 0
+                                  : atan2(pointing.x, -pointing.z);
+
+    return azimuth_to_index(degrees(-azimuth), azimuth_divisions) *
+                   elevation_divisions +
+           elevation_to_index(degrees(elevation), elevation_divisions);
+}
+
+kernel void stochastic_histogram_extent(const global impulse* impulses,
+                                        float bin_scale,
+                                        volatile global uint* extent) {
+    const size_t thread = get_global_id(0);
+    const float impulse_distance = impulses[thread].distance;
+    if (impulse_distance) {
+        atomic_max(extent, (uint)(impulse_distance * bin_scale) + 1);
+    }
+}
+
+kernel void stochastic_histogram(const global impulse* impulses,
+                                 float3 receiver,
+                                 float bin_scale,
+                                 uint azimuth_divisions,
+                                 uint elevation_divisions,
+                                 volatile global float* histogram) {
+    const size_t thread = get_global_id(0);
+    const impulse this_impulse = impulses[thread];
+    if (!this_impulse.distance) {
+        return;
+    }
+
+    const uint bin = (uint)(this_impulse.distance * bin_scale);
+    const uint directions = azimuth_divisions * elevation_divisions;
+    const uint direction =
+            direction_index(normalize(this_impulse.position - receiver),
+                            azimuth_divisions,
+                            elevation_divisions);
+
+    float volume[8];
+    vstore8(this_impulse.volume, 0, volume);
+
+    volatile global float* entry =
+            histogram + (bin * directions + direction) * 8;
+    for (uint band = 0; band != 8; ++band) {
+        atomic_add_global_float(entry + band, volume[band]);
+    }
+}
+
 )";
 
 program::program(const core::compute_context& cc)
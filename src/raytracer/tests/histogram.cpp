@@ -1,7 +1,13 @@
 #include "raytracer/histogram.h"
 
+#include "core/cl/scene_structs.h"
+#include "core/cl/traits.h"
+
 #include "gtest/gtest.h"
 
+#include <chrono>
+#include <random>
+
 using namespace wayverb::raytracer;
 using namespace wayverb::core;
 
@@ -78,4 +84,109 @@ TEST(histogram, sinc) {
         ASSERT_EQ(result.front(), 1.0);
     }
 }
+
+TEST(histogram, sinc_table_single) {
+    constexpr auto sample_rate = 1.0;
+
+    //  Error of linear interpolation between phases is bounded by
+    //  max|f''| / (8 * phases^2).
+    const auto bound = M_PI * M_PI / (24.0 * 256 * 256) + 1.0e-6;
+
+    for (const auto offset : {0.0, 0.00001, 0.25, 0.3, 0.5, 0.999, 0.99999}) {
+        for (const auto start : {0.0, 10.0, 300.0}) {
+            const auto items = {item{1.0, start + offset}};
+            const auto exact = histogram(items.begin(),
+                                         items.end(),
+                                         sample_rate,
+                                         sinc_sum_functor{});
+            const auto table = histogram(items.begin(),
+                                         items.end(),
+                                         sample_rate,
+                                         sinc_table_sum_functor{});
+
+            ASSERT_EQ(exact.size(), table.size());
+            for (auto i = 0ul; i != exact.size(); ++i) {
+                ASSERT_NEAR(exact[i], table[i], bound);
+            }
+        }
+    }
+
+    {
+        const auto items = {item{1.0, 0.0}};
+        const auto result = histogram(items.begin(),
+                                      items.end(),
+                                      sample_rate,
+                                      sinc_table_sum_functor{});
+        ASSERT_EQ(result.size(), 200);
+        ASSERT_EQ(result.front(), 1.0);
+    }
+}
+
+TEST(histogram, sinc_table_many) {
+    constexpr auto sample_rate = 44100.0;
+
+    std::default_random_engine engine{0};
+    std::uniform_real_distribution<double> time_dist{0, 1};
+    std::uniform_real_distribution<double> volume_dist{-1, 1};
+
+    util::aligned::vector<item> items;
+    for (auto i = 0; i != 1000; ++i) {
+        items.emplace_back(item{volume_dist(engine), time_dist(engine)});
+    }
+
+    const auto exact = histogram(
+            items.begin(), items.end(), sample_rate, sinc_sum_functor{});
+    const auto table = histogram(
+            items.begin(), items.end(), sample_rate, sinc_table_sum_functor{});
+
+    //  Each output sample sees at most one kernel per input.
+    const auto bound = items.size() * 1.0e-5;
+
+    ASSERT_EQ(exact.size(), table.size());
+    for (auto i = 0ul; i != exact.size(); ++i) {
+        ASSERT_NEAR(exact[i], table[i], bound);
+    }
+}
+
+struct band_item final {
+    bands_type volume;
+    double time;
+};
+
+TEST(histogram, sinc_table_benchmark) {
+    //  Roughly the number of image-source impulses for a high-order
+    //  simulation of a medium-sized room.
+    constexpr auto sample_rate = 44100.0;
+    constexpr auto impulses = 20000;
+
+    std::default_random_engine engine{0};
+    std::uniform_real_distribution<double> time_dist{0, 2};
+    std::uniform_real_distribution<float> volume_dist{0, 1};
+
+    util::aligned::vector<band_item> items;
+    for (auto i = 0; i != impulses; ++i) {
+        bands_type volume;
+        for (auto& band : volume.s) {
+            band = volume_dist(engine);
+        }
+        items.emplace_back(band_item{volume, time_dist(engine)});
+    }
+
+    const auto time_histogram = [&](const auto& callback) {
+        const auto start = std::chrono::steady_clock::now();
+        auto ret = histogram(items.begin(), items.end(), sample_rate, callback);
+        const std::chrono::duration<double> seconds =
+                std::chrono::steady_clock::now() - start;
+        return std::make_tuple(std::move(ret), seconds.count());
+    };
+
+    const auto exact = time_histogram(sinc_sum_functor{});
+    const auto table = time_histogram(sinc_table_sum_functor{});
+
+    std::cout << "exact: " << std::get<1>(exact)
+              << " s, table: " << std::get<1>(table) << " s\n";
+
+    ASSERT_EQ(std::get<0>(exact).size(), std::get<0>(table).size());
+}
+
 }  // namespace
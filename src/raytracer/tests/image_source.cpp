@@ -3,8 +3,18 @@
 #include "raytracer/image_source/run.h"
 #include "raytracer/raytracer.h"
 
+#include "core/scene_data_loader.h"
+
+#include "utilities/map_to_vector.h"
+
 #include "gtest/gtest.h"
 
+#include <iostream>
+
+#ifndef OBJ_PATH_BEDROOM
+#define OBJ_PATH_BEDROOM ""
+#endif
+
 using namespace wayverb::raytracer;
 using namespace wayverb::core;
 
@@ -111,4 +121,222 @@ void image_source_test() {
 
 TEST(image_source, fast_pressure) { ASSERT_NO_THROW(image_source_test()); }
 
+TEST(image_source, many_receivers) {
+    const geo::box box{glm::vec3{0, 0, 0}, glm::vec3{4, 3, 6}};
+    constexpr auto surface = make_surface<simulation_bands>(0.1f, 0);
+    const auto voxelised = make_voxelised_scene_data(
+            geo::get_scene_data(box, surface), 5, 0.1f);
+    constexpr wayverb::core::environment environment{};
+
+    const glm::vec3 source{1, 1, 1};
+    const util::aligned::vector<glm::vec3> receivers{
+            {2.5, 1.5, 4}, {3, 2, 1}, {0.5, 0.5, 5.5}};
+
+    std::default_random_engine engine{0};
+    const util::aligned::vector<glm::vec3> directions(
+            make_random_direction_generator_iterator(0, engine),
+            make_random_direction_generator_iterator(10000, engine));
+
+    const compute_context cc{};
+
+    const auto shared = image_source::run(begin(directions),
+                                          end(directions),
+                                          cc,
+                                          voxelised,
+                                          source,
+                                          begin(receivers),
+                                          end(receivers),
+                                          environment);
+
+    ASSERT_EQ(shared.size(), receivers.size());
+
+    for (auto i = 0ul; i != receivers.size(); ++i) {
+        const auto individual = image_source::run(begin(directions),
+                                                  end(directions),
+                                                  cc,
+                                                  voxelised,
+                                                  source,
+                                                  receivers[i],
+                                                  environment);
+
+        //  The shared tree ignores receiver visibility during raytracing, so
+        //  it may find more paths, but never fewer.
+        ASSERT_FALSE(individual.empty());
+        ASSERT_LE(individual.size(), shared[i].size());
+        for (const auto& imp : individual) {
+            ASSERT_TRUE(std::any_of(
+                    shared[i].begin(), shared[i].end(), [&](const auto& x) {
+                        return approximately_matches(imp, x);
+                    }));
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Every possible path up to the given depth, all marked visible.
+image_source::tree exhaustive_tree(size_t triangles, size_t depth) {
+    util::aligned::vector<util::aligned::vector<image_source::path_element>>
+            paths{{}};
+    for (auto i = 0ul; i != depth; ++i) {
+        util::aligned::vector<util::aligned::vector<image_source::path_element>>
+                next;
+        next.reserve(paths.size() * triangles);
+        for (const auto& path : paths) {
+            for (cl_uint triangle = 0; triangle != triangles; ++triangle) {
+                next.emplace_back(path);
+                next.back().emplace_back(
+                        image_source::path_element{triangle, true});
+            }
+        }
+        paths = std::move(next);
+    }
+
+    image_source::tree ret;
+    ret.push(paths.begin(), paths.end());
+    return ret;
+}
+
+struct found_path final {
+    glm::vec3 image_source;
+    util::aligned::vector<cl_uint> surfaces;
+};
+
+bool operator<(const found_path& a, const found_path& b) {
+    const auto to_tuple = [](const auto& x) {
+        return std::tie(x.image_source.x,
+                        x.image_source.y,
+                        x.image_source.z,
+                        x.surfaces);
+    };
+    return to_tuple(a) < to_tuple(b);
+}
+
+bool operator==(const found_path& a, const found_path& b) {
+    return a.image_source == b.image_source && a.surfaces == b.surfaces;
+}
+
+template <typename Vsd>
+auto find_paths(const image_source::tree& tree,
+                const glm::vec3& source,
+                const glm::vec3& receiver,
+                const Vsd& voxelised,
+                bool prune) {
+    util::aligned::vector<found_path> paths;
+    image_source::traversal_statistics statistics{};
+
+    for (const auto& branch : tree.get_branches()) {
+        const auto stats = image_source::find_valid_paths(
+                branch,
+                source,
+                receiver,
+                voxelised,
+                [&](const auto& img, auto b, auto e) {
+                    paths.emplace_back(found_path{
+                            img, util::map_to_vector(b, e, [](const auto& i) {
+                                return i.surface_index;
+                            })});
+                },
+                prune);
+        statistics.visited += stats.visited;
+        statistics.pruned += stats.pruned;
+    }
+
+    std::sort(paths.begin(), paths.end());
+    return std::make_tuple(std::move(paths), statistics);
+}
+
+template <typename Vsd>
+void pruning_test(const Vsd& voxelised,
+                  const glm::vec3& source,
+                  const glm::vec3& receiver,
+                  size_t depth) {
+    const auto tree = exhaustive_tree(
+            voxelised.get_scene_data().get_triangles().size(), depth);
+
+    const auto exhaustive =
+            find_paths(tree, source, receiver, voxelised, false);
+    const auto pruned = find_paths(tree, source, receiver, voxelised, true);
+
+    const auto& exhaustive_stats = std::get<1>(exhaustive);
+    const auto& pruned_stats = std::get<1>(pruned);
+
+    std::cout << "visited " << pruned_stats.visited << " of "
+              << exhaustive_stats.visited << " nodes, pruned "
+              << pruned_stats.pruned << " subtrees\n";
+
+    ASSERT_EQ(exhaustive_stats.pruned, 0);
+    ASSERT_NE(pruned_stats.pruned, 0);
+    ASSERT_LT(pruned_stats.visited, exhaustive_stats.visited);
+
+    ASSERT_FALSE(std::get<0>(exhaustive).empty());
+    ASSERT_EQ(std::get<0>(exhaustive), std::get<0>(pruned));
+}
+
+TEST(image_source, pruning_matches_exhaustive_box) {
+    const geo::box box{glm::vec3{0, 0, 0}, glm::vec3{4, 3, 6}};
+    constexpr auto surface = make_surface<simulation_bands>(0.1f, 0);
+    const auto voxelised = make_voxelised_scene_data(
+            geo::get_scene_data(box, surface), 5, 0.1f);
+
+    pruning_test(voxelised, glm::vec3{1, 1, 1}, glm::vec3{2.5, 1.5, 4}, 4);
+}
+
+TEST(image_source, pruning_matches_exhaustive_bedroom) {
+    const auto scene = scene_with_extracted_surfaces(
+            *scene_data_loader{OBJ_PATH_BEDROOM}.get_scene_data(),
+            util::aligned::unordered_map<std::string,
+                                         surface<simulation_bands>>{});
+    const auto voxelised = make_voxelised_scene_data(scene, 5, 0.1f);
+
+    pruning_test(voxelised, glm::vec3{-1, 0.5, 1}, glm::vec3{1, 0, -1.5}, 3);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(image_source, reevaluate_paths_with_new_surfaces) {
+    const geo::box box{glm::vec3{0, 0, 0}, glm::vec3{4, 3, 6}};
+    const auto original = make_voxelised_scene_data(
+            geo::get_scene_data(box, make_surface<simulation_bands>(0.1f, 0)),
+            5,
+            0.1f);
+    const auto edited = make_voxelised_scene_data(
+            geo::get_scene_data(box, make_surface<simulation_bands>(0.4f, 0)),
+            5,
+            0.1f);
+    constexpr wayverb::core::environment environment{};
+
+    const glm::vec3 source{1, 1, 1};
+    const glm::vec3 receiver{2.5, 1.5, 4};
+
+    const auto tree = exhaustive_tree(
+            original.get_scene_data().get_triangles().size(), 3);
+
+    //  Paths are found with the original surfaces...
+    const auto paths = image_source::compute_image_source_paths(
+            tree, source, receiver, original);
+
+    //  ...and evaluated with the edited ones.
+    const auto reevaluated = image_source::compute_image_source_impulses(
+            paths,
+            edited.get_scene_data().get_surfaces(),
+            receiver,
+            environment,
+            false);
+
+    const auto expected = image_source::postprocess_tree(
+            tree, source, receiver, environment, edited, false);
+
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(reevaluated.size(), expected.size());
+    for (auto i = 0ul; i != expected.size(); ++i) {
+        for (auto j = 0ul; j != simulation_bands; ++j) {
+            ASSERT_NEAR(reevaluated[i].volume.s[j],
+                        expected[i].volume.s[j],
+                        1.0e-6);
+        }
+        ASSERT_EQ(reevaluated[i].distance, expected[i].distance);
+    }
+}
+
 }  // namespace
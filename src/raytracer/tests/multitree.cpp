@@ -3,7 +3,9 @@
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <map>
 #include <random>
+#include <vector>
 
 using namespace wayverb::raytracer;
 using namespace wayverb::core;
@@ -21,9 +23,7 @@ TEST(multitree, construct_image_source_tree_small) {
                           image_source::path_element{0, true}}};
 
     image_source::tree ist{};
-    for (const auto& path : paths) {
-        ist.push(path);
-    }
+    ist.push(paths.begin(), paths.end());
     const auto& tree{ist.get_branches()};
 
     ASSERT_EQ(tree.size(), 1);
@@ -53,7 +53,70 @@ TEST(multitree, construct_image_source_tree_large) {
             paths{100000};
     std::generate(paths.begin(), paths.end(), make_path);
     image_source::tree tree{};
-    for (const auto& path : paths) {
-        tree.push(path);
+    tree.push(paths.begin(), paths.end());
+}
+
+TEST(multitree, bulk_matches_reference) {
+    std::default_random_engine engine{std::random_device{}()};
+    std::uniform_int_distribution<cl_uint> index_distribution{0, 5};
+    std::uniform_int_distribution<size_t> length_distribution{0, 6};
+    std::bernoulli_distribution visible_distribution{0.5};
+
+    const auto make_path = [&] {
+        util::aligned::vector<image_source::path_element> ret(
+                length_distribution(engine));
+        std::generate(ret.begin(), ret.end(), [&] {
+            return image_source::path_element{
+                    index_distribution(engine), visible_distribution(engine)};
+        });
+        return ret;
+    };
+
+    //  The reference maps every prefix of every path to the visibility of its
+    //  last element.
+    //  Prefixes are compared by index only, and the first path to add a
+    //  prefix wins, as in the tree.
+    //  A depth-first walk of a trie with sorted children visits nodes in
+    //  lexicographic order, which is also the order of the map.
+    std::map<std::vector<cl_uint>, bool> reference;
+    multitree<image_source::path_element> tree{};
+
+    for (auto segment = 0; segment != 4; ++segment) {
+        util::aligned::vector<
+                util::aligned::vector<image_source::path_element>>
+                paths(200);
+        std::generate(paths.begin(), paths.end(), make_path);
+
+        for (const auto& path : paths) {
+            std::vector<cl_uint> prefix;
+            for (const auto& element : path) {
+                prefix.emplace_back(element.index);
+                reference.emplace(prefix, element.visible);
+            }
+        }
+        tree.insert(paths.begin(), paths.end());
+    }
+
+    ASSERT_EQ(tree.size(), reference.size());
+
+    util::aligned::vector<std::pair<std::vector<cl_uint>, bool>> flattened;
+    struct callback final {
+        decltype(flattened)* output;
+        std::vector<cl_uint> prefix;
+        callback operator()(const image_source::path_element& p) const {
+            auto next = prefix;
+            next.emplace_back(p.index);
+            output->emplace_back(next, p.visible);
+            return {output, std::move(next)};
+        }
+    };
+    traverse_multitree(tree, callback{&flattened, {}});
+
+    ASSERT_EQ(flattened.size(), reference.size());
+    auto it = reference.begin();
+    for (const auto& node : flattened) {
+        ASSERT_EQ(node.first, it->first);
+        ASSERT_EQ(node.second, it->second);
+        ++it;
     }
 }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace util {
+
+/// 64-bit FNV-1a.
+/// Fast and stable across platforms and runs, so suitable for naming and
+/// validating files on disk, but not for anything security-related.
+class fnv1a_hasher final {
+public:
+    void add_bytes(const void* data, size_t bytes) {
+        const auto begin = static_cast<const unsigned char*>(data);
+        for (auto i = begin, end = begin + bytes; i != end; ++i) {
+            state_ = (state_ ^ *i) * 1099511628211ull;
+        }
+    }
+
+    template <typename T>
+    void add(const T& t) {
+        static_assert(std::is_arithmetic<T>::value,
+                      "Only hash types with a well-defined representation.");
+        add_bytes(&t, sizeof(T));
+    }
+
+    std::uint64_t get() const { return state_; }
+
+private:
+    std::uint64_t state_ = 14695981039346656037ull;
+};
+
+}  // namespace util
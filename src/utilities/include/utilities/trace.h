@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// \file trace.h
+/// Optional instrumentation, for finding out where time goes during a
+/// render.
+/// Nothing is recorded until a recorder is installed with `set_recorder`.
+/// Until then, each instrumentation point costs a single atomic load.
+
+namespace util {
+namespace trace {
+
+/// Microseconds since an arbitrary, fixed point in time.
+double now();
+
+struct event final {
+    std::string name;
+    std::string category;
+    double start;     ///< Microseconds, on the same clock as `now`.
+    double duration;  ///< Microseconds.
+    size_t track;     ///< The thread or device the event ran on.
+};
+
+/// Collects events and counts from any number of threads.
+class recorder final {
+public:
+    recorder() = default;
+
+    recorder(const recorder&) = delete;
+    recorder& operator=(const recorder&) = delete;
+
+    void add_event(event e);
+
+    /// Some events, such as device timings, can only be measured once the
+    /// work has finished.
+    /// These callbacks are run when the results are requested.
+    /// The event is discarded if the bool is false.
+    using deferred_event = std::function<std::pair<bool, event>()>;
+    void add_deferred_event(deferred_event callback);
+
+    /// Callbacks may hold on to resources (such as device events), so they
+    /// aren't allowed to pile up during a long render.
+    /// Once twice this many are pending, the oldest half is run by the thread
+    /// which adds the next one.
+    /// By then their work has almost certainly finished, so running them
+    /// shouldn't block.
+    static constexpr size_t deferred_event_batch = 1024;
+
+    /// Adds `value` to the total for `counter`.
+    /// Counts are reported per second of time spent in `phase`.
+    void add_count(const std::string& phase,
+                   const std::string& counter,
+                   double value);
+
+    /// The track for the calling thread.
+    size_t get_thread_track();
+
+    /// A track which isn't a host thread, such as a compute device.
+    size_t get_named_track(const std::string& name);
+
+    /// Writes everything recorded so far in the Chrome trace-event format,
+    /// which can be opened in chrome://tracing or Perfetto.
+    void write_chrome_trace(std::ostream& os);
+
+    /// Writes the total time spent in each phase, and the throughput of each
+    /// counter.
+    void write_summary(std::ostream& os);
+
+private:
+    /// Runs the callbacks, and stores the events they produce.
+    void resolve_deferred(const std::vector<deferred_event>& deferred);
+
+    /// Runs any deferred callbacks, and returns all the events.
+    std::vector<event> resolve_events();
+
+    std::mutex mutex_;
+    std::vector<event> events_;
+    std::vector<deferred_event> deferred_;
+    std::map<std::pair<std::string, std::string>, double> counts_;
+    std::vector<std::string> track_names_;
+    std::unordered_map<std::thread::id, size_t> thread_tracks_;
+};
+
+/// Installs the recorder which will receive all events.
+/// Pass nullptr to stop recording.
+/// The recorder must outlive any work which might record to it.
+void set_recorder(recorder* r);
+
+/// Returns nullptr if nothing is being recorded.
+recorder* get_recorder();
+
+/// Records the time between construction and destruction.
+class scope final {
+public:
+    explicit scope(const char* name, const char* category = "phase");
+    ~scope() noexcept;
+
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+private:
+    recorder* recorder_;
+    const char* name_;
+    const char* category_;
+    double start_;
+};
+
+/// Adds to a counter, if something is being recorded.
+void count(const char* phase, const char* counter, double value);
+
+}  // namespace trace
+}  // namespace util
@@ -0,0 +1,247 @@
+#include "utilities/trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+
+namespace util {
+namespace trace {
+
+namespace {
+
+std::atomic<recorder*> current_recorder{nullptr};
+
+void write_json_string(std::ostream& os, const std::string& str) {
+    os << '"';
+    for (const auto c : str) {
+        switch (c) {
+            case '"': os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n"; break;
+            default: os << c; break;
+        }
+    }
+    os << '"';
+}
+
+}  // namespace
+
+double now() {
+    using namespace std::chrono;
+    static const auto epoch = steady_clock::now();
+    return duration<double, std::micro>(steady_clock::now() - epoch).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void recorder::add_event(event e) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    events_.emplace_back(std::move(e));
+}
+
+constexpr size_t recorder::deferred_event_batch;
+
+void recorder::add_deferred_event(deferred_event callback) {
+    std::vector<deferred_event> oldest;
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        deferred_.emplace_back(std::move(callback));
+        if (deferred_.size() < 2 * deferred_event_batch) {
+            return;
+        }
+        const auto split = deferred_.begin() + deferred_event_batch;
+        oldest.assign(std::make_move_iterator(deferred_.begin()),
+                      std::make_move_iterator(split));
+        deferred_.erase(deferred_.begin(), split);
+    }
+    resolve_deferred(oldest);
+}
+
+void recorder::add_count(const std::string& phase,
+                         const std::string& counter,
+                         double value) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    counts_[std::make_pair(phase, counter)] += value;
+}
+
+size_t recorder::get_thread_track() {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    const auto id = std::this_thread::get_id();
+    const auto it = thread_tracks_.find(id);
+    if (it != thread_tracks_.end()) {
+        return it->second;
+    }
+    const auto track = track_names_.size();
+    track_names_.emplace_back("thread " +
+                              std::to_string(thread_tracks_.size()));
+    thread_tracks_[id] = track;
+    return track;
+}
+
+size_t recorder::get_named_track(const std::string& name) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    const auto it = std::find(track_names_.begin(), track_names_.end(), name);
+    if (it != track_names_.end()) {
+        return std::distance(track_names_.begin(), it);
+    }
+    track_names_.emplace_back(name);
+    return track_names_.size() - 1;
+}
+
+void recorder::resolve_deferred(const std::vector<deferred_event>& deferred) {
+    //  Deferred callbacks may have to wait for work to finish, so run them
+    //  without holding the lock.
+    std::vector<event> resolved;
+    for (const auto& callback : deferred) {
+        auto result = callback();
+        if (result.first) {
+            resolved.emplace_back(std::move(result.second));
+        }
+    }
+
+    const std::lock_guard<std::mutex> lock{mutex_};
+    events_.insert(events_.end(),
+                   std::make_move_iterator(resolved.begin()),
+                   std::make_move_iterator(resolved.end()));
+}
+
+std::vector<event> recorder::resolve_events() {
+    std::vector<deferred_event> deferred;
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        deferred.swap(deferred_);
+    }
+    resolve_deferred(deferred);
+
+    const std::lock_guard<std::mutex> lock{mutex_};
+    std::sort(events_.begin(), events_.end(), [](const auto& a, const auto& b) {
+        return a.start < b.start;
+    });
+    return events_;
+}
+
+void recorder::write_chrome_trace(std::ostream& os) {
+    const auto events = resolve_events();
+
+    std::vector<std::string> track_names;
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        track_names = track_names_;
+    }
+
+    os << "{\"traceEvents\":[";
+    auto first = true;
+    const auto separator = [&] {
+        os << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    for (auto i = 0u; i != track_names.size(); ++i) {
+        separator();
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i
+           << ",\"args\":{\"name\":";
+        write_json_string(os, track_names[i]);
+        os << "}}";
+    }
+
+    os << std::fixed << std::setprecision(3);
+    for (const auto& e : events) {
+        separator();
+        os << "{\"name\":";
+        write_json_string(os, e.name);
+        os << ",\"cat\":";
+        write_json_string(os, e.category);
+        os << ",\"ph\":\"X\",\"ts\":" << e.start << ",\"dur\":" << e.duration
+           << ",\"pid\":0,\"tid\":" << e.track << '}';
+    }
+
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void recorder::write_summary(std::ostream& os) {
+    const auto events = resolve_events();
+
+    struct total final {
+        size_t calls{};
+        double duration{};
+    };
+    std::map<std::pair<std::string, std::string>, total> totals;
+    for (const auto& e : events) {
+        auto& t = totals[std::make_pair(e.category, e.name)];
+        t.calls += 1;
+        t.duration += e.duration;
+    }
+
+    std::map<std::pair<std::string, std::string>, double> counts;
+    {
+        const std::lock_guard<std::mutex> lock{mutex_};
+        counts = counts_;
+    }
+
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+
+    os << std::left << std::setw(12) << "category" << std::setw(32)
+       << "name" << std::right << std::setw(8) << "calls" << std::setw(14)
+       << "total / ms" << '\n';
+    os << std::fixed << std::setprecision(3);
+    for (const auto& t : totals) {
+        os << std::left << std::setw(12) << t.first.first << std::setw(32)
+           << t.first.second << std::right << std::setw(8) << t.second.calls
+           << std::setw(14) << t.second.duration / 1000 << '\n';
+    }
+
+    os << std::scientific << std::setprecision(3);
+    for (const auto& c : counts) {
+        const auto it = totals.find(std::make_pair("phase", c.first.first));
+        os << c.first.first << ": " << c.second << ' ' << c.first.second;
+        if (it != totals.end() && it->second.duration != 0) {
+            os << ", " << c.second / (it->second.duration / 1.0e6) << ' '
+               << c.first.second << "/s";
+        }
+        os << '\n';
+    }
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void set_recorder(recorder* r) { current_recorder = r; }
+
+recorder* get_recorder() {
+    return current_recorder.load(std::memory_order_acquire);
+}
+
+scope::scope(const char* name, const char* category)
+        : recorder_{get_recorder()}
+        , name_{name}
+        , category_{category}
+        , start_{recorder_ ? now() : 0} {}
+
+scope::~scope() noexcept {
+    if (recorder_) {
+        try {
+            recorder_->add_event(event{name_,
+                                       category_,
+                                       start_,
+                                       now() - start_,
+                                       recorder_->get_thread_track()});
+        } catch (...) {
+            //  Losing an event is better than terminating.
+        }
+    }
+}
+
+void count(const char* phase, const char* counter, double value) {
+    if (const auto r = get_recorder()) {
+        r->add_count(phase, counter, value);
+    }
+}
+
+}  // namespace trace
+}  // namespace util
@@ -0,0 +1,157 @@
+#include "utilities/trace.h"
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <thread>
+
+using namespace util::trace;
+
+namespace {
+
+/// Installs a recorder for the duration of a test.
+class installed final {
+public:
+    explicit installed(recorder& r) { set_recorder(&r); }
+    ~installed() noexcept { set_recorder(nullptr); }
+};
+
+size_t count_occurrences(const std::string& str, const std::string& sub) {
+    size_t ret = 0;
+    for (auto pos = str.find(sub); pos != std::string::npos;
+         pos = str.find(sub, pos + sub.size())) {
+        ++ret;
+    }
+    return ret;
+}
+
+}  // namespace
+
+TEST(trace, disabled) {
+    ASSERT_EQ(get_recorder(), nullptr);
+
+    recorder r;
+    {
+        const scope s{"phase"};
+        count("phase", "things", 10);
+    }
+
+    std::stringstream ss;
+    r.write_chrome_trace(ss);
+    ASSERT_EQ(count_occurrences(ss.str(), "\"ph\":\"X\""), 0);
+}
+
+TEST(trace, scopes) {
+    recorder r;
+    {
+        const installed i{r};
+        const scope outer{"outer"};
+        for (auto j = 0; j != 3; ++j) {
+            const scope inner{"inner", "step"};
+        }
+    }
+
+    std::stringstream ss;
+    r.write_chrome_trace(ss);
+    const auto str = ss.str();
+    ASSERT_EQ(str.front(), '{');
+    ASSERT_EQ(count_occurrences(str, "\"ph\":\"X\""), 4);
+    ASSERT_EQ(count_occurrences(str, "\"name\":\"inner\""), 3);
+    ASSERT_EQ(count_occurrences(str, "\"cat\":\"step\""), 3);
+    ASSERT_EQ(count_occurrences(str, "\"ph\":\"M\""), 1);
+    ASSERT_NE(str.find("\"displayTimeUnit\":\"ms\""), std::string::npos);
+}
+
+TEST(trace, tracks) {
+    recorder r;
+    const auto device = r.get_named_track("device");
+    const auto thread = r.get_thread_track();
+    ASSERT_NE(device, thread);
+    ASSERT_EQ(device, r.get_named_track("device"));
+    ASSERT_EQ(thread, r.get_thread_track());
+
+    size_t other{};
+    std::thread{[&] { other = r.get_thread_track(); }}.join();
+    ASSERT_NE(other, thread);
+    ASSERT_NE(other, device);
+}
+
+TEST(trace, deferred) {
+    recorder r;
+    auto calls = 0;
+    r.add_deferred_event([&] {
+        ++calls;
+        return std::make_pair(true, event{"kernel", "kernel", 10, 5, 0});
+    });
+    r.add_deferred_event([&] {
+        ++calls;
+        return std::make_pair(false, event{});
+    });
+
+    std::stringstream ss;
+    r.write_chrome_trace(ss);
+    ASSERT_EQ(calls, 2);
+    ASSERT_EQ(count_occurrences(ss.str(), "\"name\":\"kernel\""), 1);
+
+    //  Deferred events are only resolved once.
+    ss.str("");
+    r.write_chrome_trace(ss);
+    ASSERT_EQ(calls, 2);
+    ASSERT_EQ(count_occurrences(ss.str(), "\"name\":\"kernel\""), 1);
+}
+
+TEST(trace, deferred_batches) {
+    recorder r;
+    size_t calls = 0;
+    const auto add = [&] {
+        r.add_deferred_event([&] {
+            ++calls;
+            return std::make_pair(true, event{"kernel", "kernel", 0, 1, 0});
+        });
+    };
+
+    //  Nothing is run until enough callbacks are pending.
+    for (auto i = 0ul; i != 2 * recorder::deferred_event_batch - 1; ++i) {
+        add();
+    }
+    ASSERT_EQ(calls, 0);
+
+    //  Then only the oldest are run.
+    add();
+    ASSERT_EQ(calls, recorder::deferred_event_batch);
+
+    std::stringstream ss;
+    r.write_chrome_trace(ss);
+    ASSERT_EQ(calls, 2 * recorder::deferred_event_batch);
+    ASSERT_EQ(count_occurrences(ss.str(), "\"name\":\"kernel\""),
+              2 * recorder::deferred_event_batch);
+}
+
+TEST(trace, summary) {
+    recorder r;
+    r.add_event(event{"rays", "phase", 0, 2.0e6, 0});
+    r.add_count("rays", "rays", 1000);
+    r.add_count("rays", "rays", 3000);
+    r.add_count("missing", "things", 1);
+
+    std::stringstream ss;
+    r.write_summary(ss);
+    const auto str = ss.str();
+
+    //  4000 rays in 2 seconds.
+    ASSERT_NE(str.find("2.000e+03 rays/s"), std::string::npos) << str;
+
+    //  Counts with no matching phase are reported without a rate.
+    ASSERT_NE(str.find("missing: 1.000e+00 things\n"), std::string::npos)
+            << str;
+}
+
+TEST(trace, escaping) {
+    recorder r;
+    r.add_event(event{"a \"quoted\\\" name", "phase", 0, 1, 0});
+
+    std::stringstream ss;
+    r.write_chrome_trace(ss);
+    ASSERT_NE(ss.str().find("\"a \\\"quoted\\\\\\\" name\""), std::string::npos)
+            << ss.str();
+}
@@ -10,16 +10,19 @@ namespace wayverb {
 namespace waveguide {
 
 /// For hrtf/microphone attenuators, we can just do this.
+/// The attenuation keeps its sign, so that a microphone's rear lobe is
+/// inverted just like it is for image sources, and so that the result is
+/// linear in the attenuation.
 template <typename Method>
 auto attenuate(const Method& method,
                float Z,
                const postprocessor::directional_receiver::output& i) {
     using std::sqrt;
     using std::copysign;
-    using std::pow;
     const auto att = attenuation(method, -i.intensity);
-    const auto intensity = glm::length(i.intensity) * pow(att, 2.0f);
-    return copysign(sqrt(intensity * Z), i.pressure);  //  scaled method
+    const auto pressure =
+            copysign(sqrt(glm::length(i.intensity) * Z), i.pressure);
+    return att * pressure;  //  scaled method
 }
 
 /// For the null attenuator, we just extract the absolute/omni pressure.
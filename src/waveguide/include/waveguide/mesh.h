@@ -31,6 +31,13 @@ double estimate_volume(const mesh& mesh);
 
 bool is_inside(const mesh& m, size_t node_index);
 
+/// Fit a boundary filter to each surface.
+util::aligned::vector<coefficients_canonical> compute_boundary_coefficients(
+        const util::aligned::vector<core::surface<core::simulation_bands>>&
+                surfaces,
+        float mesh_spacing,
+        float speed_of_sound);
+
 ///  use this if you already have a voxelised scene
 mesh compute_mesh(
         const core::compute_context& cc,
@@ -56,5 +63,16 @@ voxels_and_mesh compute_voxels_and_mesh(
         double sample_rate,
         double speed_of_sound);
 
+/// Replace the surfaces of an existing scene and mesh.
+/// Boundary nodes refer to surfaces by index, so as long as the geometry is
+/// unchanged the mesh structure can be kept, and only the boundary filters
+/// need to be refitted.
+/// Throws if the number of surfaces differs from the existing scene.
+void set_surfaces(
+        voxels_and_mesh& voxels_and_mesh,
+        const util::aligned::vector<core::surface<core::simulation_bands>>&
+                surfaces,
+        double speed_of_sound);
+
 }  // namespace waveguide
 }  // namespace wayverb
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "utilities/aligned/vector.h"
+
+#include <memory>
+
+namespace wayverb {
+namespace waveguide {
+
+enum class resampler_quality { fast, medium, best };
+
+/// Polyphase decomposition of a windowed-sinc lowpass, for converting between
+/// a pair of sample rates.
+/// The rate ratio is approximated by a rational number up / down, and the
+/// kernel is split into `up` phases, each of which is a short FIR filter
+/// applied directly to input samples.
+/// Kernels are immutable once built, so they can be shared between threads.
+class resampling_kernel final {
+public:
+    resampling_kernel(double in_sr, double out_sr, resampler_quality quality);
+
+    /// The interpolation factor, which is also the number of phases.
+    size_t get_up() const;
+    /// The decimation factor.
+    size_t get_down() const;
+
+    /// The number of input samples contributing to each output sample.
+    size_t get_taps() const;
+
+    /// The number of input samples needed on either side of the current
+    /// output position.
+    size_t get_half_width() const;
+
+    /// Taps for a single phase, ordered so that they line up with input
+    /// samples starting `get_half_width()` samples before the current
+    /// position.
+    const float* get_phase(size_t phase) const;
+
+private:
+    size_t up_;
+    size_t down_;
+    size_t half_width_;
+    size_t taps_;
+    util::aligned::vector<float> coefficients_;
+};
+
+/// Find or build the kernel for a particular conversion.
+/// Kernels are cached, so converting many signals between the same rates only
+/// pays for kernel design once.
+std::shared_ptr<const resampling_kernel> get_resampling_kernel(
+        double in_sr, double out_sr, resampler_quality quality);
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Streaming sample-rate converter for interleaved multichannel signals.
+/// Input may be supplied in blocks of any size.
+/// Output is produced as soon as enough input is available, and the filter
+/// history is carried between calls so that block boundaries are seamless.
+/// The output has unity gain for band-limited signals, and is aligned so that
+/// output sample n corresponds to time n / out_sr.
+class resampler final {
+public:
+    resampler(double in_sr,
+              double out_sr,
+              size_t channels = 1,
+              resampler_quality quality = resampler_quality::best);
+
+    size_t get_channels() const;
+
+    /// Push `frames` interleaved frames, and return all the interleaved output
+    /// frames which can now be computed.
+    util::aligned::vector<float> process(const float* input, size_t frames);
+
+    /// Signal the end of the input, and return the remaining output.
+    /// The input is padded with silence, so that the total output is
+    /// ceil(input_frames * up / down) frames.
+    /// The resampler is reset afterwards, ready for a new signal.
+    util::aligned::vector<float> flush();
+
+    /// Clear all history, ready for a new signal.
+    void reset();
+
+private:
+    void produce(util::aligned::vector<float>& output,
+                 size_t available,
+                 size_t limit);
+
+    std::shared_ptr<const resampling_kernel> kernel_;
+    size_t channels_;
+
+    /// Interleaved input, starting at frame `history_begin_` (which is
+    /// negative until enough input has been seen, because the signal is
+    /// preceded by implied silence).
+    util::aligned::vector<float> history_;
+    std::ptrdiff_t history_begin_;
+
+    /// Total number of input frames seen so far.
+    size_t input_frames_;
+
+    /// Index of the next output frame, in terms of the nearest input frame
+    /// below it and the phase (position between input frames, in units of
+    /// 1 / up).
+    size_t next_input_;
+    size_t next_phase_;
+    size_t output_frames_;
+};
+
+/// Convert a whole single-channel signal in one go.
+/// The output has length out_sr / in_sr * size.
+util::aligned::vector<float> resample(
+        const float* data,
+        size_t size,
+        double in_sr,
+        double out_sr,
+        resampler_quality quality = resampler_quality::best);
+
+}  // namespace waveguide
+}  // namespace wayverb
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "waveguide/bandpass_band.h"
+
+#include "core/serialize/range.h"
+#include "core/serialize/vec.h"
+
+#include "cereal/types/vector.hpp"
+
+namespace cereal {
+
+template <typename Archive>
+void serialize(
+        Archive& archive,
+        wayverb::waveguide::postprocessor::directional_receiver::output& m) {
+    archive(make_nvp("intensity", m.intensity),
+            make_nvp("pressure", m.pressure));
+}
+
+template <typename Archive>
+void serialize(Archive& archive, wayverb::waveguide::band& m) {
+    archive(make_nvp("directional", m.directional),
+            make_nvp("sample_rate", m.sample_rate));
+}
+
+template <typename Archive>
+void serialize(Archive& archive, wayverb::waveguide::bandpass_band& m) {
+    archive(make_nvp("band", m.band), make_nvp("valid_hz", m.valid_hz));
+}
+
+}  // namespace cereal
@@ -3,9 +3,12 @@
 #include "waveguide/mesh.h"
 
 #include "core/cl/include.h"
+#include "core/cl/trace.h"
 #include "core/conversions.h"
 #include "core/exceptions.h"
 
+#include "utilities/trace.h"
+
 #include <atomic>
 #include <cassert>
 #include <functional>
@@ -39,11 +42,12 @@ size_t run(const core::compute_context& cc,
            step_preprocessor&& pre,
            step_postprocessor&& post,
            const std::atomic_bool& keep_going) {
+    const util::trace::scope scope{"waveguide"};
 
     const auto num_nodes = mesh.get_structure().get_condensed_nodes().size();
 
     const program program{cc};
-    cl::CommandQueue queue{cc.context, cc.device};
+    cl::CommandQueue queue{cc.context, cc.device, core::get_queue_properties()};
     const auto make_zeroed_buffer = [&] {
         auto ret = cl::Buffer{
                 cc.context, CL_MEM_READ_WRITE, sizeof(cl_float) * num_nodes};
@@ -78,23 +82,24 @@ size_t run(const core::compute_context& cc,
     //  The preprocessor returns 'true' while it should be run.
     //  It also updates the mesh with new pressure values.
     for (; pre(queue, current, step) && keep_going; ++step) {
+        const util::trace::scope step_scope{"waveguide step", "step"};
+
         //  set flag state to successful
         core::write_value(queue, error_flag_buffer, 0, id_success);
 
         //  run kernel
-        kernel(cl::EnqueueArgs(queue,
-                               cl::NDRange(mesh.get_structure()
-                                                   .get_condensed_nodes()
-                                                   .size())),
-               previous,
-               current,
-               node_buffer,
-               mesh.get_descriptor().dimensions,
-               boundary_buffer_1,
-               boundary_buffer_2,
-               boundary_buffer_3,
-               boundary_coefficients_buffer,
-               error_flag_buffer);
+        core::trace_kernel(
+                "waveguide",
+                kernel(cl::EnqueueArgs(queue, cl::NDRange(num_nodes)),
+                       previous,
+                       current,
+                       node_buffer,
+                       mesh.get_descriptor().dimensions,
+                       boundary_buffer_1,
+                       boundary_buffer_2,
+                       boundary_buffer_3,
+                       boundary_coefficients_buffer,
+                       error_flag_buffer));
 
         //  read out flag value
         if (const auto error_flag =
@@ -122,6 +127,9 @@ size_t run(const core::compute_context& cc,
 
         std::swap(previous, current);
     }
+
+    util::trace::count(
+            "waveguide", "node updates", static_cast<double>(num_nodes) * step);
     return step;
 }
 
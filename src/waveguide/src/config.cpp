@@ -1,9 +1,8 @@
 #include "waveguide/config.h"
+#include "waveguide/resampler.h"
 
 #include <cmath>
 
-#include "samplerate.h"
-
 namespace wayverb {
 namespace waveguide {
 namespace config {
@@ -35,16 +34,7 @@ util::aligned::vector<float> adjust_sampling_rate(const float* data,
                 "Sample rate of 0 gives few hints about how to proceed."};
     }
     const auto ratio = out_sr / in_sr;
-    util::aligned::vector<float> out_signal(ratio * size);
-    SRC_DATA sample_rate_info{data,
-                              out_signal.data(),
-                              static_cast<long>(size),
-                              static_cast<long>(out_signal.size()),
-                              0,
-                              0,
-                              0,
-                              ratio};
-    src_simple(&sample_rate_info, SRC_SINC_BEST_QUALITY, 1);
+    auto out_signal = resample(data, size, in_sr, out_sr);
 
     //  Correct output level.
     const auto volume_scale = 1 / ratio;
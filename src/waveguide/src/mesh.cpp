@@ -5,12 +5,14 @@
 #include "waveguide/mesh_setup_program.h"
 #include "waveguide/program.h"
 
+#include "core/cl/trace.h"
 #include "core/conversions.h"
 #include "core/scene_data_loader.h"
 #include "core/spatial_division/scene_buffers.h"
 #include "core/spatial_division/voxelised_scene_data.h"
 
 #include "utilities/popcount.h"
+#include "utilities/trace.h"
 
 #include <iostream>
 
@@ -50,6 +52,21 @@ double estimate_volume(const mesh& mesh) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+util::aligned::vector<coefficients_canonical> compute_boundary_coefficients(
+        const util::aligned::vector<core::surface<core::simulation_bands>>&
+                surfaces,
+        float mesh_spacing,
+        float speed_of_sound) {
+    return util::map_to_vector(
+            begin(surfaces), end(surfaces), [&](const auto& surface) {
+                return to_impedance_coefficients(
+                        compute_reflectance_filter_coefficients(
+                                surface.absorption.s,
+                                1 / config::time_step(speed_of_sound,
+                                                      mesh_spacing)));
+            });
+}
+
 mesh compute_mesh(
         const core::compute_context& cc,
         const core::voxelised_scene_data<cl_float3,
@@ -57,8 +74,10 @@ mesh compute_mesh(
                 voxelised,
         float mesh_spacing,
         float speed_of_sound) {
+    const util::trace::scope scope{"mesh setup"};
     const auto program = setup_program{cc};
-    auto queue = cl::CommandQueue{cc.context, cc.device};
+    auto queue = cl::CommandQueue{
+            cc.context, cc.device, core::get_queue_properties()};
 
     const auto buffers = make_scene_buffers(cc.context, voxelised);
 
@@ -84,14 +103,15 @@ mesh compute_mesh(
         //  find whether each node is inside or outside the model
         {
             auto kernel = program.get_node_inside_kernel();
-            kernel(enqueue(),
-                   node_buffer,
-                   desc,
-                   buffers.get_voxel_index_buffer(),
-                   buffers.get_global_aabb(),
-                   buffers.get_side(),
-                   buffers.get_triangles_buffer(),
-                   buffers.get_vertices_buffer());
+            core::trace_kernel("node_inside",
+                               kernel(enqueue(),
+                                      node_buffer,
+                                      desc,
+                                      buffers.get_voxel_index_buffer(),
+                                      buffers.get_global_aabb(),
+                                      buffers.get_side(),
+                                      buffers.get_triangles_buffer(),
+                                      buffers.get_vertices_buffer()));
         }
 
 #ifndef NDEBUG
@@ -111,7 +131,8 @@ mesh compute_mesh(
         //  find node boundary type
         {
             auto kernel = program.get_node_boundary_kernel();
-            kernel(enqueue(), node_buffer, desc);
+            core::trace_kernel("node_boundary",
+                               kernel(enqueue(), node_buffer, desc));
         }
 
         return core::read_from_buffer<condensed_node>(queue, node_buffer);
@@ -123,19 +144,12 @@ mesh compute_mesh(
     auto boundary_data =
             compute_boundary_index_data(cc.device, buffers, desc, nodes);
 
-    auto v = vectors{
-            std::move(nodes),
-            util::map_to_vector(
-                    begin(voxelised.get_scene_data().get_surfaces()),
-                    end(voxelised.get_scene_data().get_surfaces()),
-                    [&](const auto& surface) {
-                        return to_impedance_coefficients(
-                                compute_reflectance_filter_coefficients(
-                                        surface.absorption.s,
-                                        1 / config::time_step(speed_of_sound,
-                                                              mesh_spacing)));
-                    }),
-            std::move(boundary_data)};
+    auto v = vectors{std::move(nodes),
+                     compute_boundary_coefficients(
+                             voxelised.get_scene_data().get_surfaces(),
+                             mesh_spacing,
+                             speed_of_sound),
+                     std::move(boundary_data)};
 
     return {desc, std::move(v)};
 }
@@ -158,5 +172,24 @@ voxels_and_mesh compute_voxels_and_mesh(const core::compute_context& cc,
     return {std::move(voxelised), std::move(mesh)};
 }
 
+void set_surfaces(
+        voxels_and_mesh& voxels_and_mesh,
+        const util::aligned::vector<core::surface<core::simulation_bands>>&
+                surfaces,
+        double speed_of_sound) {
+    if (surfaces.size() !=
+        voxels_and_mesh.voxels.get_scene_data().get_surfaces().size()) {
+        throw std::runtime_error{
+                "Number of surfaces must match the existing scene."};
+    }
+
+    const auto spacing = voxels_and_mesh.mesh.get_descriptor().spacing;
+    auto coefficients =
+            compute_boundary_coefficients(surfaces, spacing, speed_of_sound);
+
+    voxels_and_mesh.voxels.set_surfaces(begin(surfaces), end(surfaces));
+    voxels_and_mesh.mesh.set_coefficients(std::move(coefficients));
+}
+
 }  // namespace waveguide
 }  // namespace wayverb
@@ -0,0 +1,311 @@
+#include "waveguide/resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+namespace wayverb {
+namespace waveguide {
+
+namespace {
+
+struct kernel_parameters final {
+    double zero_crossings;
+    double kaiser_beta;
+    double bandwidth;  ///< Passband as a proportion of the lower nyquist.
+};
+
+kernel_parameters get_kernel_parameters(resampler_quality quality) {
+    switch (quality) {
+        case resampler_quality::fast: return {8, 6, 0.8};
+        case resampler_quality::medium: return {16, 8, 0.88};
+        case resampler_quality::best: return {32, 10, 0.9};
+    }
+    throw std::runtime_error{"Unrecognised resampler quality."};
+}
+
+/// Limits on the size of the rational approximation.
+/// The number of phases sets the kernel size, so it has to be bounded.
+constexpr size_t max_up = 4096;
+constexpr size_t max_down = 1 << 20;
+
+/// Best rational approximation of x with bounded numerator and denominator,
+/// found from the convergents of its continued fraction.
+std::tuple<size_t, size_t> rational_approximation(double x) {
+    //  p_{n} = a_n * p_{n-1} + p_{n-2}, same for q.
+    size_t p_prev = 1, q_prev = 0;
+    size_t p = static_cast<size_t>(std::floor(x)), q = 1;
+    auto remainder = x - std::floor(x);
+    while (1e-12 < std::abs(x - static_cast<double>(p) / q) &&
+           1e-12 < remainder) {
+        const auto inverse = 1 / remainder;
+        const auto a = std::floor(inverse);
+        const auto p_next = a * p + p_prev;
+        const auto q_next = a * q + q_prev;
+        if (max_up < p_next || max_down < q_next) {
+            break;
+        }
+        p_prev = p;
+        q_prev = q;
+        p = static_cast<size_t>(p_next);
+        q = static_cast<size_t>(q_next);
+        remainder = inverse - a;
+    }
+    if (p == 0) {
+        throw std::runtime_error{"Resampling ratio is too extreme."};
+    }
+    return std::make_tuple(p, q);
+}
+
+/// Zeroth-order modified bessel function of the first kind.
+double bessel_i0(double x) {
+    auto sum = 1.0;
+    auto term = 1.0;
+    const auto half_x_squared = x * x / 4;
+    for (auto k = 1; k != 64; ++k) {
+        term *= half_x_squared / (k * k);
+        sum += term;
+        if (term < sum * 1e-17) {
+            break;
+        }
+    }
+    return sum;
+}
+
+/// Kaiser window, where x is in the range [-1, 1].
+double kaiser(double x, double beta) {
+    return bessel_i0(beta * std::sqrt(1 - x * x)) / bessel_i0(beta);
+}
+
+double sinc(double x) {
+    if (x == 0) {
+        return 1;
+    }
+    const auto px = M_PI * x;
+    return std::sin(px) / px;
+}
+
+/// Split into independent partial sums, so that the compiler is free to
+/// vectorise.
+float dot_product(const float* a, const float* b, size_t size) {
+    float partial[4]{};
+    auto i = 0u;
+    for (; i + 4 <= size; i += 4) {
+        partial[0] += a[i + 0] * b[i + 0];
+        partial[1] += a[i + 1] * b[i + 1];
+        partial[2] += a[i + 2] * b[i + 2];
+        partial[3] += a[i + 3] * b[i + 3];
+    }
+    for (; i != size; ++i) {
+        partial[0] += a[i] * b[i];
+    }
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+}
+
+}  // namespace
+
+resampling_kernel::resampling_kernel(double in_sr,
+                                     double out_sr,
+                                     resampler_quality quality) {
+    if (!(0 < in_sr && 0 < out_sr)) {
+        throw std::runtime_error{
+                "Sample rate of 0 gives few hints about how to proceed."};
+    }
+
+    std::tie(up_, down_) = rational_approximation(out_sr / in_sr);
+
+    const auto params = get_kernel_parameters(quality);
+
+    //  Work in units of upsampled samples.
+    //  The cutoff is at the lower of the two nyquist frequencies.
+    const auto cutoff = params.bandwidth * 0.5 / std::max(up_, down_);
+    const auto window_width = params.zero_crossings / (2 * cutoff);
+
+    half_width_ = static_cast<size_t>(std::ceil(window_width / up_));
+    taps_ = 2 * half_width_ + 1;
+    coefficients_.resize(up_ * taps_);
+
+    for (auto phase = 0u; phase != up_; ++phase) {
+        auto out = coefficients_.data() + phase * taps_;
+        auto sum = 0.0;
+        for (auto i = 0u; i != taps_; ++i) {
+            //  Distance from input sample (position - half_width + i) to the
+            //  output position.
+            const auto distance =
+                    phase + (static_cast<double>(half_width_) - i) * up_;
+            const auto normalised = distance / window_width;
+            const auto value =
+                    std::abs(normalised) < 1
+                            ? sinc(2 * cutoff * distance) *
+                                      kaiser(normalised, params.kaiser_beta)
+                            : 0.0;
+            out[i] = value;
+            sum += value;
+        }
+
+        //  Normalise each phase individually, so that DC passes with exactly
+        //  unity gain whatever the output position.
+        for (auto i = 0u; i != taps_; ++i) {
+            out[i] /= sum;
+        }
+    }
+}
+
+size_t resampling_kernel::get_up() const { return up_; }
+size_t resampling_kernel::get_down() const { return down_; }
+size_t resampling_kernel::get_taps() const { return taps_; }
+size_t resampling_kernel::get_half_width() const { return half_width_; }
+
+const float* resampling_kernel::get_phase(size_t phase) const {
+    return coefficients_.data() + phase * taps_;
+}
+
+std::shared_ptr<const resampling_kernel> get_resampling_kernel(
+        double in_sr, double out_sr, resampler_quality quality) {
+    using key_type = std::tuple<double, double, resampler_quality>;
+    static std::mutex mutex;
+    static std::map<key_type, std::shared_ptr<const resampling_kernel>> cache;
+
+    const auto key = key_type{in_sr, out_sr, quality};
+
+    const std::lock_guard<std::mutex> lock{mutex};
+    auto it = cache.find(key);
+    if (it == cache.end()) {
+        it = cache.emplace(key,
+                           std::make_shared<const resampling_kernel>(
+                                   in_sr, out_sr, quality))
+                     .first;
+    }
+    return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+resampler::resampler(double in_sr,
+                     double out_sr,
+                     size_t channels,
+                     resampler_quality quality)
+        : kernel_{get_resampling_kernel(in_sr, out_sr, quality)}
+        , channels_{channels} {
+    if (!channels_) {
+        throw std::runtime_error{"Resampler must have at least one channel."};
+    }
+    reset();
+}
+
+size_t resampler::get_channels() const { return channels_; }
+
+void resampler::reset() {
+    const auto half_width = kernel_->get_half_width();
+    history_.assign(half_width * channels_, 0.0f);
+    history_begin_ = -static_cast<std::ptrdiff_t>(half_width);
+    input_frames_ = 0;
+    next_input_ = 0;
+    next_phase_ = 0;
+    output_frames_ = 0;
+}
+
+void resampler::produce(util::aligned::vector<float>& output,
+                        size_t available,
+                        size_t limit) {
+    const auto up = kernel_->get_up();
+    const auto down = kernel_->get_down();
+    const auto taps = kernel_->get_taps();
+    const auto half_width = kernel_->get_half_width();
+
+    util::aligned::vector<float> accumulator(channels_);
+
+    while (next_input_ + half_width < available && output_frames_ < limit) {
+        const auto coefficients = kernel_->get_phase(next_phase_);
+        const auto first = static_cast<std::ptrdiff_t>(next_input_) -
+                           static_cast<std::ptrdiff_t>(half_width) -
+                           history_begin_;
+        const auto in = history_.data() + first * channels_;
+
+        if (channels_ == 1) {
+            output.emplace_back(dot_product(coefficients, in, taps));
+        } else {
+            std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+            for (auto i = 0u; i != taps; ++i) {
+                const auto c = coefficients[i];
+                const auto frame = in + i * channels_;
+                for (auto j = 0u; j != channels_; ++j) {
+                    accumulator[j] += c * frame[j];
+                }
+            }
+            output.insert(output.end(), accumulator.begin(), accumulator.end());
+        }
+
+        next_phase_ += down;
+        next_input_ += next_phase_ / up;
+        next_phase_ %= up;
+        ++output_frames_;
+    }
+
+    //  Drop any history which will not be needed again.
+    const auto keep_from = static_cast<std::ptrdiff_t>(next_input_) -
+                           static_cast<std::ptrdiff_t>(half_width);
+    const auto discard = std::min(
+            keep_from - history_begin_,
+            static_cast<std::ptrdiff_t>(history_.size() / channels_));
+    if (0 < discard) {
+        history_.erase(history_.begin(),
+                       history_.begin() + discard * channels_);
+        history_begin_ += discard;
+    }
+}
+
+util::aligned::vector<float> resampler::process(const float* input,
+                                                size_t frames) {
+    history_.insert(history_.end(), input, input + frames * channels_);
+    input_frames_ += frames;
+
+    util::aligned::vector<float> ret;
+    ret.reserve((frames * kernel_->get_up() / kernel_->get_down() + 1) *
+                channels_);
+    produce(ret, input_frames_, std::numeric_limits<size_t>::max());
+    return ret;
+}
+
+util::aligned::vector<float> resampler::flush() {
+    const auto up = kernel_->get_up();
+    const auto down = kernel_->get_down();
+    const auto half_width = kernel_->get_half_width();
+
+    //  Pad with enough silence to compute every remaining output frame.
+    history_.resize(history_.size() + half_width * channels_, 0.0f);
+
+    const auto total = (input_frames_ * up + down - 1) / down;
+
+    util::aligned::vector<float> ret;
+    ret.reserve((total - output_frames_) * channels_);
+    produce(ret, input_frames_ + half_width, total);
+
+    reset();
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+util::aligned::vector<float> resample(const float* data,
+                                      size_t size,
+                                      double in_sr,
+                                      double out_sr,
+                                      resampler_quality quality) {
+    resampler r{in_sr, out_sr, 1, quality};
+    auto ret = r.process(data, size);
+    const auto tail = r.flush();
+    ret.insert(ret.end(), tail.begin(), tail.end());
+
+    //  The rational approximation of the ratio may differ very slightly from
+    //  the true ratio, so fix up the length to match.
+    ret.resize(static_cast<size_t>(out_sr / in_sr * size), 0.0f);
+    return ret;
+}
+
+}  // namespace waveguide
+}  // namespace wayverb
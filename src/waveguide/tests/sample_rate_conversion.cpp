@@ -1,4 +1,5 @@
 #include "waveguide/config.h"
+#include "waveguide/resampler.h"
 
 #include "audio_file/audio_file.h"
 
@@ -6,6 +7,14 @@
 
 #include "gtest/gtest.h"
 
+#include "samplerate.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
 namespace {
 
 template <typename T>
@@ -43,3 +52,176 @@ TEST(sample_rate_conversion, convert) {
 
     scale_and_write(scale, "impulse", output, output_sr);
 }
+
+namespace {
+
+util::aligned::vector<float> reference_adjust_sampling_rate(const float* data,
+                                                           size_t size,
+                                                           double in_sr,
+                                                           double out_sr) {
+    const auto ratio = out_sr / in_sr;
+    util::aligned::vector<float> out_signal(ratio * size);
+    SRC_DATA sample_rate_info{data,
+                              out_signal.data(),
+                              static_cast<long>(size),
+                              static_cast<long>(out_signal.size()),
+                              0,
+                              0,
+                              0,
+                              ratio};
+    src_simple(&sample_rate_info, SRC_SINC_BEST_QUALITY, 1);
+    for (auto& i : out_signal) {
+        i /= ratio;
+    }
+    return out_signal;
+}
+
+/// A couple of sinusoids, comfortably inside the passband of both rates.
+double test_signal(double t, double in_sr, double out_sr) {
+    const auto nyquist = std::min(in_sr, out_sr) / 2;
+    return 0.5 * std::sin(2 * M_PI * 0.2 * nyquist * t) +
+           0.3 * std::cos(2 * M_PI * 0.37 * nyquist * t + 0.3);
+}
+
+util::aligned::vector<float> make_test_signal(size_t size, double sr) {
+    util::aligned::vector<float> ret(size);
+    for (auto i = 0u; i != size; ++i) {
+        ret[i] = test_signal(i / sr, sr, 44100);
+    }
+    return ret;
+}
+
+//  Waveguide sampling rates are computed from the mesh spacing, so they are
+//  rarely round numbers.
+constexpr std::array<double, 4> waveguide_rates{
+        {3333.333333, 8000.0, 10000.0, 11025.0 * 1.3}};
+
+}  // namespace
+
+TEST(sample_rate_conversion, matches_analytic) {
+    constexpr auto out_sr = 44100.0;
+    for (const auto in_sr : waveguide_rates) {
+        const auto input = make_test_signal(in_sr * 2, in_sr);
+        const auto output =
+                wayverb::waveguide::resample(input.data(),
+                                             input.size(),
+                                             in_sr,
+                                             out_sr);
+        ASSERT_EQ(output.size(),
+                  static_cast<size_t>(out_sr / in_sr * input.size()));
+
+        //  Ignore the edges, where the signal is truncated.
+        for (auto i = output.size() / 10; i != output.size() * 9 / 10; ++i) {
+            ASSERT_NEAR(output[i], test_signal(i / out_sr, in_sr, out_sr), 1e-3)
+                    << in_sr;
+        }
+    }
+}
+
+TEST(sample_rate_conversion, matches_libsamplerate) {
+    constexpr auto out_sr = 44100.0;
+    for (const auto in_sr : waveguide_rates) {
+        const auto input = make_test_signal(in_sr, in_sr);
+
+        const auto reference = reference_adjust_sampling_rate(
+                input.data(), input.size(), in_sr, out_sr);
+        const auto output = wayverb::waveguide::adjust_sampling_rate(
+                input.data(), input.size(), in_sr, out_sr);
+        ASSERT_EQ(output.size(), reference.size());
+
+        const auto scale = out_sr / in_sr;
+        for (auto i = output.size() / 10; i != output.size() * 9 / 10; ++i) {
+            ASSERT_NEAR(output[i] * scale, reference[i] * scale, 1e-3)
+                    << in_sr;
+        }
+    }
+}
+
+TEST(sample_rate_conversion, streaming) {
+    constexpr auto in_sr = 10000.0;
+    constexpr auto out_sr = 44100.0;
+    constexpr auto channels = 3;
+
+    const auto input = make_test_signal(in_sr, in_sr);
+    auto block = wayverb::waveguide::resample(
+            input.data(), input.size(), in_sr, out_sr);
+
+    util::aligned::vector<float> interleaved(input.size() * channels);
+    for (auto i = 0u; i != input.size(); ++i) {
+        for (auto j = 0u; j != channels; ++j) {
+            interleaved[i * channels + j] = input[i];
+        }
+    }
+
+    wayverb::waveguide::resampler resampler{in_sr, out_sr, channels};
+
+    std::default_random_engine engine{std::random_device{}()};
+    std::uniform_int_distribution<size_t> dist{1, 1000};
+
+    util::aligned::vector<float> streamed;
+    for (auto frame = 0ul; frame != input.size();) {
+        const auto frames = std::min(dist(engine), input.size() - frame);
+        const auto out =
+                resampler.process(interleaved.data() + frame * channels,
+                                  frames);
+        streamed.insert(streamed.end(), out.begin(), out.end());
+        frame += frames;
+    }
+    const auto tail = resampler.flush();
+    streamed.insert(streamed.end(), tail.begin(), tail.end());
+
+    ASSERT_EQ(streamed.size(), block.size() * channels);
+    for (auto i = 0u; i != block.size(); ++i) {
+        for (auto j = 0u; j != channels; ++j) {
+            ASSERT_NEAR(streamed[i * channels + j], block[i], 1e-6);
+        }
+    }
+}
+
+TEST(sample_rate_conversion, kernel_cache) {
+    const auto a = wayverb::waveguide::get_resampling_kernel(
+            10000, 44100, wayverb::waveguide::resampler_quality::best);
+    const auto b = wayverb::waveguide::get_resampling_kernel(
+            10000, 44100, wayverb::waveguide::resampler_quality::best);
+    const auto c = wayverb::waveguide::get_resampling_kernel(
+            10000, 44100, wayverb::waveguide::resampler_quality::fast);
+
+    ASSERT_EQ(a, b);
+    ASSERT_NE(a, c);
+    ASSERT_EQ(a->get_up(), 441u);
+    ASSERT_EQ(a->get_down(), 100u);
+}
+
+TEST(sample_rate_conversion, benchmark) {
+    constexpr auto out_sr = 44100.0;
+
+    //  A few seconds of output at a typical waveguide rate, which is about as
+    //  long as a waveguide simulation tends to run.
+    for (const auto in_sr : waveguide_rates) {
+        const auto input = make_test_signal(in_sr * 4, in_sr);
+
+        //  Prime the kernel cache.
+        wayverb::waveguide::adjust_sampling_rate(
+                input.data(), input.size(), in_sr, out_sr);
+
+        const auto time = [](auto&& callback) {
+            const auto start = std::chrono::steady_clock::now();
+            callback();
+            return std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                    .count();
+        };
+
+        const auto reference = time([&] {
+            reference_adjust_sampling_rate(
+                    input.data(), input.size(), in_sr, out_sr);
+        });
+        const auto polyphase = time([&] {
+            wayverb::waveguide::adjust_sampling_rate(
+                    input.data(), input.size(), in_sr, out_sr);
+        });
+
+        std::cout << in_sr << " Hz: libsamplerate " << reference
+                  << " s, polyphase " << polyphase << " s\n";
+    }
+}
@@ -7,6 +7,8 @@
 
 #include "core/serialize/surface.h"
 
+#include "frequency_domain/wisdom.h"
+
 #include <fstream>
 #include <memory>
 
@@ -24,6 +26,21 @@ auto get_options() {
     return options;
 }
 
+/// FFT planner wisdom is kept alongside the engine cache, so that plans
+/// measured in one session are reused in the next.
+std::string get_wisdom_path() {
+    const auto directory =
+            File::getSpecialLocation(
+                    File::SpecialLocationType::userApplicationDataDirectory)
+                    .getChildFile("wayverb");
+    if (!directory.createDirectory().wasOk()) {
+        return "";
+    }
+    return directory.getChildFile("fftw.wisdom")
+            .getFullPathName()
+            .toStdString();
+}
+
 class AutoDeleteDocumentWindow : public DocumentWindow {
 public:
     using DocumentWindow::DocumentWindow;
@@ -38,6 +55,7 @@ public:
 
     instance(wayverb_application& owner, const std::string& /*command_line*/)
             : owner_{owner}
+            , wisdom_{get_wisdom_path()}
             , stored_settings_{owner.getApplicationName().toStdString(),
                                get_options()}
             , main_menu_bar_model_{command_manager_, stored_settings_} {
@@ -301,6 +319,10 @@ private:
 
     wayverb_application& owner_;
 
+    //  Declared first among the resources, so that wisdom is saved only
+    //  after every window (and so every engine) has been destroyed.
+    frequency_domain::scoped_wisdom wisdom_;
+
     AngularLookAndFeel look_and_feel_;
     wide_property_component_look_and_feel
             wide_property_component_look_and_feel_;
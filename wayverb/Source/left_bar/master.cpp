@@ -7,8 +7,6 @@
 #include "sources/master.h"
 #include "waveguide/master.h"
 
-#include "core/reverb_time.h"
-
 #include "utilities/string_builder.h"
 
 namespace {
@@ -118,8 +116,7 @@ master::master(main_model& model)
     const auto dim = dimensions(aabb);
     const auto dim_string = util::build_string(dim.x, 'x', dim.y, 'x', dim.z);
 
-    const auto volume = wayverb::core::estimate_room_volume(
-            model_.project.get_scene_data());
+    const auto volume = model_.project.get_geometry().volume;
     const auto volume_string = util::build_string(volume);
 
     property_panel_.addSection(
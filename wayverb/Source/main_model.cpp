@@ -3,6 +3,7 @@
 #include "UtilityComponents/async_work_queue.h"
 
 #include "core/cl/common.h"
+#include "core/scene_simplification.h"
 #include "core/serialize/range.h"
 #include "core/serialize/surface.h"
 
@@ -16,6 +17,8 @@
 project::project(const std::string& fpath)
         : scene_data_{is_project_file(fpath) ? compute_model_path(fpath)
                                              : fpath}
+        , geometry_{wayverb::core::compute_geometry_analytics(
+                  *scene_data_.get_scene_data())}
         , needs_save_{!is_project_file(fpath)} {
     //  First make sure default source and receiver are in a sensible position.
     const auto aabb =
@@ -86,6 +89,10 @@ project::get_scene_data() const {
     return *scene_data_.get_scene_data();
 }
 
+const wayverb::core::geometry_analytics& project::get_geometry() const {
+    return geometry_;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace detail {
@@ -134,7 +141,19 @@ public:
             , encountered_error_connection_{engine_.connect_encountered_error(
                       make_queue_forwarding_call(encountered_error_))}
             , finished_connection_{engine_.connect_finished(
-                      make_queue_forwarding_call(finished_))} {}
+                      make_queue_forwarding_call(finished_))} {
+        //  Old entries are deleted from the cache, so it gets a folder of its
+        //  own rather than sharing the output folder.
+        const auto cache_directory =
+                File::getSpecialLocation(
+                        File::SpecialLocationType::userApplicationDataDirectory)
+                        .getChildFile("wayverb")
+                        .getChildFile("cache");
+        if (cache_directory.createDirectory().wasOk()) {
+            engine_.set_cache_directory(
+                    cache_directory.getFullPathName().toStdString());
+        }
+    }
 
     ~impl() noexcept { cancel_render(); }
 
@@ -195,8 +214,10 @@ private:
             material_map[i->get_name()] = i->get_surface();
         }
 
-        return scene_with_extracted_surfaces(project.get_scene_data(),
-                                             material_map);
+        //  Merging flat regions makes the voxel lists and image-source
+        //  trees smaller.
+        return wayverb::core::simplify_scene(scene_with_extracted_surfaces(
+                project.get_scene_data(), material_map));
     }
 
     async_work_queue queue_;
@@ -7,12 +7,14 @@
 #include "combined/model/scene.h"
 #include "combined/threaded_engine.h"
 
+#include "core/scene_analytics.h"
 #include "core/scene_data_loader.h"
 
 /// All the stuff that goes into a save-file/project.
 /// Projects consist of a (copy of a) 3d model, along with a json save file.
 class project final {
     const wayverb::core::scene_data_loader scene_data_;
+    const wayverb::core::geometry_analytics geometry_;
     bool needs_save_;
 
 public:
@@ -39,6 +41,9 @@ public:
 
     wayverb::core::generic_scene_data<cl_float3, std::string> get_scene_data()
             const;
+
+    /// Areas and volume of the model, found once when it is loaded.
+    const wayverb::core::geometry_analytics& get_geometry() const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -3,8 +3,6 @@
 #include "CommandIDs.h"
 #include "try_and_explain.h"
 
-#include "core/reverb_time.h"
-
 #include "output/master.h"
 
 //  init from as much outside info as possible
@@ -41,9 +39,8 @@ main_window::main_window(ApplicationCommandTarget& next,
     command_manager.registerAllCommandsForTarget(this);
     addKeyListener(command_manager.getKeyMappings());
 
-    const auto volume = wayverb::core::estimate_room_volume(
-            model_.project.get_scene_data());
-    model_.project.persistent.raytracer()->set_room_volume(volume);
+    model_.project.persistent.raytracer()->set_room_volume(
+            model_.project.get_geometry().volume);
 
     model_.reset_view();
     model_.scene.set_visualise(true);